@@ -259,11 +259,19 @@
 
 #ifndef _adevs_h_
 #define _adevs_h_
+#include "adevs/agent_batch.h"
+#include "adevs/cellspace.h"
 #include "adevs/exception.h"
 #include "adevs/models.h"
+#include "adevs/partition.h"
 #include "adevs/simulator.h"
+#include "adevs/topology.h"
+#include "adevs/solvers/colored_jacobian.h"
 #include "adevs/solvers/corrected_euler.h"
+#include "adevs/solvers/dormand_prince.h"
 #include "adevs/solvers/event_locators.h"
 #include "adevs/solvers/hybrid.h"
+#include "adevs/solvers/qss.h"
 #include "adevs/solvers/rk_45.h"
+#include "adevs/solvers/sparsity.h"
 #endif
@@ -0,0 +1,381 @@
+
+/*
+ * Copyright (c) 2025, James Nutaro
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ *
+ * Bugs, comments, and questions can be sent to nutaro@gmail.com
+ */
+#ifndef _adevs_agent_batch_h_
+#define _adevs_agent_batch_h_
+#include <algorithm>
+#include <any>
+#include <list>
+#include <vector>
+#include "adevs/models.h"
+
+namespace adevs {
+
+/**
+ * @brief An Atomic model that contains a large number of similar agents.
+ *
+ * Rather than creating an Atomic model for each agent, the state
+ * of the agents is kept by the derived class in arrays that
+ * have one entry for each agent (i.e., as a structure of arrays). The
+ * AgentBatch keeps the time of the last and next event for every
+ * agent and schedules the agents with its own priority queue. Only the
+ * earliest event in the batch is seen by the Simulator.
+ *
+ * When the time of the next event arrives, every agent with an event at
+ * that time is imminent. The indices of the imminent agents, in increasing
+ * order, are passed to agent_output() and then to agent_internal() or
+ * agent_confluent(). These methods should loop over the indices and update
+ * the arrays, which allows the compiler to vectorize the transitions of
+ * many agents. After the transition, agent_ta() is called for each
+ * imminent agent to get its new time advance.
+ *
+ * Input to the batch is given to agent_external() or agent_confluent(). These
+ * methods must call touch() for each agent whose state they change so
+ * that the agent is rescheduled.
+ *
+ * @tparam ValueType The type of value exchanged with other models.
+ * @tparam TimeType The type used for time.
+ */
+template <typename ValueType = std::any, typename TimeType = double>
+class AgentBatch : public Atomic<ValueType, TimeType> {
+  public:
+    /**
+     * @brief Create a batch of agents.
+     *
+     * The derived class must have storage for the agents before
+     * the simulation starts.
+     * @param agents The number of agents.
+     */
+    AgentBatch(unsigned int agents = 0);
+    virtual ~AgentBatch() {}
+
+    /// @brief The number of agents.
+    unsigned int size() const { return (unsigned int)(tN.size()); }
+    /**
+     * @brief Add agents to the batch.
+     *
+     * The derived class must have storage for the new agents
+     * before this is called. If the simulation has started, the
+     * new agents are scheduled with agent_ta() at the current time.
+     * @param n The number of agents to add.
+     * @return The index of the first new agent.
+     */
+    unsigned int add_agents(unsigned int n);
+    /**
+     * @brief Indicate that an agent changed state in agent_external() or agent_confluent().
+     *
+     * The agent is rescheduled when the transition is finished.
+     */
+    void touch(unsigned int agent) {
+        if (!changed[agent]) {
+            changed[agent] = true;
+            touched.push_back(agent);
+        }
+    }
+    /// @brief The time of the last event in the batch.
+    TimeType get_time() const { return now; }
+    /// @brief Time elapsed since an agent last changed state.
+    TimeType elapsed(unsigned int agent) const { return now - tL[agent]; }
+    /// @brief The time of an agent's next internal event.
+    TimeType next_event(unsigned int agent) const { return tN[agent]; }
+
+    /**
+     * @brief The time advance of an agent.
+     *
+     * This is called after the agent changes state.
+     * @return The time to the agent's next internal event or adevs_inf.
+     */
+    virtual TimeType agent_ta(unsigned int agent) = 0;
+    /**
+     * @brief The output of the imminent agents.
+     *
+     * This must not change the state of the agents. The batch is not
+     * changed either, so get_time() is still the time of the last event
+     * and the time of the output is next_event() of any imminent agent.
+     *
+     * @param imminent The indices of the imminent agents in increasing order.
+     * @param yb A list to be filled with the output of the batch.
+     */
+    virtual void agent_output(std::vector<unsigned int> const &imminent,
+                              std::list<PinValue<ValueType>> &yb) = 0;
+    /**
+     * @brief The internal transition of the imminent agents.
+     *
+     * @param imminent The indices of the imminent agents in increasing order.
+     */
+    virtual void agent_internal(std::vector<unsigned int> const &imminent) = 0;
+    /**
+     * @brief The response of the agents to input.
+     *
+     * Call touch() for each agent whose state changes. The default
+     * implementation ignores input.
+     * @param xb The input to the batch.
+     */
+    virtual void agent_external(std::list<PinValue<ValueType>> const &xb) { (void)xb; }
+    /**
+     * @brief The transition of the agents when input arrives as agents are imminent.
+     *
+     * The default implementation calls agent_internal() and then agent_external().
+     * @param imminent The indices of the imminent agents in increasing order.
+     * @param xb The input to the batch.
+     */
+    virtual void agent_confluent(std::vector<unsigned int> const &imminent,
+                                 std::list<PinValue<ValueType>> const &xb) {
+        agent_internal(imminent);
+        agent_external(xb);
+    }
+
+    /// @brief Calculate the output of the imminent agents.
+    void output_func(std::list<PinValue<ValueType>> &yb);
+    /// @brief Change the state of the imminent agents.
+    void delta_int();
+    /// @brief Change the state of agents in response to input.
+    void delta_ext(TimeType e, std::list<PinValue<ValueType>> const &xb);
+    /// @brief Change the state of the imminent agents and of agents affected by input.
+    void delta_conf(std::list<PinValue<ValueType>> const &xb);
+    /// @brief Time until the next agent is imminent.
+    TimeType ta();
+
+  private:
+    // Event times of each agent
+    std::vector<TimeType> tL, tN;
+    // Binary heap of agent indices ordered by tN starting at position 1 and
+    // the position of each agent in the heap, which is zero if it is not in the heap
+    std::vector<unsigned int> heap, pos;
+    // Agents changed by the current transition
+    std::vector<unsigned int> imminent, touched;
+    // Heap positions left to visit when looking for imminent agents
+    std::vector<unsigned int> search;
+    std::vector<bool> changed;
+    TimeType now;
+    bool initialized;
+
+    void reschedule(unsigned int agent);
+    void sift_up(unsigned int k);
+    void sift_down(unsigned int k);
+    void place(unsigned int k, unsigned int agent) {
+        heap[k] = agent;
+        pos[agent] = k;
+    }
+    void peek_imminent();
+    void find_imminent();
+    void finish();
+};
+
+template <typename ValueType, typename TimeType>
+AgentBatch<ValueType, TimeType>::AgentBatch(unsigned int agents)
+    : Atomic<ValueType, TimeType>(),
+      tL(agents, adevs_zero<TimeType>()),
+      tN(agents, adevs_inf<TimeType>()),
+      heap(1, 0),
+      pos(agents, 0),
+      changed(agents, false),
+      now(adevs_zero<TimeType>()),
+      initialized(false) {}
+
+template <typename ValueType, typename TimeType>
+unsigned int AgentBatch<ValueType, TimeType>::add_agents(unsigned int n) {
+    unsigned int first = size();
+    tL.resize(first + n, now);
+    tN.resize(first + n, adevs_inf<TimeType>());
+    pos.resize(first + n, 0);
+    changed.resize(first + n, false);
+    if (initialized) {
+        for (unsigned int agent = first; agent < first + n; agent++) {
+            reschedule(agent);
+        }
+    }
+    return first;
+}
+
+template <typename ValueType, typename TimeType>
+void AgentBatch<ValueType, TimeType>::sift_up(unsigned int k) {
+    unsigned int agent = heap[k];
+    while (k > 1 && tN[agent] < tN[heap[k / 2]]) {
+        place(k, heap[k / 2]);
+        k /= 2;
+    }
+    place(k, agent);
+}
+
+template <typename ValueType, typename TimeType>
+void AgentBatch<ValueType, TimeType>::sift_down(unsigned int k) {
+    unsigned int agent = heap[k];
+    unsigned int const n = (unsigned int)(heap.size()) - 1;
+    while (2 * k <= n) {
+        unsigned int child = 2 * k;
+        if (child < n && tN[heap[child + 1]] < tN[heap[child]]) {
+            child++;
+        }
+        if (!(tN[heap[child]] < tN[agent])) {
+            break;
+        }
+        place(k, heap[child]);
+        k = child;
+    }
+    place(k, agent);
+}
+
+template <typename ValueType, typename TimeType>
+void AgentBatch<ValueType, TimeType>::reschedule(unsigned int agent) {
+    tL[agent] = now;
+    TimeType dt = agent_ta(agent);
+    TimeType t = (dt < adevs_inf<TimeType>()) ? now + dt : adevs_inf<TimeType>();
+    unsigned int k = pos[agent];
+    bool earlier = t < tN[agent];
+    tN[agent] = t;
+    if (k == 0) {
+        if (t < adevs_inf<TimeType>()) {
+            heap.push_back(agent);
+            sift_up((unsigned int)(heap.size()) - 1);
+        }
+    } else if (!(t < adevs_inf<TimeType>())) {
+        // Remove the agent by moving the last entry into its place
+        pos[agent] = 0;
+        unsigned int last = heap.back();
+        heap.pop_back();
+        if (last != agent) {
+            place(k, last);
+            sift_down(k);
+            sift_up(pos[last]);
+        }
+    } else if (earlier) {
+        sift_up(k);
+    } else {
+        sift_down(k);
+    }
+}
+
+template <typename ValueType, typename TimeType>
+void AgentBatch<ValueType, TimeType>::peek_imminent() {
+    // Visit every agent with the smallest time of next event without
+    // changing the heap. Their heap positions form a subtree at the top.
+    imminent.clear();
+    if (heap.size() < 2) {
+        return;
+    }
+    TimeType t = tN[heap[1]];
+    search.push_back(1);
+    while (!search.empty()) {
+        unsigned int k = search.back();
+        search.pop_back();
+        if (k < heap.size() && tN[heap[k]] == t) {
+            imminent.push_back(heap[k]);
+            search.push_back(2 * k);
+            search.push_back(2 * k + 1);
+        }
+    }
+    std::sort(imminent.begin(), imminent.end());
+}
+
+template <typename ValueType, typename TimeType>
+void AgentBatch<ValueType, TimeType>::find_imminent() {
+    imminent.clear();
+    if (heap.size() < 2) {
+        return;
+    }
+    // Remove every agent with the smallest time of next event
+    TimeType t = tN[heap[1]];
+    while (heap.size() > 1 && tN[heap[1]] == t) {
+        unsigned int agent = heap[1];
+        imminent.push_back(agent);
+        pos[agent] = 0;
+        unsigned int last = heap.back();
+        heap.pop_back();
+        if (heap.size() > 1) {
+            place(1, last);
+            sift_down(1);
+        }
+    }
+    std::sort(imminent.begin(), imminent.end());
+    for (auto agent : imminent) {
+        changed[agent] = true;
+    }
+    now = t;
+}
+
+template <typename ValueType, typename TimeType>
+void AgentBatch<ValueType, TimeType>::finish() {
+    for (auto agent : imminent) {
+        changed[agent] = false;
+        reschedule(agent);
+    }
+    for (auto agent : touched) {
+        changed[agent] = false;
+        reschedule(agent);
+    }
+    imminent.clear();
+    touched.clear();
+}
+
+template <typename ValueType, typename TimeType>
+TimeType AgentBatch<ValueType, TimeType>::ta() {
+    if (!initialized) {
+        initialized = true;
+        for (unsigned int agent = 0; agent < size(); agent++) {
+            reschedule(agent);
+        }
+    }
+    return (heap.size() > 1) ? tN[heap[1]] - now : adevs_inf<TimeType>();
+}
+
+template <typename ValueType, typename TimeType>
+void AgentBatch<ValueType, TimeType>::output_func(std::list<PinValue<ValueType>> &yb) {
+    peek_imminent();
+    agent_output(imminent, yb);
+}
+
+template <typename ValueType, typename TimeType>
+void AgentBatch<ValueType, TimeType>::delta_int() {
+    find_imminent();
+    agent_internal(imminent);
+    finish();
+}
+
+template <typename ValueType, typename TimeType>
+void AgentBatch<ValueType, TimeType>::delta_conf(std::list<PinValue<ValueType>> const &xb) {
+    find_imminent();
+    agent_confluent(imminent, xb);
+    finish();
+}
+
+template <typename ValueType, typename TimeType>
+void AgentBatch<ValueType, TimeType>::delta_ext(TimeType e,
+                                                std::list<PinValue<ValueType>> const &xb) {
+    imminent.clear();
+    now = now + e;
+    agent_external(xb);
+    finish();
+}
+
+}  // namespace adevs
+
+#endif
@@ -0,0 +1,261 @@
+
+/*
+ * Copyright (c) 2025, James Nutaro
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ *
+ * Bugs, comments, and questions can be sent to nutaro@gmail.com
+ */
+#ifndef _adevs_arena_h_
+#define _adevs_arena_h_
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace adevs {
+
+/**
+ * @brief Large blocks of memory that are handed out in pieces and
+ * released all at once.
+ *
+ * This is the storage behind the model_arena and arena_allocator. Memory
+ * is taken from the current block by advancing a pointer. Nothing is
+ * returned until the arena_blocks object is destroyed. It is not safe
+ * to allocate from more than one thread at a time.
+ */
+class arena_blocks {
+  public:
+    /// @brief Create an empty arena that will allocate blocks of the given size.
+    arena_blocks(size_t block_size) : block_size(block_size), next(nullptr), left(0), used(0) {}
+    /// @brief Release every block.
+    ~arena_blocks() {
+        for (auto block : blocks) {
+            ::operator delete(block);
+        }
+    }
+    arena_blocks(arena_blocks const &) = delete;
+    arena_blocks &operator=(arena_blocks const &) = delete;
+    /// @brief Get memory with the given size and alignment.
+    void* allocate(size_t bytes, size_t align) {
+        size_t pad = (align - reinterpret_cast<size_t>(next) % align) % align;
+        if (next == nullptr || pad + bytes > left) {
+            // Large requests get a block of their own so that the
+            // remainder of the current block is not wasted
+            size_t size = std::max(bytes + align, block_size);
+            char* block = static_cast<char*>(::operator new(size));
+            blocks.push_back(block);
+            if (size > block_size) {
+                used += bytes;
+                return block + (align - reinterpret_cast<size_t>(block) % align) % align;
+            }
+            next = block;
+            left = size;
+            pad = (align - reinterpret_cast<size_t>(next) % align) % align;
+        }
+        void* p = next + pad;
+        next += pad + bytes;
+        left -= pad + bytes;
+        used += bytes;
+        return p;
+    }
+    /// @brief The number of bytes that have been allocated.
+    size_t bytes_used() const { return used; }
+    /// @brief The number of blocks that have been obtained from the system.
+    size_t block_count() const { return blocks.size(); }
+
+  private:
+    size_t const block_size;
+    std::vector<char*> blocks;
+    char* next;
+    size_t left, used;
+};
+
+/**
+ * @brief An allocator that takes memory from arena_blocks.
+ *
+ * Deallocation does nothing. The memory is released when the
+ * last allocator using the blocks is destroyed.
+ */
+template <typename T>
+class arena_allocator {
+  public:
+    using value_type = T;
+    /// @brief Allocate from the supplied blocks.
+    arena_allocator(std::shared_ptr<arena_blocks> blocks) noexcept : blocks(std::move(blocks)) {}
+    /// @brief Allocate from the same blocks as another allocator.
+    template <typename U>
+    arena_allocator(arena_allocator<U> const &src) noexcept : blocks(src.blocks) {}
+    T* allocate(size_t n) { return static_cast<T*>(blocks->allocate(n * sizeof(T), alignof(T))); }
+    void deallocate(T*, size_t) noexcept {}
+    template <typename U>
+    bool operator==(arena_allocator<U> const &other) const noexcept {
+        return blocks == other.blocks;
+    }
+    template <typename U>
+    bool operator!=(arena_allocator<U> const &other) const noexcept {
+        return blocks != other.blocks;
+    }
+
+  private:
+    template <typename U>
+    friend class arena_allocator;
+    std::shared_ptr<arena_blocks> blocks;
+};
+
+/**
+ * @brief An arena for constructing models.
+ *
+ * Models made by the arena are placed one after the other in large
+ * blocks of memory, along with the reference counts of the shared pointers
+ * that own them. Models that are made one after another are therefore
+ * next to each other in memory. When a model is destroyed its
+ * destructor is called but its memory is not freed. The blocks are freed
+ * all at once when the arena and every model made by it have been destroyed.
+ * The arena may be destroyed before the models that it made.
+ *
+ * The arena is not thread safe.
+ *
+ * For example
+ * @code
+ * adevs::model_arena arena;
+ * auto graph = std::make_shared<adevs::Graph<int>>();
+ * for (int i = 0; i < n; i++) {
+ *     graph->add_atomic(arena.make<MyModel>(i));
+ * }
+ * @endcode
+ */
+class model_arena {
+  public:
+    /**
+     * @brief Create an arena.
+     *
+     * @param block_size The size in bytes of the blocks obtained from the system.
+     */
+    model_arena(size_t block_size = size_t(1) << 20)
+        : blocks(std::make_shared<arena_blocks>(block_size)) {}
+    /**
+     * @brief Construct an object in the arena.
+     *
+     * @param args The arguments to the constructor of the object.
+     * @return A pointer to the new object.
+     */
+    template <typename T, typename... Args>
+    std::shared_ptr<T> make(Args &&... args) {
+        return std::allocate_shared<T>(arena_allocator<T>(blocks), std::forward<Args>(args)...);
+    }
+    /// @brief Get an allocator for containers whose memory should come from the arena.
+    template <typename T>
+    arena_allocator<T> get_allocator() const {
+        return arena_allocator<T>(blocks);
+    }
+    /// @brief The number of bytes that have been allocated.
+    size_t bytes_used() const { return blocks->bytes_used(); }
+    /// @brief The number of blocks that have been obtained from the system.
+    size_t block_count() const { return blocks->block_count(); }
+
+  private:
+    std::shared_ptr<arena_blocks> blocks;
+};
+
+/**
+ * @brief An allocator that keeps freed objects for reuse.
+ *
+ * This is meant for node based containers, such as std::list and std::set,
+ * that are filled and emptied repeatedly. Single objects that are
+ * deallocated are kept in a cache that belongs to the calling thread
+ * and are handed out again by later allocations of the same type. The
+ * cache is emptied when the thread exits.
+ */
+template <typename T>
+class recycling_allocator {
+  public:
+    using value_type = T;
+    recycling_allocator() noexcept {}
+    template <typename U>
+    recycling_allocator(recycling_allocator<U> const &) noexcept {}
+    T* allocate(size_t n) {
+        if (n == 1 && !destroyed()) {
+            node_cache &c = cache();
+            if (!c.nodes.empty()) {
+                void* p = c.nodes.back();
+                c.nodes.pop_back();
+                return static_cast<T*>(p);
+            }
+        }
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+    void deallocate(T* p, size_t n) noexcept {
+        if (n == 1 && !destroyed()) {
+            node_cache &c = cache();
+            if (c.nodes.size() < max_cached) {
+                try {
+                    c.nodes.push_back(p);
+                    return;
+                } catch (...) {
+                }
+            }
+        }
+        ::operator delete(p);
+    }
+    template <typename U>
+    bool operator==(recycling_allocator<U> const &) const noexcept {
+        return true;
+    }
+    template <typename U>
+    bool operator!=(recycling_allocator<U> const &) const noexcept {
+        return false;
+    }
+
+  private:
+    static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__,
+                  "recycling_allocator does not support over-aligned types");
+    static constexpr size_t max_cached = 4096;
+    struct node_cache {
+        std::vector<void*> nodes;
+        ~node_cache() {
+            for (auto p : nodes) {
+                ::operator delete(p);
+            }
+            destroyed() = true;
+        }
+    };
+    static node_cache &cache() {
+        static thread_local node_cache c;
+        return c;
+    }
+    // Containers used after the cache is destroyed get their memory from the system
+    static bool &destroyed() {
+        static thread_local bool d = false;
+        return d;
+    }
+};
+
+}  // namespace adevs
+
+#endif
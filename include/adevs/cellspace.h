@@ -0,0 +1,948 @@
+
+/*
+ * Copyright (c) 2025, James Nutaro
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ *
+ * Bugs, comments, and questions can be sent to nutaro@gmail.com
+ */
+#ifndef _adevs_cellspace_h_
+#define _adevs_cellspace_h_
+#include <algorithm>
+#include <any>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "adevs/exception.h"
+#include "adevs/models.h"
+
+namespace adevs {
+
+/**
+ * @brief A priority queue for integer times with one bucket per time.
+ *
+ * Times within a window that starts at the current time are kept
+ * in a ring of buckets. Times beyond the window are kept in a heap
+ * and are moved into the ring as the window advances. The queue
+ * holds cell indices and uses the array of next event times that it is
+ * given to recognize entries that have been superseded by a later
+ * insertion. Old entries are discarded when they are found.
+ *
+ * @tparam TimeType An integral type for time.
+ */
+template <typename TimeType = int>
+class bucket_queue {
+  public:
+    /**
+     * @brief Create an empty queue.
+     *
+     * @param tN The time of next event of each item in the queue.
+     * @param log2_buckets The window is 2 raised to this number.
+     */
+    bucket_queue(std::vector<TimeType> const &tN, unsigned int log2_buckets = 8)
+        : tN(tN), ring(size_t(1) << log2_buckets), mask((size_t(1) << log2_buckets) - 1),
+          base(adevs_zero<TimeType>()) {}
+    /// @brief Put an item into the queue at time t, which must not be less than the current time.
+    void insert(unsigned int item, TimeType t) {
+        if (t - base < TimeType(ring.size())) {
+            ring[size_t(t) & mask].push_back(item);
+        } else {
+            overflow.push_back(std::make_pair(t, item));
+            std::push_heap(overflow.begin(), overflow.end(), std::greater<entry_t>());
+        }
+    }
+    /**
+     * @brief Advance the window to start at time now.
+     *
+     * No item may have a time of next event that is less than now.
+     */
+    void advance(TimeType now) {
+        base = now;
+        while (!overflow.empty() && overflow.front().first - base < TimeType(ring.size())) {
+            auto e = overflow.front();
+            std::pop_heap(overflow.begin(), overflow.end(), std::greater<entry_t>());
+            overflow.pop_back();
+            if (tN[e.second] == e.first) {
+                ring[size_t(e.first) & mask].push_back(e.second);
+            }
+        }
+    }
+    /// @brief Get the smallest time in the queue or adevs_inf if it is empty.
+    TimeType min_time() {
+        for (size_t k = 0; k < ring.size(); k++) {
+            TimeType t = base + TimeType(k);
+            std::vector<unsigned int> &bucket = ring[size_t(t) & mask];
+            // Discard entries that were superseded
+            size_t n = 0;
+            for (auto item : bucket) {
+                if (tN[item] == t) {
+                    bucket[n++] = item;
+                }
+            }
+            bucket.resize(n);
+            if (n > 0) {
+                return t;
+            }
+        }
+        while (!overflow.empty() && tN[overflow.front().second] != overflow.front().first) {
+            std::pop_heap(overflow.begin(), overflow.end(), std::greater<entry_t>());
+            overflow.pop_back();
+        }
+        return (overflow.empty()) ? adevs_inf<TimeType>() : overflow.front().first;
+    }
+    /**
+     * @brief Append the items at time t to a list without removing them.
+     *
+     * Unlike pop(), this does not require the window to be at t.
+     */
+    void peek(TimeType t, std::vector<unsigned int> &items) const {
+        if (t - base < TimeType(ring.size())) {
+            for (auto item : ring[size_t(t) & mask]) {
+                if (tN[item] == t) {
+                    items.push_back(item);
+                }
+            }
+        } else {
+            for (auto const &e : overflow) {
+                if (e.first == t && tN[e.second] == t) {
+                    items.push_back(e.second);
+                }
+            }
+        }
+    }
+    /**
+     * @brief Remove the items at time t and append them to a list.
+     *
+     * The window must have been advanced to t. An item must not be inserted
+     * again at a time for which it is already in the queue, or it will
+     * appear more than once.
+     */
+    void pop(TimeType t, std::vector<unsigned int> &items) {
+        std::vector<unsigned int> &bucket = ring[size_t(t) & mask];
+        for (auto item : bucket) {
+            if (tN[item] == t) {
+                items.push_back(item);
+            }
+        }
+        bucket.clear();
+    }
+
+  private:
+    using entry_t = std::pair<TimeType, unsigned int>;
+    std::vector<TimeType> const &tN;
+    std::vector<std::vector<unsigned int>> ring;
+    size_t const mask;
+    TimeType base;
+    // A heap with the earliest time at the front
+    std::vector<entry_t> overflow;
+};
+
+/**
+ * @brief A pool of threads that applies a function to a list of items.
+ *
+ * The items are dealt out to a queue for each thread. A thread
+ * takes items from the front of its own queue and, when its queue is
+ * empty, steals items from the back of the other queues. The thread
+ * that calls run() works along with the pool.
+ */
+class work_pool {
+  public:
+    /**
+     * @brief Start the threads.
+     *
+     * @param threads The number of threads including the one that calls run().
+     */
+    work_pool(unsigned int threads) : job(nullptr), generation(0), finished(0), stop(false) {
+        for (unsigned int i = 0; i < std::max(threads, 1u); i++) {
+            queues.emplace_back(new work_queue());
+        }
+        for (unsigned int i = 1; i < threads; i++) {
+            workers.emplace_back(&work_pool::worker, this, i);
+        }
+    }
+    /// @brief Stop and join the threads.
+    ~work_pool() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stop = true;
+        }
+        start.notify_all();
+        for (auto &t : workers) {
+            t.join();
+        }
+    }
+    /**
+     * @brief Call f for each item and return when every call is finished.
+     *
+     * If a call throws an exception then it is rethrown here
+     * after the other items are finished.
+     */
+    void run(std::vector<unsigned int> const &items, std::function<void(unsigned int)> const &f) {
+        if (workers.empty() || items.size() < 2) {
+            for (auto item : items) {
+                f(item);
+            }
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            for (size_t i = 0; i < items.size(); i++) {
+                queues[i % queues.size()]->items.push_back(items[i]);
+            }
+            job = &f;
+            error = nullptr;
+            finished = 0;
+            generation++;
+        }
+        start.notify_all();
+        work(0);
+        std::unique_lock<std::mutex> guard(lock);
+        done.wait(guard, [this] { return finished == workers.size(); });
+        job = nullptr;
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+  private:
+    struct work_queue {
+        std::mutex lock;
+        std::deque<unsigned int> items;
+    };
+    std::vector<std::unique_ptr<work_queue>> queues;
+    std::vector<std::thread> workers;
+    std::function<void(unsigned int)> const* job;
+    std::exception_ptr error;
+    std::mutex lock;
+    std::condition_variable start, done;
+    unsigned int generation;
+    size_t finished;
+    bool stop;
+
+    bool take(unsigned int id, unsigned int &item) {
+        for (size_t k = 0; k < queues.size(); k++) {
+            work_queue &q = *queues[(id + k) % queues.size()];
+            std::lock_guard<std::mutex> guard(q.lock);
+            if (!q.items.empty()) {
+                if (k == 0) {
+                    item = q.items.front();
+                    q.items.pop_front();
+                } else {
+                    item = q.items.back();
+                    q.items.pop_back();
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+    void work(unsigned int id) {
+        unsigned int item;
+        while (take(id, item)) {
+            try {
+                (*job)(item);
+            } catch (...) {
+                std::lock_guard<std::mutex> guard(lock);
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+        }
+    }
+    void worker(unsigned int id) {
+        unsigned int seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                start.wait(guard, [&] { return stop || generation != seen; });
+                if (stop) {
+                    return;
+                }
+                seen = generation;
+            }
+            work(id);
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                finished++;
+            }
+            done.notify_one();
+        }
+    }
+};
+
+/**
+ * @brief An Atomic model that contains a two dimensional grid of cells.
+ *
+ * The CellSpace is intended for cellular automata with many
+ * cells. Rather than using an Atomic model and Graph connections
+ * for each cell, the states of the cells are kept in a dense array
+ * and the neighbors of each cell are given by a stencil of offsets
+ * that is the same for every cell. When a cell produces output, its
+ * output is delivered to every cell that has the sending cell
+ * in its neighborhood. Each cell has a time of next event and
+ * the cells are scheduled with a bucket_queue, and so time must
+ * be an integer.
+ *
+ * The behavior of the cells is defined by overriding the
+ * cell_ta(), cell_output(), and cell_delta() methods. These
+ * play the same roles for a cell as the Atomic::ta(),
+ * Atomic::output_func(), and Atomic::delta_int(), Atomic::delta_ext(),
+ * and Atomic::delta_conf() methods. A cell must change only its own state
+ * in these methods.
+ *
+ * The CellSpace is itself an Atomic model and is connected to other
+ * models in a Graph through pins that belong to individual cells.
+ * Input arriving on a pin obtained from input_pin() is delivered to
+ * its cell, and the output of a cell with a pin obtained from
+ * output_pin() is passed to boundary_output() to be placed on that pin.
+ *
+ * The space can be divided into square tiles that are processed by a
+ * pool of threads; see set_threads(). Each tile has its own schedule.
+ * At each time step the output of the imminent cells is calculated by
+ * output_func() without changing the space, and the messages are sent
+ * and the cells change state in delta_int() or delta_conf(). In each of
+ * these phases the tiles with work to do are handed to the threads.
+ * Messages that cross from one tile to another are collected by the
+ * sending tile and delivered between these two phases. Because a cell changes
+ * only its own state, the result does not depend on the number of threads
+ * or the size of the tiles. When more than one thread is used the
+ * cell methods are called concurrently for cells in different tiles.
+ *
+ * @tparam CellState The state of a cell. This is also the type of the
+ * messages exchanged by cells.
+ * @tparam ValueType The type of value exchanged with other models.
+ * @tparam TimeType An integral type for time.
+ */
+template <typename CellState, typename ValueType = std::any, typename TimeType = int>
+class CellSpace : public Atomic<ValueType, TimeType> {
+    static_assert(std::is_integral<TimeType>::value, "CellSpace requires an integer TimeType");
+
+  public:
+    /**
+     * @brief The events that cause a cell to change state.
+     *
+     * This is passed to cell_delta() and describes the input to the
+     * cell and whether its internal event is due.
+     */
+    class CellEvent {
+      public:
+        /// @brief The column of the cell.
+        unsigned int x;
+        /// @brief The row of the cell.
+        unsigned int y;
+        /// @brief Time elapsed since the cell last changed state.
+        TimeType elapsed;
+        /// @brief True if the cell's time advance has expired.
+        bool imminent;
+        /// @brief True if the neighbor at position k of the stencil sent a message.
+        bool received(unsigned int k) const { return (mail >> k) & 1; }
+        /// @brief True if any neighbor sent a message.
+        bool received() const { return mail != 0; }
+        /// @brief The message from the neighbor at position k of the stencil.
+        CellState const &message(unsigned int k) const {
+            return space->outbox[space->neighbor(cell, k)];
+        }
+        /// @brief Input that arrived on the cell's input pins.
+        std::list<ValueType> const &input() const { return *inputs; }
+
+      private:
+        friend class CellSpace<CellState, ValueType, TimeType>;
+        CellSpace<CellState, ValueType, TimeType> const* space;
+        unsigned int cell;
+        uint32_t mail;
+        std::list<ValueType> const* inputs;
+    };
+
+    /**
+     * @brief Create a space of cells in their default state.
+     *
+     * @param width The number of columns.
+     * @param height The number of rows.
+     * @param stencil The (column,row) offsets of the neighbors of a cell. At most 32
+     * neighbors are permitted.
+     * @param wrap If true, the edges of the space wrap around. Otherwise
+     * neighbors that are outside the space are ignored.
+     */
+    CellSpace(unsigned int width, unsigned int height,
+              std::vector<std::pair<int, int>> const &stencil, bool wrap = false);
+    virtual ~CellSpace() {}
+
+    /// @brief The Moore neighborhood containing the eight surrounding cells.
+    static std::vector<std::pair<int, int>> moore_neighborhood() {
+        return {{-1, -1}, {0, -1}, {1, -1}, {-1, 0}, {1, 0}, {-1, 1}, {0, 1}, {1, 1}};
+    }
+    /// @brief The von Neumann neighborhood containing the four adjacent cells.
+    static std::vector<std::pair<int, int>> von_neumann_neighborhood() {
+        return {{0, -1}, {-1, 0}, {1, 0}, {0, 1}};
+    }
+
+    /**
+     * @brief Use a pool of threads to process the space in tiles.
+     *
+     * This must be called before the simulation starts.
+     * @param threads The number of threads, including the one running the Simulator.
+     * @param tile_size The width and height of a tile.
+     */
+    void set_threads(unsigned int threads, unsigned int tile_size = 64);
+
+    /// @brief The number of columns.
+    unsigned int get_width() const { return width; }
+    /// @brief The number of rows.
+    unsigned int get_height() const { return height; }
+    /// @brief The offsets of the neighbors of a cell.
+    std::vector<std::pair<int, int>> const &get_stencil() const { return stencil; }
+    /// @brief The time of the last event in the space.
+    TimeType get_time() const { return now; }
+    /// @brief Get the state of a cell.
+    CellState const &get_state(unsigned int x, unsigned int y) const {
+        return state[index(x, y)];
+    }
+    /**
+     * @brief Set the state of a cell.
+     *
+     * This may be used before the simulation starts or between events.
+     * The cell's time advance is calculated again using its new state.
+     */
+    void set_state(unsigned int x, unsigned int y, CellState const &s);
+    /**
+     * @brief Get a pin that delivers input to a cell.
+     *
+     * The same pin is returned for every call with the same cell.
+     */
+    pin_t input_pin(unsigned int x, unsigned int y);
+    /**
+     * @brief Get a pin that carries the output of a cell.
+     *
+     * The same pin is returned for every call with the same cell.
+     */
+    pin_t output_pin(unsigned int x, unsigned int y);
+
+    /**
+     * @brief The time advance of a cell.
+     *
+     * This is called after the cell changes state.
+     * @return The time to the cell's next internal event or adevs_inf.
+     */
+    virtual TimeType cell_ta(unsigned int x, unsigned int y, CellState const &s) = 0;
+    /**
+     * @brief The output of a cell.
+     *
+     * This is called before the cell_delta() of an imminent cell. It may
+     * be called more than once for the same state.
+     * @param msg The message to send to the cell's neighbors.
+     * @return True if the message should be sent.
+     */
+    virtual bool cell_output(unsigned int x, unsigned int y, CellState const &s,
+                             CellState &msg) = 0;
+    /**
+     * @brief The state transition function of a cell.
+     *
+     * This is called for a cell that is imminent, that has messages
+     * from its neighbors, or that has input from its pins.
+     */
+    virtual void cell_delta(CellEvent const &event, CellState &s) = 0;
+    /**
+     * @brief Convert the message of a cell into output for its pin.
+     *
+     * The default implementation places the message on the pin
+     * if a ValueType can be constructed from a CellState. Otherwise
+     * it must be overridden.
+     */
+    virtual void boundary_output(unsigned int x, unsigned int y, CellState const &msg, pin_t pin,
+                                 std::list<PinValue<ValueType>> &yb);
+
+    /// @brief Change the state of the cells that receive input from the space's pins.
+    void delta_ext(TimeType e, std::list<PinValue<ValueType>> const &xb);
+    /// @brief Change the state of imminent cells and the cells that receive their output.
+    void delta_int();
+    /// @brief Change the state of imminent cells and the cells that receive input.
+    void delta_conf(std::list<PinValue<ValueType>> const &xb);
+    /**
+     * @brief Calculate the output of the imminent cells.
+     *
+     * The messages of the cells are kept and sent to their neighbors by the
+     * next delta_int() or delta_conf(). This leaves the cells unchanged and
+     * may be called more than once.
+     */
+    void output_func(std::list<PinValue<ValueType>> &yb);
+    /// @brief Time until the next cell is imminent.
+    TimeType ta();
+
+  private:
+    // A rectangle of cells with its own schedule
+    struct tile_t {
+        tile_t(std::vector<TimeType> const &tN) : sched(tN), t_next(adevs_inf<TimeType>()) {}
+        bucket_queue<TimeType> sched;
+        TimeType t_next;
+        // Cells that will change state in the current step
+        std::vector<unsigned int> active;
+        // Imminent cells and those of them that have a message
+        std::vector<unsigned int> imminent, sent;
+        // Messages for cells in other tiles
+        std::vector<std::pair<unsigned int, uint32_t>> halo;
+    };
+
+    unsigned int const width, height;
+    bool const wrap;
+    std::vector<std::pair<int, int>> const stencil;
+    // State, last output, and event times of each cell
+    std::vector<CellState> state, outbox;
+    std::vector<TimeType> tL, tN;
+    // Bit k is set if neighbor k sent a message
+    std::vector<uint32_t> mailbox;
+    // Step in which the cell was last made active
+    std::vector<unsigned int> stamp;
+    unsigned int step;
+    TimeType now, t_next;
+    // Time at which the imminent cells and their messages were found, or adevs_inf
+    TimeType t_out;
+    bool initialized;
+    // The tiles and the threads that process them
+    unsigned int tile_size, tiles_x;
+    std::vector<std::unique_ptr<tile_t>> tiles;
+    std::unique_ptr<work_pool> pool;
+    // Tiles to be processed in the current phase
+    std::vector<unsigned int> work;
+    // Pins attached to cells and input from those pins
+    std::map<pin_t, unsigned int> input_pins;
+    std::map<unsigned int, pin_t> output_pins;
+    std::map<unsigned int, std::list<ValueType>> external;
+    std::list<ValueType> const no_input;
+
+    unsigned int index(unsigned int x, unsigned int y) const { return y * width + x; }
+    // Index of the cell at offset (dx,dy) from a cell or -1 if there is none
+    long shift(unsigned int cell, int dx, int dy) const;
+    long neighbor(unsigned int cell, unsigned int k) const {
+        return shift(cell, stencil[k].first, stencil[k].second);
+    }
+    unsigned int tile_of(unsigned int cell) const {
+        return ((cell / width) / tile_size) * tiles_x + (cell % width) / tile_size;
+    }
+    void make_tiles(unsigned int size);
+    void initialize();
+    void initialize_tile(unsigned int id);
+    void activate(unsigned int cell, tile_t &tile) {
+        if (stamp[cell] != step) {
+            stamp[cell] = step;
+            tile.active.push_back(cell);
+        }
+    }
+    void send(unsigned int cell, unsigned int id);
+    void output_tile(unsigned int id);
+    void send_tile(unsigned int id);
+    void send_outputs();
+    bool apply(unsigned int cell);
+    void apply_tile(unsigned int id);
+    void add_input(std::list<PinValue<ValueType>> const &xb);
+    void advance(TimeType t);
+};
+
+template <typename CellState, typename ValueType, typename TimeType>
+CellSpace<CellState, ValueType, TimeType>::CellSpace(
+    unsigned int width, unsigned int height, std::vector<std::pair<int, int>> const &stencil,
+    bool wrap)
+    : Atomic<ValueType, TimeType>(),
+      width(width),
+      height(height),
+      wrap(wrap),
+      stencil(stencil),
+      state(size_t(width) * height),
+      outbox(size_t(width) * height),
+      tL(size_t(width) * height, adevs_zero<TimeType>()),
+      tN(size_t(width) * height, adevs_inf<TimeType>()),
+      mailbox(size_t(width) * height, 0),
+      stamp(size_t(width) * height, 0),
+      step(0),
+      now(adevs_zero<TimeType>()),
+      t_next(adevs_inf<TimeType>()),
+      t_out(adevs_inf<TimeType>()),
+      initialized(false),
+      pool(new work_pool(1)) {
+    if (stencil.size() > 32) {
+        throw adevs::exception("A CellSpace stencil can have at most 32 neighbors", this);
+    }
+    make_tiles(std::max(std::max(width, height), 1u));
+}
+
+template <typename CellState, typename ValueType, typename TimeType>
+void CellSpace<CellState, ValueType, TimeType>::make_tiles(unsigned int size) {
+    tile_size = size;
+    tiles_x = (width + size - 1) / size;
+    unsigned int tiles_y = (height + size - 1) / size;
+    tiles.clear();
+    for (unsigned int i = 0; i < tiles_x * tiles_y; i++) {
+        tiles.emplace_back(new tile_t(tN));
+    }
+}
+
+template <typename CellState, typename ValueType, typename TimeType>
+void CellSpace<CellState, ValueType, TimeType>::set_threads(unsigned int threads,
+                                                            unsigned int tile_size) {
+    if (initialized) {
+        throw adevs::exception("CellSpace::set_threads must be called before the simulation starts",
+                               this);
+    }
+    if (tile_size == 0) {
+        throw adevs::exception("CellSpace tiles must have a positive size", this);
+    }
+    make_tiles(tile_size);
+    pool.reset(new work_pool(threads));
+}
+
+template <typename CellState, typename ValueType, typename TimeType>
+long CellSpace<CellState, ValueType, TimeType>::shift(unsigned int cell, int dx, int dy) const {
+    long x = long(cell % width) + dx;
+    long y = long(cell / width) + dy;
+    if (x < 0 || y < 0 || x >= long(width) || y >= long(height)) {
+        if (!wrap) {
+            return -1;
+        }
+        x = ((x % long(width)) + width) % width;
+        y = ((y % long(height)) + height) % height;
+    }
+    return y * long(width) + x;
+}
+
+template <typename CellState, typename ValueType, typename TimeType>
+void CellSpace<CellState, ValueType, TimeType>::initialize_tile(unsigned int id) {
+    tile_t &tile = *tiles[id];
+    unsigned int x0 = (id % tiles_x) * tile_size, y0 = (id / tiles_x) * tile_size;
+    for (unsigned int y = y0; y < std::min(y0 + tile_size, height); y++) {
+        for (unsigned int x = x0; x < std::min(x0 + tile_size, width); x++) {
+            unsigned int cell = index(x, y);
+            TimeType dt = cell_ta(x, y, state[cell]);
+            if (dt < adevs_inf<TimeType>()) {
+                tN[cell] = now + dt;
+                tile.sched.insert(cell, tN[cell]);
+            }
+        }
+    }
+    tile.t_next = tile.sched.min_time();
+}
+
+template <typename CellState, typename ValueType, typename TimeType>
+void CellSpace<CellState, ValueType, TimeType>::initialize() {
+    initialized = true;
+    work.clear();
+    for (unsigned int id = 0; id < tiles.size(); id++) {
+        work.push_back(id);
+    }
+    pool->run(work, [this](unsigned int id) { initialize_tile(id); });
+    t_next = adevs_inf<TimeType>();
+    for (auto const &tile : tiles) {
+        t_next = std::min(t_next, tile->t_next);
+    }
+}
+
+template <typename CellState, typename ValueType, typename TimeType>
+void CellSpace<CellState, ValueType, TimeType>::set_state(unsigned int x, unsigned int y,
+                                                          CellState const &s) {
+    unsigned int cell = index(x, y);
+    state[cell] = s;
+    t_out = adevs_inf<TimeType>();
+    if (initialized) {
+        tL[cell] = now;
+        TimeType const tN_old = tN[cell];
+        TimeType dt = cell_ta(x, y, s);
+        tN[cell] = (dt < adevs_inf<TimeType>()) ? now + dt : adevs_inf<TimeType>();
+        tile_t &tile = *tiles[tile_of(cell)];
+        if (tN[cell] < adevs_inf<TimeType>() && tN[cell] != tN_old) {
+            tile.sched.insert(cell, tN[cell]);
+        }
+        tile.t_next = tile.sched.min_time();
+        t_next = adevs_inf<TimeType>();
+        for (auto const &t : tiles) {
+            t_next = std::min(t_next, t->t_next);
+        }
+    }
+}
+
+template <typename CellState, typename ValueType, typename TimeType>
+pin_t CellSpace<CellState, ValueType, TimeType>::input_pin(unsigned int x, unsigned int y) {
+    unsigned int cell = index(x, y);
+    for (auto const &p : input_pins) {
+        if (p.second == cell) {
+            return p.first;
+        }
+    }
+    pin_t pin;
+    input_pins[pin] = cell;
+    return pin;
+}
+
+template <typename CellState, typename ValueType, typename TimeType>
+pin_t CellSpace<CellState, ValueType, TimeType>::output_pin(unsigned int x, unsigned int y) {
+    unsigned int cell = index(x, y);
+    auto iter = output_pins.find(cell);
+    if (iter != output_pins.end()) {
+        return iter->second;
+    }
+    pin_t pin;
+    output_pins[cell] = pin;
+    return pin;
+}
+
+template <typename CellState, typename ValueType, typename TimeType>
+void CellSpace<CellState, ValueType, TimeType>::boundary_output(
+    unsigned int, unsigned int, CellState const &msg, pin_t pin,
+    std::list<PinValue<ValueType>> &yb) {
+    if constexpr (std::is_constructible<ValueType, CellState const &>::value) {
+        yb.push_back(PinValue<ValueType>(pin, ValueType(msg)));
+    } else {
+        throw adevs::exception("CellSpace::boundary_output must be overridden", this);
+    }
+}
+
+template <typename CellState, typename ValueType, typename TimeType>
+TimeType CellSpace<CellState, ValueType, TimeType>::ta() {
+    if (!initialized) {
+        initialize();
+    }
+    return (t_next < adevs_inf<TimeType>()) ? t_next - now : adevs_inf<TimeType>();
+}
+
+template <typename CellState, typename ValueType, typename TimeType>
+void CellSpace<CellState, ValueType, TimeType>::send(unsigned int cell, unsigned int id) {
+    tile_t &tile = *tiles[id];
+    // The message goes to each cell that has this cell as its neighbor k.
+    // Messages for other tiles are delivered after every tile is finished.
+    for (unsigned int k = 0; k < stencil.size(); k++) {
+        long dst = shift(cell, -stencil[k].first, -stencil[k].second);
+        if (dst < 0) {
+            continue;
+        }
+        uint32_t const bit = uint32_t(1) << k;
+        if (tile_of(dst) == id) {
+            mailbox[dst] |= bit;
+            activate(dst, tile);
+        } else {
+            tile.halo.push_back(std::make_pair(dst, bit));
+        }
+    }
+}
+
+template <typename CellState, typename ValueType, typename TimeType>
+void CellSpace<CellState, ValueType, TimeType>::output_tile(unsigned int id) {
+    tile_t &tile = *tiles[id];
+    // Find the imminent cells and their messages without removing them from the queue
+    tile.imminent.clear();
+    tile.sent.clear();
+    tile.sched.peek(t_next, tile.imminent);
+    for (auto cell : tile.imminent) {
+        if (cell_output(cell % width, cell / width, state[cell], outbox[cell])) {
+            tile.sent.push_back(cell);
+        }
+    }
+}
+
+template <typename CellState, typename ValueType, typename TimeType>
+void CellSpace<CellState, ValueType, TimeType>::output_func(std::list<PinValue<ValueType>> &yb) {
+    if (t_out != t_next) {
+        work.clear();
+        for (unsigned int id = 0; id < tiles.size(); id++) {
+            if (tiles[id]->t_next == t_next) {
+                work.push_back(id);
+            }
+        }
+        pool->run(work, [this](unsigned int id) { output_tile(id); });
+        t_out = t_next;
+    }
+    if (output_pins.empty()) {
+        return;
+    }
+    for (auto const &tile : tiles) {
+        if (tile->t_next != t_next) {
+            continue;
+        }
+        for (auto cell : tile->sent) {
+            auto pin = output_pins.find(cell);
+            if (pin != output_pins.end()) {
+                boundary_output(cell % width, cell / width, outbox[cell], pin->second, yb);
+            }
+        }
+    }
+}
+
+template <typename CellState, typename ValueType, typename TimeType>
+void CellSpace<CellState, ValueType, TimeType>::send_tile(unsigned int id) {
+    tile_t &tile = *tiles[id];
+    // Remove the imminent cells from the queue
+    tile.sched.advance(t_next);
+    tile.sched.pop(t_next, tile.active);
+    for (auto cell : tile.active) {
+        stamp[cell] = step;
+    }
+    // Cells that receive messages are added to the end of the active list
+    for (auto cell : tile.sent) {
+        send(cell, id);
+    }
+    tile.imminent.clear();
+    tile.sent.clear();
+}
+
+template <typename CellState, typename ValueType, typename TimeType>
+void CellSpace<CellState, ValueType, TimeType>::send_outputs() {
+    // The output is calculated here if output_func() was not called
+    // or the space changed after it was
+    if (t_out != t_next) {
+        std::list<PinValue<ValueType>> yb;
+        output_func(yb);
+    }
+    t_out = adevs_inf<TimeType>();
+    step++;
+    work.clear();
+    for (unsigned int id = 0; id < tiles.size(); id++) {
+        if (tiles[id]->t_next == t_next) {
+            work.push_back(id);
+        }
+    }
+    pool->run(work, [this](unsigned int id) { send_tile(id); });
+    // Deliver messages that cross tiles
+    for (auto const &tile : tiles) {
+        for (auto const &msg : tile->halo) {
+            mailbox[msg.first] |= msg.second;
+            activate(msg.first, *tiles[tile_of(msg.first)]);
+        }
+        tile->halo.clear();
+    }
+}
+
+// Returns true if the cell must be put into the queue again
+template <typename CellState, typename ValueType, typename TimeType>
+bool CellSpace<CellState, ValueType, TimeType>::apply(unsigned int cell) {
+    CellEvent event;
+    event.x = cell % width;
+    event.y = cell / width;
+    event.elapsed = now - tL[cell];
+    event.imminent = (tN[cell] == now);
+    event.space = this;
+    event.cell = cell;
+    event.mail = mailbox[cell];
+    event.inputs = &no_input;
+    if (!external.empty()) {
+        auto iter = external.find(cell);
+        if (iter != external.end()) {
+            event.inputs = &(iter->second);
+        }
+    }
+    cell_delta(event, state[cell]);
+    mailbox[cell] = 0;
+    tL[cell] = now;
+    TimeType const tN_old = tN[cell];
+    TimeType dt = cell_ta(event.x, event.y, state[cell]);
+    tN[cell] = (dt < adevs_inf<TimeType>()) ? now + dt : adevs_inf<TimeType>();
+    // An imminent cell was removed from the queue. Any other
+    // cell is still there unless its time of next event changed.
+    return tN[cell] < adevs_inf<TimeType>() && (event.imminent || tN[cell] != tN_old);
+}
+
+template <typename CellState, typename ValueType, typename TimeType>
+void CellSpace<CellState, ValueType, TimeType>::add_input(
+    std::list<PinValue<ValueType>> const &xb) {
+    for (auto const &x : xb) {
+        auto iter = input_pins.find(x.pin);
+        if (iter == input_pins.end()) {
+            throw adevs::exception("Input to a CellSpace on a pin that has no cell", this);
+        }
+        external[iter->second].push_back(x.value);
+        activate(iter->second, *tiles[tile_of(iter->second)]);
+    }
+}
+
+template <typename CellState, typename ValueType, typename TimeType>
+void CellSpace<CellState, ValueType, TimeType>::apply_tile(unsigned int id) {
+    tile_t &tile = *tiles[id];
+    // Keep the cells that must be scheduled again
+    size_t n = 0;
+    for (auto cell : tile.active) {
+        if (apply(cell)) {
+            tile.active[n++] = cell;
+        }
+    }
+    tile.active.resize(n);
+    // Schedule after every cell has changed state so that
+    // the window of the queue starts at the current time
+    tile.sched.advance(now);
+    for (auto cell : tile.active) {
+        tile.sched.insert(cell, tN[cell]);
+    }
+    tile.active.clear();
+    tile.t_next = tile.sched.min_time();
+}
+
+template <typename CellState, typename ValueType, typename TimeType>
+void CellSpace<CellState, ValueType, TimeType>::advance(TimeType t) {
+    now = t;
+    work.clear();
+    for (unsigned int id = 0; id < tiles.size(); id++) {
+        if (!tiles[id]->active.empty()) {
+            work.push_back(id);
+        }
+    }
+    pool->run(work, [this](unsigned int id) { apply_tile(id); });
+    external.clear();
+    t_next = adevs_inf<TimeType>();
+    for (auto const &tile : tiles) {
+        t_next = std::min(t_next, tile->t_next);
+    }
+}
+
+template <typename CellState, typename ValueType, typename TimeType>
+void CellSpace<CellState, ValueType, TimeType>::delta_int() {
+    send_outputs();
+    advance(t_next);
+}
+
+template <typename CellState, typename ValueType, typename TimeType>
+void CellSpace<CellState, ValueType, TimeType>::delta_conf(
+    std::list<PinValue<ValueType>> const &xb) {
+    send_outputs();
+    add_input(xb);
+    advance(t_next);
+}
+
+template <typename CellState, typename ValueType, typename TimeType>
+void CellSpace<CellState, ValueType, TimeType>::delta_ext(
+    TimeType e, std::list<PinValue<ValueType>> const &xb) {
+    t_out = adevs_inf<TimeType>();
+    step++;
+    add_input(xb);
+    advance(now + e);
+}
+
+}  // namespace adevs
+
+#endif
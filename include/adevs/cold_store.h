@@ -0,0 +1,299 @@
+
+/*
+ * Copyright (c) 2025, James Nutaro
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ *
+ * Bugs, comments, and questions can be sent to nutaro@gmail.com
+ */
+#ifndef _adevs_cold_store_h_
+#define _adevs_cold_store_h_
+#include <any>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "adevs/graph.h"
+
+namespace adevs {
+
+/**
+ * @brief Holds the saved states of dormant models outside of the Graph.
+ *
+ * A dormant model has a time advance of infinity and will do nothing
+ * until it receives input. When Simulator::compact() is called, each
+ * dormant model is passed to the save function. If the save function
+ * returns true, the model is removed from the Graph and destroyed,
+ * and its saved state is appended to a single array of bytes. The
+ * edges that lead to the model are replaced by an edge to a marker
+ * that is shared by every dormant model.
+ *
+ * When the Simulator routes input to the marker, the models waiting
+ * on that pin are made again by the restore function, put back into
+ * the Graph with their edges, and given the input. Their elapsed time
+ * is measured from their last event before they were saved, so the
+ * restored model sees the same delta_ext() that it would have seen if
+ * it had never been removed.
+ *
+ * The restored model is a new object. Any pointers to the original
+ * model that are kept outside of the Graph will not refer to it.
+ * MealyAtomic models are never compacted.
+ *
+ * @tparam ValueType The type of value exchanged by models in the Graph.
+ * @tparam TimeType The type used for time.
+ */
+template <typename ValueType = std::any, typename TimeType = double>
+class ColdStore {
+  public:
+    /// @brief Saves the state of a model and returns false if the model cannot be saved.
+    using save_function =
+        std::function<bool(Atomic<ValueType, TimeType> &model, std::vector<char> &state)>;
+    /// @brief Makes a model from its saved state.
+    using restore_function = std::function<std::shared_ptr<Atomic<ValueType, TimeType>>(
+        char const* state, size_t size)>;
+    /**
+     * @brief Create an empty store.
+     *
+     * @param save Appends the state of a model to a vector of bytes.
+     * @param restore Makes a model from the bytes that were saved.
+     */
+    ColdStore(save_function save, restore_function restore)
+        : save(save), restore(restore), marker(std::make_shared<dormant_marker>()), live(0),
+          dead_bytes(0), wake_count(0) {}
+    /// @brief Get the number of models in the store.
+    size_t size() const { return live; }
+    /// @brief Get the number of bytes used for saved states.
+    size_t bytes() const { return data.size(); }
+    /// @brief Get the number of models that have been restored.
+    size_t woken() const { return wake_count; }
+
+  private:
+    friend class Simulator<ValueType, TimeType>;
+
+    // Stands in for dormant models in the Graph
+    class dormant_marker : public Atomic<ValueType, TimeType> {
+      public:
+        TimeType ta() { return adevs_inf<TimeType>(); }
+        void delta_int() {}
+        void delta_ext(TimeType, std::list<PinValue<ValueType>> const &) {}
+        void delta_conf(std::list<PinValue<ValueType>> const &) {}
+        void output_func(std::list<PinValue<ValueType>> &) {}
+    };
+
+    struct record {
+        TimeType tL;
+        size_t offset, size, first_edge;
+        uint32_t edges;
+        int instances;
+        bool live;
+    };
+
+    save_function save;
+    restore_function restore;
+    std::shared_ptr<Atomic<ValueType, TimeType>> const marker;
+    // Saved states and the edges of each model
+    std::vector<char> data;
+    std::vector<std::pair<pin_t, int>> edges;
+    std::vector<record> records;
+    std::vector<uint32_t> free_records;
+    // The dormant models that receive input from each pin
+    std::map<pin_t, std::vector<uint32_t>> receivers;
+    size_t live, dead_bytes, wake_count;
+
+    size_t evict(Graph<ValueType, TimeType> &graph,
+                 std::vector<std::pair<std::shared_ptr<Atomic<ValueType, TimeType>>, TimeType>> const
+                     &dormant);
+    void wake(pin_t pin, Graph<ValueType, TimeType> &graph,
+              std::vector<std::pair<std::shared_ptr<Atomic<ValueType, TimeType>>, TimeType>> &woken);
+    void remove_marker(Graph<ValueType, TimeType> &graph, pin_t pin);
+    void compact();
+};
+
+template <typename ValueType, typename TimeType>
+size_t ColdStore<ValueType, TimeType>::evict(
+    Graph<ValueType, TimeType> &graph,
+    std::vector<std::pair<std::shared_ptr<Atomic<ValueType, TimeType>>, TimeType>> const &dormant) {
+    std::unordered_map<Atomic<ValueType, TimeType>*, uint32_t> saved;
+    std::vector<char> state;
+    for (auto const &model : dormant) {
+        state.clear();
+        if (!save(*model.first, state)) {
+            continue;
+        }
+        record r;
+        r.tL = model.second;
+        r.offset = data.size();
+        r.size = state.size();
+        r.first_edge = 0;
+        r.edges = 0;
+        r.instances = graph.atomic_instance_count.at(model.first.get());
+        r.live = true;
+        data.insert(data.end(), state.begin(), state.end());
+        uint32_t id;
+        if (free_records.empty()) {
+            id = uint32_t(records.size());
+            records.push_back(r);
+        } else {
+            id = free_records.back();
+            free_records.pop_back();
+            records[id] = r;
+        }
+        saved[model.first.get()] = id;
+    }
+    if (saved.empty()) {
+        return 0;
+    }
+    // Replace the edges to the saved models with edges to the marker
+    std::vector<std::vector<std::pair<pin_t, int>>> found(records.size());
+    for (auto &src : graph.pin_to_atomic) {
+        bool has_marker = false, add_marker = false;
+        for (auto iter = src.second.begin(); iter != src.second.end();) {
+            auto model = saved.find(iter->first.get());
+            if (model != saved.end()) {
+                found[model->second].push_back(std::make_pair(src.first, iter->second));
+                receivers[src.first].push_back(model->second);
+                iter = src.second.erase(iter);
+                add_marker = true;
+            } else {
+                has_marker = has_marker || iter->first == marker;
+                iter++;
+            }
+        }
+        if (add_marker && !has_marker) {
+            src.second.push_back(std::make_pair(marker, 1));
+        }
+    }
+    for (auto const &model : saved) {
+        record &r = records[model.second];
+        r.first_edge = edges.size();
+        r.edges = uint32_t(found[model.second].size());
+        edges.insert(edges.end(), found[model.second].begin(), found[model.second].end());
+        graph.atomic_instance_count.erase(model.first);
+    }
+    for (auto iter = graph.models.begin(); iter != graph.models.end();) {
+        if (saved.find(iter->get()) != saved.end()) {
+            iter = graph.models.erase(iter);
+        } else {
+            iter++;
+        }
+    }
+    live += saved.size();
+    return saved.size();
+}
+
+template <typename ValueType, typename TimeType>
+void ColdStore<ValueType, TimeType>::wake(
+    pin_t pin, Graph<ValueType, TimeType> &graph,
+    std::vector<std::pair<std::shared_ptr<Atomic<ValueType, TimeType>>, TimeType>> &woken) {
+    auto waiting = receivers.find(pin);
+    if (waiting == receivers.end()) {
+        return;
+    }
+    std::vector<uint32_t> ids;
+    ids.swap(waiting->second);
+    receivers.erase(waiting);
+    remove_marker(graph, pin);
+    for (uint32_t id : ids) {
+        record &r = records[id];
+        if (!r.live) {
+            continue;
+        }
+        auto model = restore(data.data() + r.offset, r.size);
+        r.live = false;
+        live--;
+        wake_count++;
+        dead_bytes += r.size;
+        free_records.push_back(id);
+        graph.models.insert(model);
+        graph.atomic_instance_count[model.get()] = r.instances;
+        for (size_t e = r.first_edge; e < r.first_edge + r.edges; e++) {
+            pin_t const &src = edges[e].first;
+            graph.pin_to_atomic[src].push_back(std::make_pair(model, edges[e].second));
+            // Forget this model on its other pins
+            auto others = receivers.find(src);
+            if (others != receivers.end()) {
+                auto &list = others->second;
+                for (size_t k = 0; k < list.size(); k++) {
+                    if (list[k] == id) {
+                        list[k] = list.back();
+                        list.pop_back();
+                        break;
+                    }
+                }
+                if (list.empty()) {
+                    receivers.erase(others);
+                    remove_marker(graph, src);
+                }
+            }
+        }
+        woken.push_back(std::make_pair(model, r.tL));
+    }
+    if (dead_bytes > data.size() / 2) {
+        compact();
+    }
+}
+
+template <typename ValueType, typename TimeType>
+void ColdStore<ValueType, TimeType>::remove_marker(Graph<ValueType, TimeType> &graph, pin_t pin) {
+    auto iter = graph.pin_to_atomic.find(pin);
+    if (iter == graph.pin_to_atomic.end()) {
+        return;
+    }
+    for (auto edge = iter->second.begin(); edge != iter->second.end(); edge++) {
+        if (edge->first == marker) {
+            iter->second.erase(edge);
+            break;
+        }
+    }
+}
+
+template <typename ValueType, typename TimeType>
+void ColdStore<ValueType, TimeType>::compact() {
+    // Copy the states and edges of live models into new arrays
+    std::vector<char> new_data;
+    std::vector<std::pair<pin_t, int>> new_edges;
+    new_data.reserve(data.size() - dead_bytes);
+    for (auto &r : records) {
+        if (!r.live) {
+            continue;
+        }
+        new_data.insert(new_data.end(), data.begin() + r.offset, data.begin() + r.offset + r.size);
+        r.offset = new_data.size() - r.size;
+        new_edges.insert(new_edges.end(), edges.begin() + r.first_edge,
+                         edges.begin() + r.first_edge + r.edges);
+        r.first_edge = new_edges.size() - r.edges;
+    }
+    data.swap(new_data);
+    edges.swap(new_edges);
+    dead_bytes = 0;
+}
+
+}  // namespace adevs
+
+#endif
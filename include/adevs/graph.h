@@ -35,6 +35,7 @@
 #include <map>
 #include <memory>
 #include <set>
+#include "adevs/arena.h"
 #include "adevs/models.h"
 
 namespace adevs {
@@ -160,10 +161,14 @@ class Graph {
          * from the supplied pin.
          * @param pin The pin to query.
          * @param models A list to be filled with models and pins that are connected to the supplied pin.
+         * This may be a std::list or a route_list.
          */
-    void route(
-        pin_t pin,
-        std::list<std::pair<pin_t, std::shared_ptr<Atomic<ValueType, TimeType>>>> &models) const;
+    template <class List>
+    void route(pin_t pin, List &models) const;
+    /// @brief A list for route() that reuses its nodes when it is filled and emptied repeatedly.
+    using route_list =
+        std::list<std::pair<pin_t, std::shared_ptr<Atomic<ValueType, TimeType>>>,
+                  recycling_allocator<std::pair<pin_t, std::shared_ptr<Atomic<ValueType, TimeType>>>>>;
     /**
          *  @brief  Get the set of Atomic models that are part of the graph.
          * 
@@ -220,6 +225,8 @@ class Graph {
         /// @brief The Atomic model that is involved in the operation, if any.
         std::shared_ptr<Atomic<ValueType, TimeType>> model;
     };
+    /// @brief The list of queued operations.
+    using pending_list = std::list<graph_op, recycling_allocator<graph_op>>;
     /**
          * @brief Get the set of operations that have been queued while in the provisional mode.
          * 
@@ -229,9 +236,14 @@ class Graph {
          * 
          * @return The list of pending operations.
          */
-    std::list<graph_op> &get_pending() { return pending; }
+    pending_list &get_pending() { return pending; }
 
   private:
+    friend class GraphBuilder<ValueType, TimeType>;
+    friend class Topology<ValueType, TimeType>;
+    friend class Partitioner<ValueType, TimeType>;
+    friend class ColdStore<ValueType, TimeType>;
+
     std::map<pin_t, std::list<std::pair<std::shared_ptr<Atomic<ValueType, TimeType>>, int>>>
         pin_to_atomic;
     std::map<pin_t, std::list<std::pair<pin_t, int>>> pin_to_pin;
@@ -250,7 +262,7 @@ class Graph {
     // to indicate that the graph is in a provisional state during execution.
     // When true, changes are queued but not applied to the graph.
     bool provisional;
-    std::list<graph_op> pending;
+    pending_list pending;
 };
 
 template <typename ValueType, typename TimeType>
@@ -435,14 +447,12 @@ void Graph<ValueType, TimeType>::disconnect(pin_t pin,
 }
 
 template <typename ValueType, typename TimeType>
-void Graph<ValueType, TimeType>::route(
-    pin_t pin,
-    std::list<std::pair<pin_t, std::shared_ptr<Atomic<ValueType, TimeType>>>> &models) const {
+template <class List>
+void Graph<ValueType, TimeType>::route(pin_t pin, List &models) const {
     auto i = pin_to_atomic.find(pin);
     if (i != pin_to_atomic.end()) {
         for (auto j = i->second.begin(); j != i->second.end(); j++) {
-            models.push_back(
-                std::pair<pin_t, std::shared_ptr<Atomic<ValueType, TimeType>>>(pin, (*j).first));
+            models.emplace_back(pin, (*j).first);
         }
     }
     auto r = pin_to_pin.find(pin);
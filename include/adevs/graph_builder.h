@@ -0,0 +1,278 @@
+
+/*
+ * Copyright (c) 2025, James Nutaro
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ *
+ * Bugs, comments, and questions can be sent to nutaro@gmail.com
+ */
+#ifndef _adevs_graph_builder_h_
+#define _adevs_graph_builder_h_
+#include <algorithm>
+#include <any>
+#include <functional>
+#include <list>
+#include <memory>
+#include <numeric>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "adevs/graph.h"
+
+namespace adevs {
+
+/**
+ * @brief Collects models and edges and adds them to a Graph all at once.
+ *
+ * Adding a large number of edges to a Graph with Graph::connect()
+ * is slow because each call searches the existing edges of the
+ * pin for a duplicate. The GraphBuilder instead stores the models
+ * and edges in arrays. When build() is called the arrays are sorted,
+ * duplicates are counted, and the Graph's internal structures are
+ * filled in a single pass. The result is the same as calling
+ * Graph::add_atomic() and Graph::connect() for each model and edge
+ * in the builder in the order that they were added, including the
+ * counts of instances for models and edges that were added more
+ * than once.
+ *
+ * @tparam ValueType The type of value exchanged by models in the Graph.
+ * @tparam TimeType The type used for time.
+ */
+template <typename ValueType = std::any, typename TimeType = double>
+class GraphBuilder {
+  public:
+    /// @brief Create an empty builder.
+    GraphBuilder() {}
+    /**
+     * @brief Reserve space for models and edges.
+     *
+     * @param models The expected number of models.
+     * @param pin_edges The expected number of pin to pin edges.
+     * @param atomic_edges The expected number of pin to Atomic edges.
+     */
+    void reserve(size_t models, size_t pin_edges, size_t atomic_edges) {
+        atomics.reserve(models);
+        pin_to_pin.reserve(pin_edges);
+        pin_to_atomic.reserve(atomic_edges);
+    }
+    /// @brief As Graph::add_atomic().
+    void add_atomic(std::shared_ptr<Atomic<ValueType, TimeType>> model) {
+        atomics.push_back(std::move(model));
+    }
+    /// @brief As Graph::connect(pin_t, pin_t).
+    void connect(pin_t src, pin_t dst) { pin_to_pin.emplace_back(src, dst); }
+    /// @brief As Graph::connect(pin_t, std::shared_ptr<Atomic<ValueType,TimeType>>).
+    void connect(pin_t pin, std::shared_ptr<Atomic<ValueType, TimeType>> model) {
+        pin_to_atomic.emplace_back(pin, std::move(model));
+    }
+    /**
+     * @brief Add the models and edges to a Graph and empty the builder.
+     *
+     * If the Graph is in provisional mode, the models and edges are queued
+     * as they would be by Graph::add_atomic() and Graph::connect().
+     *
+     * @param graph The Graph to receive the models and edges.
+     * @param threads The number of threads to use for sorting.
+     */
+    void build(Graph<ValueType, TimeType> &graph, unsigned int threads = 1);
+    /// @brief Discard the models and edges in the builder.
+    void clear() {
+        atomics.clear();
+        pin_to_pin.clear();
+        pin_to_atomic.clear();
+    }
+
+  private:
+    using atomic_ptr = std::shared_ptr<Atomic<ValueType, TimeType>>;
+    std::vector<atomic_ptr> atomics;
+    std::vector<std::pair<pin_t, pin_t>> pin_to_pin;
+    std::vector<std::pair<pin_t, atomic_ptr>> pin_to_atomic;
+
+    template <typename T, typename Compare>
+    static void parallel_sort(std::vector<T> &v, Compare comp, unsigned int threads);
+    template <typename Target, typename Less>
+    static void add_targets(std::list<std::pair<Target, int>> &edges, bool merge,
+                            std::vector<std::pair<pin_t, Target>> const &v, size_t first,
+                            size_t last, Less less, std::vector<size_t> &order,
+                            std::vector<std::pair<size_t, int>> &runs);
+};
+
+template <typename ValueType, typename TimeType>
+template <typename T, typename Compare>
+void GraphBuilder<ValueType, TimeType>::parallel_sort(std::vector<T> &v, Compare comp,
+                                                      unsigned int threads) {
+    // Small arrays are not worth the threads
+    threads = std::min(threads, (unsigned int)(v.size() / 4096));
+    if (threads < 2) {
+        std::stable_sort(v.begin(), v.end(), comp);
+        return;
+    }
+    // Sort equal pieces of the array and then merge them in pairs
+    std::vector<size_t> bounds;
+    for (unsigned int i = 0; i <= threads; i++) {
+        bounds.push_back(v.size() * i / threads);
+    }
+    std::vector<std::thread> workers;
+    for (unsigned int i = 1; i < threads; i++) {
+        workers.emplace_back(
+            [&v, &bounds, &comp, i] { std::stable_sort(v.begin() + bounds[i], v.begin() + bounds[i + 1], comp); });
+    }
+    std::stable_sort(v.begin(), v.begin() + bounds[1], comp);
+    for (auto &t : workers) {
+        t.join();
+    }
+    for (unsigned int width = 1; width < threads; width *= 2) {
+        workers.clear();
+        for (unsigned int i = 0; i + width < threads; i += 2 * width) {
+            size_t first = bounds[i], middle = bounds[i + width];
+            size_t last = bounds[std::min(i + 2 * width, threads)];
+            workers.emplace_back([&v, &comp, first, middle, last] {
+                std::inplace_merge(v.begin() + first, v.begin() + middle, v.begin() + last, comp);
+            });
+        }
+        for (auto &t : workers) {
+            t.join();
+        }
+    }
+}
+
+// Append the targets of the edges v[first..last) of one pin to its list
+// of edges. As with Graph::connect(), a target is placed where it first
+// appears and each repeat adds one to its count.
+template <typename ValueType, typename TimeType>
+template <typename Target, typename Less>
+void GraphBuilder<ValueType, TimeType>::add_targets(
+    std::list<std::pair<Target, int>> &edges, bool merge,
+    std::vector<std::pair<pin_t, Target>> const &v, size_t first, size_t last, Less less,
+    std::vector<size_t> &order, std::vector<std::pair<size_t, int>> &runs) {
+    // Group equal targets while keeping the first appearance of each at the front
+    order.resize(last - first);
+    std::iota(order.begin(), order.end(), first);
+    std::stable_sort(order.begin(), order.end(),
+                     [&](size_t a, size_t b) { return less(v[a].second, v[b].second); });
+    runs.clear();
+    for (size_t i = 0, k = 0; i < order.size(); i = k) {
+        for (k = i + 1; k < order.size() && !less(v[order[i]].second, v[order[k]].second); k++)
+            ;
+        runs.emplace_back(order[i], int(k - i));
+    }
+    std::sort(runs.begin(), runs.end());
+    for (auto const &run : runs) {
+        Target const &target = v[run.first].second;
+        auto dst = edges.end();
+        if (merge) {
+            dst = std::find_if(edges.begin(), edges.end(), [&](std::pair<Target, int> const &e) {
+                return !less(e.first, target) && !less(target, e.first);
+            });
+        }
+        if (dst != edges.end()) {
+            dst->second += run.second;
+        } else {
+            edges.emplace_back(target, run.second);
+        }
+    }
+}
+
+template <typename ValueType, typename TimeType>
+void GraphBuilder<ValueType, TimeType>::build(Graph<ValueType, TimeType> &graph,
+                                              unsigned int threads) {
+    if (graph.provisional) {
+        for (auto const &model : atomics) {
+            graph.add_atomic(model);
+        }
+        for (auto const &edge : pin_to_pin) {
+            graph.connect(edge.first, edge.second);
+        }
+        for (auto const &edge : pin_to_atomic) {
+            graph.connect(edge.first, edge.second);
+        }
+        clear();
+        return;
+    }
+    auto by_address = [](atomic_ptr const &a, atomic_ptr const &b) { return a.get() < b.get(); };
+    parallel_sort(atomics, by_address, threads);
+    // The edges of each pin stay in the order in which they were added
+    parallel_sort(
+        pin_to_pin,
+        [](std::pair<pin_t, pin_t> const &a, std::pair<pin_t, pin_t> const &b) {
+            return a.first < b.first;
+        },
+        threads);
+    parallel_sort(
+        pin_to_atomic,
+        [](std::pair<pin_t, atomic_ptr> const &a, std::pair<pin_t, atomic_ptr> const &b) {
+            return a.first < b.first;
+        },
+        threads);
+    // Each run of equal models is one model with an instance count
+    for (size_t i = 0, j = 0; i < atomics.size(); i = j) {
+        for (j = i + 1; j < atomics.size() && atomics[j] == atomics[i]; j++)
+            ;
+        int count = int(j - i);
+        auto iter = graph.atomic_instance_count.lower_bound(atomics[i].get());
+        if (iter != graph.atomic_instance_count.end() && iter->first == atomics[i].get()) {
+            iter->second += count;
+        } else {
+            graph.atomic_instance_count.emplace_hint(iter, atomics[i].get(), count);
+            graph.models.emplace_hint(graph.models.end(), atomics[i]);
+        }
+    }
+    // Edges are grouped by their source pin and the repeats of an
+    // edge are one edge with an instance count
+    std::vector<size_t> order;
+    std::vector<std::pair<size_t, int>> runs;
+    for (size_t i = 0, j = 0; i < pin_to_pin.size(); i = j) {
+        pin_t const src = pin_to_pin[i].first;
+        for (j = i; j < pin_to_pin.size() && pin_to_pin[j].first == src; j++)
+            ;
+        auto iter = graph.pin_to_pin.lower_bound(src);
+        bool const merge = (iter != graph.pin_to_pin.end() && iter->first == src);
+        if (!merge) {
+            iter = graph.pin_to_pin.emplace_hint(iter, src, std::list<std::pair<pin_t, int>>());
+        }
+        add_targets(iter->second, merge, pin_to_pin, i, j, std::less<pin_t>(), order, runs);
+    }
+    for (size_t i = 0, j = 0; i < pin_to_atomic.size(); i = j) {
+        pin_t const src = pin_to_atomic[i].first;
+        for (j = i; j < pin_to_atomic.size() && pin_to_atomic[j].first == src; j++)
+            ;
+        auto iter = graph.pin_to_atomic.lower_bound(src);
+        bool const merge = (iter != graph.pin_to_atomic.end() && iter->first == src);
+        if (!merge) {
+            iter = graph.pin_to_atomic.emplace_hint(iter, src,
+                                                    std::list<std::pair<atomic_ptr, int>>());
+        }
+        add_targets(
+            iter->second, merge, pin_to_atomic, i, j,
+            [](atomic_ptr const &a, atomic_ptr const &b) { return a.get() < b.get(); }, order,
+            runs);
+    }
+    clear();
+}
+
+}  // namespace adevs
+
+#endif
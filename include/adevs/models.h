@@ -37,6 +37,8 @@
 #include <list>
 #include <memory>
 #include <set>
+#include <type_traits>
+#include <utility>
 #include "adevs/exception.h"
 #include "adevs/time.h"
 
@@ -53,6 +55,14 @@ template <typename ValueType, typename TimeType>
 class MealyAtomic;
 template <typename ValueType, typename TimeType>
 class Graph;
+template <typename ValueType, typename TimeType>
+class GraphBuilder;
+template <typename ValueType, typename TimeType>
+class Topology;
+template <typename ValueType, typename TimeType>
+class Partitioner;
+template <typename ValueType, typename TimeType>
+class ColdStore;
 /// \endcond
 
 /**
@@ -157,8 +167,9 @@ class PinValue {
     PinValue() {}
     /// @brief Constructor that assigns a pin and value.
     /// @param pin  The pin on which the value appears.
-    /// @param value  The value that appears on the pin.
-    PinValue(pin_t pin, ValueType value) : pin(pin), value(value) {}
+    /// @param value  The value that appears on the pin. It is moved
+    /// into the PinValue, so pass an rvalue to avoid a copy.
+    PinValue(pin_t pin, ValueType value) : pin(pin), value(std::move(value)) {}
     /// @brief Copy constructor.
     ///
     /// The source object's pin and value are copied using their
@@ -166,6 +177,13 @@ class PinValue {
     ///
     /// @param src  The PinValue object to copy.
     PinValue(PinValue const &src) : pin(src.pin), value(src.value) {}
+    /// @brief Move constructor.
+    ///
+    /// The source object's value is moved and its pin is copied.
+    ///
+    /// @param src  The PinValue object to move from.
+    PinValue(PinValue &&src) noexcept(std::is_nothrow_move_constructible<ValueType>::value)
+        : pin(src.pin), value(std::move(src.value)) {}
     /// @brief Assignment operator.
     ///
     /// The source object's pin and value are assigned using their
@@ -177,12 +195,69 @@ class PinValue {
         value = src.value;
         return *this;
     }
+    /// @brief Move assignment operator.
+    ///
+    /// The source object's value is moved and its pin is copied.
+    ///
+    /// @param src  The PinValue object to move from.
+    PinValue<ValueType> const &operator=(PinValue &&src) noexcept(
+        std::is_nothrow_move_assignable<ValueType>::value) {
+        pin = src.pin;
+        value = std::move(src.value);
+        return *this;
+    }
     /// @brief The pin on which the value appears.
     pin_t pin;
     /// @brief The value that appears on the pin.
     ValueType value;
 };
 
+/**
+ * @brief An immutable value that is shared by every model receiving it.
+ *
+ * The Simulator gives each receiver of an output its own copy of
+ * the PinValue. If the value is large, such as an image or a batch of
+ * packets, and is sent to many receivers then these copies can dominate
+ * the cost of the simulation. Using shared_value<T> as the ValueType
+ * (or as the content of a std::any) avoids this. Copying a shared_value
+ * copies only a reference counted pointer, and all of the receivers
+ * see the one buffer that was created by the sender.
+ *
+ * Because the buffer is shared, it cannot be modified after the
+ * shared_value is constructed. A receiver that needs to change
+ * the value must make its own copy.
+ *
+ * @see PinValue
+ */
+template <typename T>
+class shared_value {
+  public:
+    /// @brief Create an empty value.
+    shared_value() {}
+    /// @brief Create a shared copy of value.
+    /// @param value The value to share.
+    shared_value(T const &value) : p(std::make_shared<T const>(value)) {}
+    /// @brief Move value into a shared buffer.
+    /// @param value The value to share.
+    shared_value(T &&value) : p(std::make_shared<T const>(std::move(value))) {}
+    /// @brief Adopt a buffer that has already been allocated.
+    /// @param value The buffer to share.
+    shared_value(std::shared_ptr<T const> value) : p(std::move(value)) {}
+    /// @brief Get the shared value.
+    T const &get() const { return *p; }
+    /// @brief Get the shared value.
+    T const &operator*() const { return *p; }
+    /// @brief Access members of the shared value.
+    T const* operator->() const { return p.get(); }
+    /// @brief True if there is a value.
+    explicit operator bool() const { return p != nullptr; }
+    /// @brief The number of shared_value objects that refer to this buffer.
+    long use_count() const { return p.use_count(); }
+
+  private:
+    std::shared_ptr<T const> p;
+};
+
 
 /** 
  * @brief An atomic model in the DEVS formalism.
@@ -300,9 +375,9 @@ class Atomic {
 
     std::list<PinValue<ValueType>> inputs;
     std::list<PinValue<ValueType>> outputs;
-    // Revisable input. This is used to calculate input originating
-    // from Mealy models.
-    std::list<std::pair<Atomic<ValueType, TimeType>*,PinValue<ValueType>>> revisable_inputs;
+    // Input originating from Mealy models. This is kept apart from
+    // the other input until all of the Mealy output is calculated.
+    std::list<PinValue<ValueType>> revisable_inputs;
 
     virtual MealyAtomic<ValueType, TimeType>* isMealyAtomic() { return nullptr; }
 };
@@ -323,6 +398,9 @@ class Atomic {
  * Mealy models cannot appear in loops that contain
  * other Mealy models. The simulator will throw an
  * adevs::exception and abort if you attempt to do so.
+ * Pins that are declared with declare_output() are checked
+ * for such loops when the Simulator is created. Other pins
+ * are checked when the model first produces output on them.
  * 
  * A Mealy model cannot change any aspect of its state
  * in its output function. Each output function of the
@@ -335,7 +413,20 @@ template <typename ValueType = std::any, typename TimeType = double>
 class MealyAtomic : public Atomic<ValueType, TimeType> {
   public:
     /// @brief Default constructor.
-    MealyAtomic() : Atomic<ValueType, TimeType>() {}
+    MealyAtomic() : Atomic<ValueType, TimeType>(), mealy_rank(0), mealy_queued(false) {}
+    /**
+     * @brief Declare a pin on which this model produces output.
+     *
+     * The Simulator calculates the output of MealyAtomic models in an
+     * order that puts each model after the MealyAtomic models that send
+     * it input. Declaring output pins lets the Simulator find this order,
+     * and any illegal cycles, when it is created. Undeclared pins are
+     * discovered as the simulation runs, at the cost of calculating
+     * the output of some MealyAtomic models a second time.
+     *
+     * @param pin A pin that is used by the output functions of this model.
+     */
+    void declare_output(pin_t pin) { output_pins.insert(pin); }
     /**
      * @brief Produce output at an external transition.
      * 
@@ -368,8 +459,12 @@ class MealyAtomic : public Atomic<ValueType, TimeType> {
   private:
     friend class Simulator<ValueType, TimeType>;
 
-    // Set of models that have received revisable input from this model
-    std::set<Atomic<ValueType, TimeType>*> receivers;
+    // Pins on which this model is known to produce output
+    std::set<pin_t> output_pins;
+    // Position in the Simulator's ordering of Mealy models
+    unsigned int mealy_rank;
+    // Is this model waiting for its output to be calculated?
+    bool mealy_queued;
 
     MealyAtomic<ValueType, TimeType>* isMealyAtomic() { return this; }
 };
@@ -504,6 +599,7 @@ class Coupled {
     std::set<std::pair<pin_t, pin_t>> pin_to_pin;
 
     void assign_to_graph(Graph<ValueType, TimeType>* graph);
+    void collect(Graph<ValueType, TimeType>* graph, GraphBuilder<ValueType, TimeType> &builder);
     void remove_from_graph();
 };
 
@@ -543,18 +639,27 @@ void Coupled<ValueType, TimeType>::remove_coupling(pin_t src, pin_t dst) {
 
 template <typename ValueType, typename TimeType>
 void Coupled<ValueType, TimeType>::assign_to_graph(Graph<ValueType, TimeType>* graph) {
+    // Gather the whole hierarchy and add it to the graph at once
+    GraphBuilder<ValueType, TimeType> builder;
+    collect(graph, builder);
+    builder.build(*graph);
+}
+
+template <typename ValueType, typename TimeType>
+void Coupled<ValueType, TimeType>::collect(Graph<ValueType, TimeType>* graph,
+                                           GraphBuilder<ValueType, TimeType> &builder) {
     g = graph;
-    for (auto atomic : atomic_components) {
-        g->add_atomic(atomic);
+    for (auto const &atomic : atomic_components) {
+        builder.add_atomic(atomic);
     }
-    for (auto coupling : pin_to_atomic) {
-        g->connect(coupling.first, coupling.second);
+    for (auto const &coupling : pin_to_atomic) {
+        builder.connect(coupling.first, coupling.second);
     }
-    for (auto coupling : pin_to_pin) {
-        g->connect(coupling.first, coupling.second);
+    for (auto const &coupling : pin_to_pin) {
+        builder.connect(coupling.first, coupling.second);
     }
-    for (auto coupled : coupled_components) {
-        coupled->assign_to_graph(g);
+    for (auto const &coupled : coupled_components) {
+        coupled->collect(g, builder);
     }
 }
 
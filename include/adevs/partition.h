@@ -0,0 +1,565 @@
+
+/*
+ * Copyright (c) 2025, James Nutaro
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ *
+ * Bugs, comments, and questions can be sent to nutaro@gmail.com
+ */
+#ifndef _adevs_partition_h_
+#define _adevs_partition_h_
+#include <algorithm>
+#include <any>
+#include <map>
+#include <memory>
+#include <queue>
+#include <random>
+#include <utility>
+#include <vector>
+#include "adevs/exception.h"
+#include "adevs/graph.h"
+
+namespace adevs {
+
+/**
+ * @brief Splits the models in a Graph into balanced partitions.
+ *
+ * The Partitioner assigns each Atomic model in a Graph to one of k
+ * partitions so that the partitions have nearly equal weight and the
+ * total weight of the edges between partitions is small. It is a
+ * multilevel partitioner in the style of METIS. The graph of models
+ * and pins is coarsened by collapsing heavy edges, the smallest
+ * graph is partitioned by growing regions, and the partition is
+ * projected back to the original graph and refined at each level
+ * by moving vertices that are on the boundary between partitions.
+ *
+ * The pins in the Graph become vertices with no weight. Because the
+ * Graph does not know which model produces values on a pin, pins
+ * that are output by a model should be attached to that model with
+ * set_owner() so that a cut between them is avoided.
+ *
+ * By default every model has a weight of one and every edge has a
+ * weight equal to the number of times it was added to the Graph.
+ * Measured rates of events and messages can be supplied to replace
+ * these defaults.
+ *
+ * @tparam ValueType The type of value exchanged by models in the Graph.
+ * @tparam TimeType The type used for time.
+ */
+template <typename ValueType = std::any, typename TimeType = double>
+class Partitioner {
+  public:
+    /// @brief The partition of each model.
+    using partition_map = std::map<Atomic<ValueType, TimeType>*, int>;
+    /// @brief Create a partitioner with the default weights.
+    Partitioner() : tolerance(1.05), seed(1), cut(0.0) {}
+    /**
+     * @brief Set the weight of a model.
+     *
+     * @param model The model.
+     * @param events The weight of the model, usually its rate of events.
+     */
+    void set_model_weight(std::shared_ptr<Atomic<ValueType, TimeType>> const &model,
+                          double events) {
+        model_weight[model.get()] = events;
+    }
+    /**
+     * @brief Set the weight of an edge from a pin to a pin.
+     *
+     * @param src The source pin.
+     * @param dst The destination pin.
+     * @param messages The weight of the edge, usually its rate of messages.
+     */
+    void set_edge_weight(pin_t src, pin_t dst, double messages) {
+        pin_edge_weight[std::make_pair(src, dst)] = messages;
+    }
+    /**
+     * @brief Set the weight of an edge from a pin to a model.
+     *
+     * @param src The source pin.
+     * @param dst The destination model.
+     * @param messages The weight of the edge, usually its rate of messages.
+     */
+    void set_edge_weight(pin_t src, std::shared_ptr<Atomic<ValueType, TimeType>> const &dst,
+                         double messages) {
+        atomic_edge_weight[std::make_pair(src, dst.get())] = messages;
+    }
+    /**
+     * @brief Attach a pin to a model so that they are always in the same partition.
+     *
+     * @param pin The pin, usually an output of the model.
+     * @param model The model that owns the pin.
+     */
+    void set_owner(pin_t pin, std::shared_ptr<Atomic<ValueType, TimeType>> const &model) {
+        owner[pin] = model.get();
+    }
+    /**
+     * @brief Set the allowed imbalance.
+     *
+     * @param tolerance No partition may weigh more than tolerance times the
+     * average weight of a partition if that can be avoided. The default is 1.05.
+     */
+    void set_imbalance(double tolerance) { this->tolerance = tolerance; }
+    /// @brief Set the seed for the random choices made by the partitioner.
+    void set_seed(unsigned int seed) { this->seed = seed; }
+    /**
+     * @brief Partition the models in a Graph.
+     *
+     * The models are numbered in the order of their addresses, which
+     * can change from one run to the next. Use the other partition()
+     * method to get the same partition of the same Graph every time.
+     *
+     * @param graph The Graph to partition.
+     * @param parts The number of partitions.
+     * @return The partition, from zero to parts-1, of each model in the Graph.
+     */
+    partition_map partition(Graph<ValueType, TimeType> const &graph, int parts);
+    /**
+     * @brief Partition the models in a Graph that are numbered in a given order.
+     *
+     * The random choices of the partitioner depend only on the seed, the
+     * order of the models, and the order in which pins were created and
+     * connected. A Graph that is built in the same way with the models
+     * listed in the same order, such as the order in which they were
+     * added, gets the same partition.
+     *
+     * @param graph The Graph to partition.
+     * @param parts The number of partitions.
+     * @param order Each model in the Graph listed once.
+     * @return The partition, from zero to parts-1, of each model in the Graph.
+     */
+    partition_map partition(Graph<ValueType, TimeType> const &graph, int parts,
+                            std::vector<std::shared_ptr<Atomic<ValueType, TimeType>>> const &order);
+    /// @brief Get the total weight of the edges cut by the last partition.
+    double get_cut() const { return cut; }
+
+  private:
+    // A weighted, undirected graph in compressed row format
+    struct level {
+        std::vector<size_t> xadj, adj;
+        std::vector<double> ewgt, vwgt;
+        // The vertex in the next coarser level
+        std::vector<size_t> cmap;
+        size_t size() const { return vwgt.size(); }
+    };
+
+    double tolerance;
+    unsigned int seed;
+    double cut;
+    std::map<Atomic<ValueType, TimeType>*, double> model_weight;
+    std::map<std::pair<pin_t, pin_t>, double> pin_edge_weight;
+    std::map<std::pair<pin_t, Atomic<ValueType, TimeType>*>, double> atomic_edge_weight;
+    std::map<pin_t, Atomic<ValueType, TimeType>*> owner;
+
+    static level make_level(size_t n, std::map<std::pair<size_t, size_t>, double> const &edges,
+                            std::vector<double> &&vwgt);
+    static bool coarsen(level &fine, level &coarse, double max_vwgt, std::mt19937 &rng);
+    static void grow(level const &g, int parts, double target, std::mt19937 &rng,
+                     std::vector<int> &part);
+    static void refine(level const &g, int parts, double max_pwgt, std::mt19937 &rng,
+                       std::vector<int> &part);
+    static double cut_weight(level const &g, std::vector<int> const &part);
+};
+
+template <typename ValueType, typename TimeType>
+typename Partitioner<ValueType, TimeType>::partition_map
+Partitioner<ValueType, TimeType>::partition(Graph<ValueType, TimeType> const &graph, int parts) {
+    std::vector<std::shared_ptr<Atomic<ValueType, TimeType>>> order(graph.models.begin(),
+                                                                    graph.models.end());
+    return partition(graph, parts, order);
+}
+
+template <typename ValueType, typename TimeType>
+typename Partitioner<ValueType, TimeType>::partition_map Partitioner<ValueType, TimeType>::partition(
+    Graph<ValueType, TimeType> const &graph, int parts,
+    std::vector<std::shared_ptr<Atomic<ValueType, TimeType>>> const &order) {
+    partition_map result;
+    cut = 0.0;
+    // Number the models first and then the pins that are not owned by a model
+    std::map<Atomic<ValueType, TimeType>*, size_t> model_index;
+    std::map<pin_t, size_t> pin_index;
+    std::vector<double> vwgt;
+    for (auto const &model : order) {
+        if (graph.models.find(model) == graph.models.end() ||
+            !model_index.emplace(model.get(), vwgt.size()).second) {
+            throw adevs::exception("The order of models does not match the Graph", model.get());
+        }
+        auto iter = model_weight.find(model.get());
+        vwgt.push_back((iter == model_weight.end()) ? 1.0 : iter->second);
+    }
+    if (model_index.size() != graph.models.size()) {
+        throw adevs::exception("The order of models does not match the Graph");
+    }
+    if (vwgt.empty()) {
+        return result;
+    }
+    auto index_of = [&](pin_t pin) {
+        auto owned = owner.find(pin);
+        if (owned != owner.end()) {
+            auto iter = model_index.find(owned->second);
+            if (iter != model_index.end()) {
+                return iter->second;
+            }
+        }
+        auto iter = pin_index.find(pin);
+        if (iter != pin_index.end()) {
+            return iter->second;
+        }
+        vwgt.push_back(0.0);
+        return pin_index[pin] = vwgt.size() - 1;
+    };
+    std::map<std::pair<size_t, size_t>, double> edges;
+    auto add_edge = [&](size_t u, size_t v, double w) {
+        if (u != v) {
+            edges[std::make_pair(std::min(u, v), std::max(u, v))] += w;
+        }
+    };
+    for (auto const &src : graph.pin_to_pin) {
+        for (auto const &dst : src.second) {
+            auto iter = pin_edge_weight.find(std::make_pair(src.first, dst.first));
+            double w = (iter == pin_edge_weight.end()) ? double(dst.second) : iter->second;
+            add_edge(index_of(src.first), index_of(dst.first), w);
+        }
+    }
+    for (auto const &src : graph.pin_to_atomic) {
+        for (auto const &dst : src.second) {
+            auto model = model_index.find(dst.first.get());
+            if (model == model_index.end()) {
+                continue;
+            }
+            auto iter = atomic_edge_weight.find(std::make_pair(src.first, dst.first.get()));
+            double w = (iter == atomic_edge_weight.end()) ? double(dst.second) : iter->second;
+            add_edge(index_of(src.first), model->second, w);
+        }
+    }
+    size_t const n = vwgt.size();
+    std::vector<int> part(n, 0);
+    if (parts > 1) {
+        std::mt19937 rng(seed);
+        double total = 0.0, heaviest = 0.0;
+        for (double w : vwgt) {
+            total += w;
+            heaviest = std::max(heaviest, w);
+        }
+        double const target = total / parts;
+        double const max_pwgt = std::max(tolerance * target, heaviest);
+        // Coarsen until the graph is small or stops shrinking
+        std::vector<level> levels(1);
+        levels[0] = make_level(n, edges, std::move(vwgt));
+        edges.clear();
+        size_t const small = std::max<size_t>(20 * size_t(parts), 100);
+        double const max_vwgt = std::max(total / (4.0 * parts), heaviest);
+        while (levels.back().size() > small) {
+            level coarse;
+            if (!coarsen(levels.back(), coarse, max_vwgt, rng)) {
+                break;
+            }
+            levels.push_back(std::move(coarse));
+        }
+        // Keep the best of several initial partitions
+        level const &coarsest = levels.back();
+        std::vector<int> best;
+        double best_cut = 0.0;
+        for (int trial = 0; trial < 4; trial++) {
+            std::vector<int> trial_part;
+            grow(coarsest, parts, target, rng, trial_part);
+            refine(coarsest, parts, max_pwgt, rng, trial_part);
+            double trial_cut = cut_weight(coarsest, trial_part);
+            if (best.empty() || trial_cut < best_cut) {
+                best_cut = trial_cut;
+                best.swap(trial_part);
+            }
+        }
+        // Project back to the original graph
+        for (size_t k = levels.size() - 1; k > 0; k--) {
+            level const &fine = levels[k - 1];
+            std::vector<int> fine_part(fine.size());
+            for (size_t v = 0; v < fine.size(); v++) {
+                fine_part[v] = best[fine.cmap[v]];
+            }
+            refine(fine, parts, max_pwgt, rng, fine_part);
+            best.swap(fine_part);
+        }
+        part.swap(best);
+        cut = cut_weight(levels[0], part);
+    }
+    for (auto const &model : model_index) {
+        result[model.first] = part[model.second];
+    }
+    return result;
+}
+
+template <typename ValueType, typename TimeType>
+typename Partitioner<ValueType, TimeType>::level Partitioner<ValueType, TimeType>::make_level(
+    size_t n, std::map<std::pair<size_t, size_t>, double> const &edges,
+    std::vector<double> &&vwgt) {
+    level g;
+    g.vwgt = std::move(vwgt);
+    g.xadj.assign(n + 1, 0);
+    for (auto const &e : edges) {
+        g.xadj[e.first.first + 1]++;
+        g.xadj[e.first.second + 1]++;
+    }
+    for (size_t v = 0; v < n; v++) {
+        g.xadj[v + 1] += g.xadj[v];
+    }
+    g.adj.resize(g.xadj[n]);
+    g.ewgt.resize(g.xadj[n]);
+    std::vector<size_t> next(g.xadj.begin(), g.xadj.end() - 1);
+    for (auto const &e : edges) {
+        size_t u = e.first.first, v = e.first.second;
+        g.adj[next[u]] = v;
+        g.ewgt[next[u]++] = e.second;
+        g.adj[next[v]] = u;
+        g.ewgt[next[v]++] = e.second;
+    }
+    return g;
+}
+
+template <typename ValueType, typename TimeType>
+bool Partitioner<ValueType, TimeType>::coarsen(level &fine, level &coarse, double max_vwgt,
+                                               std::mt19937 &rng) {
+    size_t const n = fine.size();
+    size_t const none = n;
+    std::vector<size_t> order(n), match(n, none);
+    for (size_t v = 0; v < n; v++) {
+        order[v] = v;
+    }
+    std::shuffle(order.begin(), order.end(), rng);
+    // Match each vertex with the neighbor that shares its heaviest edge
+    for (size_t v : order) {
+        if (match[v] != none) {
+            continue;
+        }
+        size_t best = v;
+        double best_wgt = -1.0;
+        for (size_t i = fine.xadj[v]; i < fine.xadj[v + 1]; i++) {
+            size_t u = fine.adj[i];
+            if (match[u] == none && fine.vwgt[u] + fine.vwgt[v] <= max_vwgt &&
+                fine.ewgt[i] > best_wgt) {
+                best = u;
+                best_wgt = fine.ewgt[i];
+            }
+        }
+        match[v] = best;
+        match[best] = v;
+    }
+    fine.cmap.assign(n, none);
+    size_t cn = 0;
+    for (size_t v : order) {
+        if (fine.cmap[v] == none) {
+            fine.cmap[v] = fine.cmap[match[v]] = cn++;
+        }
+    }
+    if (double(cn) > 0.95 * double(n)) {
+        fine.cmap.clear();
+        return false;
+    }
+    // Merge the edges of matched vertices
+    coarse.vwgt.assign(cn, 0.0);
+    coarse.xadj.assign(cn + 1, 0);
+    std::vector<size_t> members(n), first(cn + 1, 0);
+    for (size_t v = 0; v < n; v++) {
+        coarse.vwgt[fine.cmap[v]] += fine.vwgt[v];
+        first[fine.cmap[v] + 1]++;
+    }
+    for (size_t c = 0; c < cn; c++) {
+        first[c + 1] += first[c];
+    }
+    std::vector<size_t> next(first.begin(), first.end() - 1);
+    for (size_t v = 0; v < n; v++) {
+        members[next[fine.cmap[v]]++] = v;
+    }
+    std::vector<size_t> slot(cn, none);
+    for (size_t c = 0; c < cn; c++) {
+        size_t const start = coarse.adj.size();
+        for (size_t m = first[c]; m < first[c + 1]; m++) {
+            size_t v = members[m];
+            for (size_t i = fine.xadj[v]; i < fine.xadj[v + 1]; i++) {
+                size_t u = fine.cmap[fine.adj[i]];
+                if (u == c) {
+                    continue;
+                }
+                if (slot[u] == none) {
+                    slot[u] = coarse.adj.size();
+                    coarse.adj.push_back(u);
+                    coarse.ewgt.push_back(0.0);
+                }
+                coarse.ewgt[slot[u]] += fine.ewgt[i];
+            }
+        }
+        for (size_t i = start; i < coarse.adj.size(); i++) {
+            slot[coarse.adj[i]] = none;
+        }
+        coarse.xadj[c + 1] = coarse.adj.size();
+    }
+    return true;
+}
+
+template <typename ValueType, typename TimeType>
+void Partitioner<ValueType, TimeType>::grow(level const &g, int parts, double target,
+                                            std::mt19937 &rng, std::vector<int> &part) {
+    size_t const n = g.size();
+    std::vector<size_t> order(n);
+    for (size_t v = 0; v < n; v++) {
+        order[v] = v;
+    }
+    std::shuffle(order.begin(), order.end(), rng);
+    // The last partition gets whatever is left over
+    part.assign(n, parts - 1);
+    std::vector<bool> placed(n, false);
+    std::vector<double> gain(n, 0.0);
+    size_t next_seed = 0;
+    for (int p = 0; p < parts - 1; p++) {
+        double weight = 0.0;
+        // Vertices next to the region ordered by the strength of their tie to it.
+        // Entries whose gain has changed since they were pushed are skipped.
+        std::priority_queue<std::pair<double, size_t>> frontier;
+        std::vector<size_t> reached;
+        while (weight < target) {
+            while (!frontier.empty() && (placed[frontier.top().second] ||
+                                         frontier.top().first != gain[frontier.top().second])) {
+                frontier.pop();
+            }
+            size_t v;
+            if (!frontier.empty()) {
+                v = frontier.top().second;
+                frontier.pop();
+            } else {
+                // Start a new region when the frontier is empty
+                while (next_seed < n && placed[order[next_seed]]) {
+                    next_seed++;
+                }
+                if (next_seed == n) {
+                    break;
+                }
+                v = order[next_seed];
+            }
+            placed[v] = true;
+            part[v] = p;
+            weight += g.vwgt[v];
+            for (size_t i = g.xadj[v]; i < g.xadj[v + 1]; i++) {
+                size_t u = g.adj[i];
+                if (!placed[u]) {
+                    reached.push_back(u);
+                    gain[u] += g.ewgt[i];
+                    frontier.push(std::make_pair(gain[u], u));
+                }
+            }
+        }
+        for (size_t v : reached) {
+            gain[v] = 0.0;
+        }
+    }
+}
+
+template <typename ValueType, typename TimeType>
+void Partitioner<ValueType, TimeType>::refine(level const &g, int parts, double max_pwgt,
+                                              std::mt19937 &rng, std::vector<int> &part) {
+    size_t const n = g.size();
+    std::vector<double> pwgt(parts, 0.0), conn(parts, 0.0);
+    for (size_t v = 0; v < n; v++) {
+        pwgt[part[v]] += g.vwgt[v];
+    }
+    std::vector<size_t> order(n);
+    for (size_t v = 0; v < n; v++) {
+        order[v] = v;
+    }
+    std::vector<int> touched;
+    for (int pass = 0; pass < 8; pass++) {
+        std::shuffle(order.begin(), order.end(), rng);
+        bool moved = false;
+        for (size_t v : order) {
+            int const p = part[v];
+            bool boundary = false;
+            for (size_t i = g.xadj[v]; i < g.xadj[v + 1]; i++) {
+                int q = part[g.adj[i]];
+                if (conn[q] == 0.0) {
+                    touched.push_back(q);
+                }
+                conn[q] += g.ewgt[i];
+                boundary = boundary || q != p;
+            }
+            bool const overweight = pwgt[p] > max_pwgt;
+            if (boundary || overweight) {
+                // Find the move that most reduces the cut and keeps the balance
+                int best = p;
+                double best_gain = 0.0;
+                auto consider = [&](int q) {
+                    if (q == p || pwgt[q] + g.vwgt[v] > max_pwgt) {
+                        return;
+                    }
+                    double gain = conn[q] - conn[p];
+                    if (best == p ? (gain > 0.0 || overweight ||
+                                     (gain == 0.0 && pwgt[q] + g.vwgt[v] < pwgt[p]))
+                                  : (gain > best_gain ||
+                                     (gain == best_gain && pwgt[q] < pwgt[best]))) {
+                        best = q;
+                        best_gain = gain;
+                    }
+                };
+                for (int q : touched) {
+                    consider(q);
+                }
+                if (overweight && best == p) {
+                    for (int q = 0; q < parts; q++) {
+                        consider(q);
+                    }
+                }
+                if (best != p) {
+                    part[v] = best;
+                    pwgt[p] -= g.vwgt[v];
+                    pwgt[best] += g.vwgt[v];
+                    moved = true;
+                }
+            }
+            for (int q : touched) {
+                conn[q] = 0.0;
+            }
+            touched.clear();
+        }
+        if (!moved) {
+            break;
+        }
+    }
+}
+
+template <typename ValueType, typename TimeType>
+double Partitioner<ValueType, TimeType>::cut_weight(level const &g, std::vector<int> const &part) {
+    double result = 0.0;
+    for (size_t v = 0; v < g.size(); v++) {
+        for (size_t i = g.xadj[v]; i < g.xadj[v + 1]; i++) {
+            if (part[v] != part[g.adj[i]]) {
+                result += g.ewgt[i];
+            }
+        }
+    }
+    return result / 2.0;
+}
+
+}  // namespace adevs
+
+#endif
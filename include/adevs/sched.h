@@ -62,7 +62,13 @@ class Schedule {
     /// Visit the imminent models.
     std::list<Atomic<ValueType, TimeType>*> visitImminent(void) {
         activated.clear();
-        visitImminent(1);
+        visitImminent(1, heap[1].priority);
+        return activated;
+    }
+    /// Visit the models with a priority that is not greater than the horizon.
+    std::list<Atomic<ValueType, TimeType>*> visitImminent(TimeType horizon) {
+        activated.clear();
+        visitImminent(1, horizon);
         return activated;
     }
     /// Remove the model at the front of the queue.
@@ -97,7 +103,7 @@ class Schedule {
     unsigned int percolate_up(unsigned int index, TimeType priority);
     /// Visit the imminent set recursively
     // void visitImminent(ImminentVisitor* visitor, unsigned int root) const;
-    void visitImminent(unsigned int root);
+    void visitImminent(unsigned int root, TimeType const &horizon);
 
     void visit(Atomic<ValueType, TimeType>* model);
 };
@@ -109,18 +115,18 @@ void Schedule<ValueType, TimeType>::visit(Atomic<ValueType, TimeType>* model) {
 }
 
 template <class ValueType, class TimeType>
-void Schedule<ValueType, TimeType>::visitImminent(unsigned int root) {
-    // Stop if the bottom is reached or the next priority is not equal to the minimum
-    if (root > size || heap[1].priority < heap[root].priority) {
+void Schedule<ValueType, TimeType>::visitImminent(unsigned int root, TimeType const &horizon) {
+    // Stop if the bottom is reached or the next priority is beyond the horizon
+    if (root > size || horizon < heap[root].priority) {
         return;
     }
 
     visit(heap[root].item);
 
     // Look for more imminent models in the left sub-tree
-    visitImminent(root * 2);
+    visitImminent(root * 2, horizon);
     // Look in the right sub-tree
-    visitImminent(root * 2 + 1);
+    visitImminent(root * 2 + 1, horizon);
 }
 
 template <class ValueType, class TimeType>
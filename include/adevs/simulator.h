@@ -32,12 +32,23 @@
 #ifndef _adevs_simulator_h_
 #define _adevs_simulator_h_
 
+#include <algorithm>
 #include <any>
 #include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <limits>
 #include <list>
 #include <memory>
+#include <queue>
 #include <set>
+#include <utility>
+#include <vector>
+#include "adevs/cold_store.h"
 #include "adevs/graph.h"
+#include "adevs/graph_builder.h"
 #include "adevs/models.h"
 #include "adevs/sched.h"
 
@@ -123,10 +134,13 @@ class EventListener {
  *     -# For each PinValue pair in the output list, use the Graph::route() method to find
  * the models that receive this value as input. The receiving models that are not
  * MealyAtomic go into the active set. The MealyAtomic receivers go into the pending set.
- * If a MealyAtomic model that is already in the active set is added to the pending set
- * then an exception is thrown and the simulation is aborted.
  *     -# If the pending set is empty, then go to step 5.
- *     -# Select a MealyAtomic model from the pending set and move it to the active set.
+ *     -# Select the MealyAtomic model from the pending set that comes first in a
+ * topological ordering of the MealyAtomic models and move it to the active set. This
+ * ordering puts every MealyAtomic model after the MealyAtomic models that can send it input.
+ * It is calculated when the Simulator is created and again after the structure of the Graph
+ * changes. An exception is thrown and the simulation is aborted if the
+ * MealyAtomic models form a cycle.
  *     -# Call the selected model's output function to get a new output list
  *         - If the model has received no input and is imminent, call MealyAtomic::output_func()
  *         - If the model has received input and is imminent, call MealyAtomic::confluent_output_func()
@@ -227,6 +241,150 @@ class Simulator {
         return computeNextState();
     }
 
+    /**
+     * @brief Execute every event at or before a time.
+     *
+     * This is equivalent to calling execNextEvent() while nextEventTime()
+     * is not greater than tEnd, but the loop runs inside the Simulator.
+     * The run stops early if the wall clock limit is exceeded.
+     *
+     * @param tEnd The time of the last event to execute.
+     * @return The number of events that were executed.
+     */
+    size_t run_until(TimeType tEnd) {
+        return run([tEnd](TimeType t) { return !(tEnd < t); }, std::numeric_limits<size_t>::max());
+    }
+
+    /**
+     * @brief Execute a fixed number of events.
+     *
+     * The run stops early if the next event time is at infinity or if
+     * the wall clock limit is exceeded.
+     *
+     * @param n The number of events to execute.
+     * @return The number of events that were executed.
+     */
+    size_t run_events(size_t n) {
+        return run([](TimeType) { return true; }, n);
+    }
+
+    /**
+     * @brief Execute events while a condition is true.
+     *
+     * The predicate is called with nextEventTime() before each event and
+     * the run stops when it returns false, when the next event time is at
+     * infinity, or when the wall clock limit is exceeded.
+     *
+     * @param pred A callable object that accepts a TimeType and returns a bool.
+     * @return The number of events that were executed.
+     */
+    template <class Predicate>
+    size_t run_while(Predicate pred) {
+        return run(pred, std::numeric_limits<size_t>::max());
+    }
+
+    /**
+     * @brief Limit the wall clock time used by run_until(), run_events(),
+     * and run_while().
+     *
+     * The clock is checked every few events and the run stops between
+     * events once the limit is exceeded. This leaves the simulation in a
+     * consistent state that can be continued later. The limit applies to
+     * each call separately.
+     *
+     * @param limit The largest amount of wall clock time for a run.
+     */
+    void set_wall_clock_limit(std::chrono::steady_clock::duration limit) {
+        wall_clock_limit = limit;
+    }
+
+    /**
+     * @brief Check if the last run stopped because of the wall clock limit.
+     *
+     * @return True if the last run was stopped by the limit.
+     */
+    bool wall_clock_expired() const { return wall_clock_stop; }
+
+    /**
+     * @brief Merge events that are nearly simultaneous.
+     *
+     * When the granule is greater than zero, every model with an event
+     * at a time no later than nextEventTime() plus the granule is treated
+     * as imminent at nextEventTime(). These models produce output and change
+     * state in the same cycle, which reduces the number of cycles when
+     * many events occur at slightly different times. This is the threshold
+     * of simultaneity described in <a href = "https://dl.acm.org/doi/10.1145/268823.268901">
+     * "The threshold of event simultaneity"</a>. A granule of zero, which is
+     * the default, gives the usual simulation algorithm.
+     *
+     * @param granule Events this close to the next event time are merged with it.
+     */
+    void set_time_granule(TimeType granule) { time_granule = granule; }
+
+    /// @brief Get the time granule used to merge events.
+    TimeType get_time_granule() const { return time_granule; }
+
+    /**
+     * @brief Get the number of events that were moved to an earlier time
+     * by merging them with the next event.
+     *
+     * @return The number of internal or confluent events that were executed
+     * before their scheduled time because they were within the time granule.
+     */
+    size_t merged_events() const { return merged_event_count; }
+
+    /**
+     * @brief Get the number of cycles in which events were merged.
+     *
+     * @return The number of simulation cycles with at least one merged event.
+     */
+    size_t merged_cycles() const { return merged_cycle_count; }
+
+    /**
+     * @brief Limit the depth of zero time cascades.
+     *
+     * A zero time cascade is a sequence of cycles in which models with
+     * a time advance of zero are activated again at the same time.
+     * If a cascade becomes deeper than the limit then computeNextState()
+     * throws an adevs::exception that names one of the models in the
+     * cascade. This is useful for finding models that loop forever
+     * without advancing time. The default of zero sets no limit.
+     *
+     * @param limit The largest allowed depth or zero for no limit.
+     */
+    void set_cascade_limit(size_t limit) { cascade_limit = limit; }
+
+    /// @brief Get the number of zero time cascades that have started.
+    size_t zero_time_cascades() const { return cascade_count; }
+
+    /// @brief Get the number of cycles that were part of a zero time cascade.
+    size_t cascade_cycles() const { return cascade_cycle_count; }
+
+    /// @brief Get the depth of the deepest zero time cascade.
+    size_t max_cascade_depth() const { return cascade_max_depth; }
+
+    /**
+     * @brief Set the store that holds models removed by compact().
+     *
+     * @param store The ColdStore for dormant models.
+     */
+    void set_cold_store(std::shared_ptr<ColdStore<ValueType, TimeType>> store) {
+        cold_store = store;
+    }
+
+    /**
+     * @brief Move dormant models into the cold store.
+     *
+     * Every model that has a time advance of infinity, is not a MealyAtomic,
+     * and is not waiting for input in the current cycle is offered to the
+     * ColdStore. The models that it accepts are removed from the Graph and
+     * are restored when input is routed to them. This should be called
+     * between simulation cycles.
+     *
+     * @return The number of models moved into the cold store.
+     */
+    size_t compact();
+
     /**
      * @brief Inject an event into the simulation.
      * 
@@ -238,6 +396,16 @@ class Simulator {
      */
     void injectInput(PinValue<ValueType> &x) { external_input.push_back(x); }
 
+    /**
+     * @brief Inject an event into the simulation without copying it.
+     *
+     * As injectInput(PinValue<ValueType>&), but the value is moved into the
+     * Simulator.
+     *
+     * @param x The PinValue to inject into the simulation.
+     */
+    void injectInput(PinValue<ValueType> &&x) { external_input.push_back(std::move(x)); }
+
     /**
      * @brief Clear the list of injected inputs.
      * 
@@ -298,225 +466,443 @@ class Simulator {
     std::shared_ptr<Graph<ValueType, TimeType>> graph;
     std::list<std::shared_ptr<EventListener<ValueType, TimeType>>> listeners;
     std::list<PinValue<ValueType>> external_input;
-    std::set<Atomic<ValueType, TimeType>*> active;
-    std::set<MealyAtomic<ValueType, TimeType>*> orphaned;
+    // Scratch space for the results of Graph::route()
+    typename Graph<ValueType, TimeType>::route_list input;
+    std::set<Atomic<ValueType, TimeType>*, std::less<Atomic<ValueType, TimeType>*>,
+             recycling_allocator<Atomic<ValueType, TimeType>*>>
+        active;
     Schedule<ValueType, TimeType> sched;
     TimeType tNext;
 
+    // Limit on the wall clock time of one run
+    std::chrono::steady_clock::duration wall_clock_limit;
+    bool wall_clock_stop;
+    // Number of events between checks of the wall clock
+    static constexpr size_t wall_clock_interval = 64;
+
+    // Events within this much of tNext are executed at tNext
+    TimeType time_granule;
+    size_t merged_event_count, merged_cycle_count;
+    // Models moved to tNext by the granule and their original event times
+    std::vector<std::pair<Atomic<ValueType, TimeType>*, TimeType>> merged;
+
+    // Models with a time advance of zero. These are kept out of the
+    // schedule because they are imminent in the next cycle.
+    std::vector<Atomic<ValueType, TimeType>*> cascade;
+    size_t cascade_limit, cascade_depth, cascade_count, cascade_cycle_count, cascade_max_depth;
+
+    // Dormant models that have been removed from the Graph
+    std::shared_ptr<ColdStore<ValueType, TimeType>> cold_store;
+    std::vector<std::pair<std::shared_ptr<Atomic<ValueType, TimeType>>, TimeType>> woken;
+
+    template <class Predicate>
+    size_t run(Predicate pred, size_t max_events);
+
+    // The Mealy models in the graph
+    std::set<MealyAtomic<ValueType, TimeType>*> mealy_models;
+    // The Mealy models sorted so that each comes after its Mealy senders
+    std::vector<MealyAtomic<ValueType, TimeType>*> mealy_order;
+    bool mealy_order_valid;
+    // Mealy models that are imminent or have input from other models
+    std::vector<MealyAtomic<ValueType, TimeType>*> mealy_pending;
+    // Models with revisable input and models made active by Mealy output.
+    // These are used to undo the Mealy output calculation.
+    std::vector<Atomic<ValueType, TimeType>*> mealy_receivers, mealy_activated;
+
     void schedule(Atomic<ValueType, TimeType>* model, TimeType t);
-    void calculate_mealy_output(
-        std::set<MealyAtomic<ValueType,TimeType>*>& path, MealyAtomic<ValueType,TimeType>* root);
-    void retract_mealy_output(MealyAtomic<ValueType,TimeType>* root);
+    TimeType next_event_time() const {
+        return (cascade.empty()) ? sched.minPriority() : cascade.front()->tN;
+    }
+    void imminent_output(Atomic<ValueType, TimeType>* model);
+    void route_input(PinValue<ValueType> &y);
+    void route(pin_t pin);
+    void add_mealy_model(Atomic<ValueType, TimeType>* model);
+    void build_mealy_order();
+    bool in_mealy_order(MealyAtomic<ValueType, TimeType>* model) const {
+        return model->mealy_rank < mealy_order.size() && mealy_order[model->mealy_rank] == model;
+    }
+    void calculate_mealy_output();
+    bool route_mealy_output(
+        MealyAtomic<ValueType, TimeType>* src,
+        std::priority_queue<unsigned int, std::vector<unsigned int>, std::greater<unsigned int>>
+            &pending);
 };
 
 template <typename ValueType, typename TimeType>
 Simulator<ValueType, TimeType>::Simulator(std::shared_ptr<Graph<ValueType, TimeType>> model)
-    : graph(model) {
+    : graph(model), wall_clock_limit(std::chrono::steady_clock::duration::max()),
+      wall_clock_stop(false),
+      time_granule(adevs_zero<TimeType>()),
+      merged_event_count(0),
+      merged_cycle_count(0),
+      cascade_limit(0),
+      cascade_depth(0),
+      cascade_count(0),
+      cascade_cycle_count(0),
+      cascade_max_depth(0),
+      mealy_order_valid(false) {
     graph->set_provisional(true);
     for (auto atomic : model->get_atomics()) {
+        add_mealy_model(atomic.get());
         schedule(atomic.get(), adevs_zero<TimeType>());
     }
-    tNext = sched.minPriority();
+    build_mealy_order();
+    tNext = next_event_time();
 }
 
 template <typename ValueType, typename TimeType>
 Simulator<ValueType, TimeType>::Simulator(std::shared_ptr<Atomic<ValueType, TimeType>> model)
-    : graph(new Graph<ValueType, TimeType>()) {
+    : graph(new Graph<ValueType, TimeType>()), wall_clock_limit(std::chrono::steady_clock::duration::max()),
+      wall_clock_stop(false),
+      time_granule(adevs_zero<TimeType>()),
+      merged_event_count(0),
+      merged_cycle_count(0),
+      cascade_limit(0),
+      cascade_depth(0),
+      cascade_count(0),
+      cascade_cycle_count(0),
+      cascade_max_depth(0),
+      mealy_order_valid(false) {
     graph->add_atomic(model);
     graph->set_provisional(true);
+    add_mealy_model(model.get());
     schedule(model.get(), adevs_zero<TimeType>());
-    tNext = sched.minPriority();
+    build_mealy_order();
+    tNext = next_event_time();
+}
+
+template <typename ValueType, typename TimeType>
+void Simulator<ValueType, TimeType>::add_mealy_model(Atomic<ValueType, TimeType>* model) {
+    if (model->isMealyAtomic() != nullptr) {
+        mealy_models.insert(model->isMealyAtomic());
+        mealy_order_valid = false;
+    }
 }
 
 template <typename ValueType, typename TimeType>
-void Simulator<ValueType, TimeType>::retract_mealy_output(
-    MealyAtomic<ValueType,TimeType>* root) {
-
-    auto iter = root->receivers.begin();
-    while (iter != root->receivers.end()) {
-        auto iter2 = (*iter)->revisable_inputs.begin();
-        while (iter2 != (*iter)->revisable_inputs.end()) {
-            if ((*iter2).first == root) {
-                iter2 = (*iter)->revisable_inputs.erase(iter2);
-            } else {
-                iter2++;
+void Simulator<ValueType, TimeType>::build_mealy_order() {
+    std::vector<MealyAtomic<ValueType, TimeType>*> models(mealy_models.begin(), mealy_models.end());
+    std::vector<std::vector<unsigned int>> receivers(models.size());
+    std::vector<unsigned int> in_degree(models.size(), 0);
+    mealy_order.clear();
+    mealy_order_valid = false;
+    // Use the rank to hold the index of the model while the order is calculated
+    for (unsigned int i = 0; i < models.size(); i++) {
+        models[i]->mealy_rank = i;
+    }
+    // Find the Mealy models that receive input from each Mealy model
+    for (unsigned int i = 0; i < models.size(); i++) {
+        for (auto pin : models[i]->output_pins) {
+            graph->route(pin, input);
+            for (auto const &consumer : input) {
+                MealyAtomic<ValueType, TimeType>* mealy = consumer.second->isMealyAtomic();
+                if (mealy != nullptr && mealy->mealy_rank < models.size() &&
+                    models[mealy->mealy_rank] == mealy) {
+                    receivers[i].push_back(mealy->mealy_rank);
+                    in_degree[mealy->mealy_rank]++;
+                }
             }
+            input.clear();
+        }
+    }
+    // Sort the models by repeatedly taking those that have no senders
+    for (unsigned int i = 0; i < models.size(); i++) {
+        if (in_degree[i] == 0) {
+            mealy_order.push_back(models[i]);
         }
-        if ((*iter)->isMealyAtomic() != nullptr) {
-            orphaned.insert((*iter)->isMealyAtomic());
-            retract_mealy_output((*iter)->isMealyAtomic());
+    }
+    for (unsigned int k = 0; k < mealy_order.size(); k++) {
+        for (auto j : receivers[mealy_order[k]->mealy_rank]) {
+            if (--in_degree[j] == 0) {
+                mealy_order.push_back(models[j]);
+            }
         }
-        iter = root->receivers.erase(iter);
     }
+    // Any model that is left over is part of a cycle
+    if (mealy_order.size() < models.size()) {
+        for (unsigned int i = 0; i < models.size(); i++) {
+            if (in_degree[i] > 0) {
+                mealy_order.clear();
+                throw adevs::exception("Cycles of Mealy models are illegal", models[i]);
+            }
+        }
+    }
+    for (unsigned int k = 0; k < mealy_order.size(); k++) {
+        mealy_order[k]->mealy_rank = k;
+    }
+    mealy_order_valid = true;
 }
 
 template <typename ValueType, typename TimeType>
-void Simulator<ValueType, TimeType>::calculate_mealy_output(
-    std::set<MealyAtomic<ValueType,TimeType>*>& path,
-    MealyAtomic<ValueType,TimeType>* root) {
-
-    PinValue<ValueType> x;
-    std::set<Atomic<ValueType, TimeType>*> retracted;
-    std::set<MealyAtomic<ValueType, TimeType>*> activated;
-    std::list<std::pair<pin_t, std::shared_ptr<Atomic<ValueType, TimeType>>>> input;
-    active.insert(root);
-    orphaned.erase(root);
-    // Retract our previous output
-    retract_mealy_output(root);
-    // Clear the output list
-    root->outputs.clear();
-    // Gather the revisable input to this Mealy model
-    for (auto revisable_input: root->revisable_inputs) {
-        root->inputs.push_back(revisable_input.second);
-    }
-    if (root->inputs.empty()) {
-        if (root->tN == tNext) {
-            // Internal event
-            root->output_func(root->outputs);
-        } else {
-            // No input and not imminent so nothing to do
-            return;
-        }
-    } else if (root->tN == tNext) {
-        // Confluent event
-        root->confluent_output_func(root->inputs, root->outputs);
-    } else {
-        // External event
-        root->external_output_func(tNext - root->tL, root->inputs, root->outputs);
-    }
-    // Add us to the path for cycle detection
-    path.insert(root);
-    // Find all of the Mealy components that we touch
-    // and assign revisable output to receivers.
-    for (auto y : root->outputs) {
-        x.value = y.value;
-        graph->route(y.pin, input);
-        for (auto consumer : input) {
-            if (consumer.second->isMealyAtomic() != nullptr) {
-                activated.insert(consumer.second->isMealyAtomic());
-                if (path.find(consumer.second->isMealyAtomic()) != path.end()) {
-                    throw adevs::exception("Cycles of Mealy models are illegal", root);
+bool Simulator<ValueType, TimeType>::route_mealy_output(
+    MealyAtomic<ValueType, TimeType>* src,
+    std::priority_queue<unsigned int, std::vector<unsigned int>, std::greater<unsigned int>>
+        &pending) {
+    // The outputs are kept for the listeners and so each
+    // receiver gets a copy.
+    for (auto const &y : src->outputs) {
+        route(y.pin);
+        for (auto const &consumer : input) {
+            Atomic<ValueType, TimeType>* dst = consumer.second.get();
+            MealyAtomic<ValueType, TimeType>* mealy = dst->isMealyAtomic();
+            if (mealy != nullptr) {
+                // The receiver must come after us in the order. If it
+                // does not then the order is missing this pin.
+                if (!in_mealy_order(mealy) || mealy->mealy_rank <= src->mealy_rank) {
+                    input.clear();
+                    if (!src->output_pins.insert(y.pin).second) {
+                        throw adevs::exception("MealyAtomic receives input but is not in the Graph",
+                                               mealy);
+                    }
+                    return false;
+                }
+                if (!mealy->mealy_queued) {
+                    mealy->mealy_queued = true;
+                    pending.push(mealy->mealy_rank);
                 }
-            } else {
-                active.insert(consumer.second.get());
+            } else if (active.insert(dst).second) {
+                mealy_activated.push_back(dst);
+            }
+            if (dst->revisable_inputs.empty()) {
+                mealy_receivers.push_back(dst);
             }
-            // There are no cycles and so input from the root will
-            // not be retracted in the output retraction step.
-            x.pin = consumer.first;
-            consumer.second->revisable_inputs.push_back(
-                std::pair<Atomic<ValueType,TimeType>*,PinValue<ValueType>>(
-                    root,x));
-            root->receivers.insert(consumer.second.get());
+            dst->revisable_inputs.emplace_back(consumer.first, y.value);
         }
         input.clear();
     }
-    // Clear the input list
-    root->inputs.clear();
-    // Descend into the output tree
-    for (auto model: activated) {
-        calculate_mealy_output(path,model);
+    return true;
+}
+
+template <typename ValueType, typename TimeType>
+void Simulator<ValueType, TimeType>::calculate_mealy_output() {
+    std::priority_queue<unsigned int, std::vector<unsigned int>, std::greater<unsigned int>>
+        pending;
+    if (!mealy_order_valid) {
+        build_mealy_order();
+    }
+    for (auto model : mealy_pending) {
+        if (!in_mealy_order(model)) {
+            throw adevs::exception("MealyAtomic receives input but is not in the Graph", model);
+        }
+        pending.push(model->mealy_rank);
+    }
+    // Calculate output in order so that every model has all of its
+    // input before its output is calculated.
+    while (!pending.empty()) {
+        MealyAtomic<ValueType, TimeType>* model = mealy_order[pending.top()];
+        pending.pop();
+        model->mealy_queued = false;
+        bool const imminent = model->tN == tNext;
+        bool const has_revisable = !model->revisable_inputs.empty();
+        if (!imminent && !has_revisable && model->inputs.empty()) {
+            continue;
+        }
+        if (active.insert(model).second) {
+            mealy_activated.push_back(model);
+        }
+        // Append the input from other Mealy models to the input list
+        auto first = model->revisable_inputs.begin();
+        model->inputs.splice(model->inputs.end(), model->revisable_inputs);
+        if (model->inputs.empty()) {
+            // Internal event
+            model->output_func(model->outputs);
+        } else if (imminent) {
+            // Confluent event
+            model->confluent_output_func(model->inputs, model->outputs);
+        } else {
+            // External event
+            model->external_output_func(tNext - model->tL, model->inputs, model->outputs);
+        }
+        if (has_revisable) {
+            model->revisable_inputs.splice(model->revisable_inputs.end(), model->inputs, first,
+                                           model->inputs.end());
+        }
+        if (route_mealy_output(model, pending)) {
+            continue;
+        }
+        // A new pin was found that changes the order. Discard the output
+        // that was calculated, find the new order, and start again.
+        while (!pending.empty()) {
+            mealy_order[pending.top()]->mealy_queued = false;
+            pending.pop();
+        }
+        for (auto receiver : mealy_receivers) {
+            receiver->revisable_inputs.clear();
+        }
+        for (auto activated : mealy_activated) {
+            active.erase(activated);
+            activated->outputs.clear();
+        }
+        mealy_receivers.clear();
+        mealy_activated.clear();
+        build_mealy_order();
+        for (auto restart : mealy_pending) {
+            restart->mealy_queued = true;
+            pending.push(restart->mealy_rank);
+        }
     }
-    path.erase(root);
+    mealy_pending.clear();
+    mealy_receivers.clear();
+    mealy_activated.clear();
 }
 
 template <typename ValueType, typename TimeType>
 Simulator<ValueType, TimeType>::Simulator(std::shared_ptr<Coupled<ValueType, TimeType>> model)
-    : graph(new Graph<ValueType, TimeType>()) {
+    : graph(new Graph<ValueType, TimeType>()), wall_clock_limit(std::chrono::steady_clock::duration::max()),
+      wall_clock_stop(false),
+      time_granule(adevs_zero<TimeType>()),
+      merged_event_count(0),
+      merged_cycle_count(0),
+      cascade_limit(0),
+      cascade_depth(0),
+      cascade_count(0),
+      cascade_cycle_count(0),
+      cascade_max_depth(0),
+      mealy_order_valid(false) {
     model->assign_to_graph(graph.get());
     graph->set_provisional(true);
     for (auto atomic : graph->get_atomics()) {
+        add_mealy_model(atomic.get());
         schedule(atomic.get(), adevs_zero<TimeType>());
     }
-    tNext = sched.minPriority();
+    build_mealy_order();
+    tNext = next_event_time();
+}
+
+template <class ValueType, class TimeType>
+void Simulator<ValueType, TimeType>::route(pin_t pin) {
+    graph->route(pin, input);
+    if (!cold_store || cold_store->size() == 0) {
+        return;
+    }
+    // Restore dormant models that receive input and route again
+    for (auto const &consumer : input) {
+        if (consumer.second == cold_store->marker) {
+            cold_store->wake(consumer.first, *graph, woken);
+        }
+    }
+    if (woken.empty()) {
+        return;
+    }
+    for (auto const &model : woken) {
+        schedule(model.first.get(), model.second);
+    }
+    woken.clear();
+    input.clear();
+    graph->route(pin, input);
+}
+
+template <class ValueType, class TimeType>
+size_t Simulator<ValueType, TimeType>::compact() {
+    if (!cold_store) {
+        return 0;
+    }
+    std::vector<std::pair<std::shared_ptr<Atomic<ValueType, TimeType>>, TimeType>> dormant;
+    for (auto const &model : graph->get_atomics()) {
+        if (model->tN == adevs_inf<TimeType>() && model->isMealyAtomic() == nullptr &&
+            model->inputs.empty() && active.find(model.get()) == active.end()) {
+            dormant.push_back(std::make_pair(model, model->tL));
+        }
+    }
+    return cold_store->evict(*graph, dormant);
+}
+
+template <class ValueType, class TimeType>
+void Simulator<ValueType, TimeType>::route_input(PinValue<ValueType> &y) {
+    route(y.pin);
+    // Each receiver gets its own copy of the value except for the
+    // last, which takes the value from y. The caller must not use
+    // y.value after this.
+    auto last = input.empty() ? input.end() : std::prev(input.end());
+    for (auto consumer = input.begin(); consumer != input.end(); consumer++) {
+        PinValue<ValueType> x(consumer->first, (consumer == last) ? std::move(y.value) : y.value);
+        MealyAtomic<ValueType, TimeType>* mealy = consumer->second->isMealyAtomic();
+        if (mealy != nullptr && !mealy->mealy_queued) {
+            // Mealy models outputs are calculated after Moore models
+            // because the Mealy output may depend on the Moore output
+            mealy->mealy_queued = true;
+            mealy_pending.push_back(mealy);
+        } else if (mealy == nullptr) {
+            active.insert(consumer->second.get());
+        }
+        consumer->second->inputs.push_back(std::move(x));
+    }
+    input.clear();
+}
+
+template <class ValueType, class TimeType>
+void Simulator<ValueType, TimeType>::imminent_output(Atomic<ValueType, TimeType>* model) {
+    MealyAtomic<ValueType, TimeType>* mealy = model->isMealyAtomic();
+    if (mealy != nullptr) {
+        // Wait to calculate Mealy outputs until we have the
+        // output from all of the Moore models
+        if (!mealy->mealy_queued) {
+            mealy->mealy_queued = true;
+            mealy_pending.push_back(mealy);
+        }
+        return;
+    }
+    active.insert(model);
+    model->output_func(model->outputs);
+    for (auto &y : model->outputs) {
+        for (auto listener : listeners) {
+            listener->outputEvent(*model, y, tNext);
+        }
+        // The output is not needed after it is routed
+        route_input(y);
+    }
 }
 
 template <class ValueType, class TimeType>
 void Simulator<ValueType, TimeType>::computeNextOutput() {
-    PinValue<ValueType> x;
-    std::list<std::pair<pin_t, std::shared_ptr<Atomic<ValueType, TimeType>>>> input;
-    std::set<MealyAtomic<ValueType, TimeType>*> path;
     // Undo prior output calculation
     for (auto model : active) {
         model->outputs.clear();
         model->inputs.clear();
     }
     active.clear();
+    for (auto const &early : merged) {
+        early.first->tN = early.second;
+    }
+    merged.clear();
     // Route externally supplied inputs. This will not be revised.
-    for (auto y : external_input) {
-        x.value = y.value;
-        graph->route(y.pin, input);
-        for (auto consumer : input) {
-            x.pin = consumer.first;
-            if (consumer.second->isMealyAtomic() != nullptr) {
-                // Mealy models outputs are calculated after Moore models
-                // because the Mealy output may depend on the Moore output
-                orphaned.insert(consumer.second->isMealyAtomic());
-                consumer.second->revisable_inputs.push_back(
-                    std::pair<Atomic<ValueType,TimeType>*,PinValue<ValueType>>(
-                        nullptr,x));
-            } else {
-                active.insert(consumer.second.get());
-                consumer.second->inputs.push_back(x);
-            }
-        }
-        input.clear();
+    for (auto &y : external_input) {
+        route_input(y);
     }
     external_input.clear();
     // Route output from the Moore type imminent models. This output
     // will not be revised.
+    if (!cascade.empty() && cascade.front()->tN == tNext) {
+        for (auto model : cascade) {
+            imminent_output(model);
+        }
+    }
     if (sched.minPriority() == tNext) {
-        std::list<Atomic<ValueType, TimeType>*> imm(sched.visitImminent());
+        std::list<Atomic<ValueType, TimeType>*> imm(
+            (adevs_zero<TimeType>() < time_granule) ? sched.visitImminent(tNext + time_granule)
+                                                    : sched.visitImminent());
         for (auto model : imm) {
-            if (model->isMealyAtomic() != nullptr) {
-                // Wait to calculate Mealy outputs until we have the
-                // output from all of the Moore models
-                orphaned.insert(model->isMealyAtomic());
-                continue;
-            }
-            active.insert(model);
-            model->output_func(model->outputs);
-            for (auto y : model->outputs) {
-                for (auto listener : listeners) {
-                    listener->outputEvent(*model, y, tNext);
-                }
-                x.value = y.value;
-                graph->route(y.pin, input);
-                for (auto consumer : input) {
-                    x.pin = consumer.first;
-                    if (consumer.second->isMealyAtomic() != nullptr) {
-                        // Wait to calculate Mealy outputs until we have the
-                        // output from all of the Moore models
-                        orphaned.insert(consumer.second->isMealyAtomic());
-                        consumer.second->revisable_inputs.push_back(
-                            std::pair<Atomic<ValueType,TimeType>*,PinValue<ValueType>>(
-                                model,x));
-                    } else {
-                        active.insert(consumer.second.get());
-                        consumer.second->inputs.push_back(x);
-                    }
-                }
-                input.clear();
+            // Models inside of the granule are imminent now
+            if (!(model->tN == tNext)) {
+                merged.push_back(std::make_pair(model, model->tN));
+                model->tN = tNext;
             }
+            imminent_output(model);
         }
     }
     // Calculate output from Mealy type models
-    while (!orphaned.empty()) {
-        auto model = *(orphaned.begin());
-        calculate_mealy_output(path,model);
+    if (!mealy_pending.empty()) {
+        calculate_mealy_output();
     }
     // Gather input produced by Mealy models
     for (auto model: active) {
-        while (!model->revisable_inputs.empty()) {
-            model->inputs.push_back(model->revisable_inputs.front().second);
-            model->revisable_inputs.pop_front();
-        }
+        model->inputs.splice(model->inputs.end(), model->revisable_inputs);
         if (model->isMealyAtomic()) {
-            for (auto y : model->outputs) {
+            for (auto &y : model->outputs) {
                 for (auto listener : listeners) {
                     listener->outputEvent(*model, y, tNext);
                 }
             }
-            model->isMealyAtomic()->receivers.clear();
         }
         // Done with the output
         model->outputs.clear();
@@ -525,13 +911,29 @@ void Simulator<ValueType, TimeType>::computeNextOutput() {
 
 template <class ValueType, class TimeType>
 TimeType Simulator<ValueType, TimeType>::computeNextState() {
-    PinValue<ValueType> x;
     TimeType t = tNext + adevs_epsilon<TimeType>();
+    if (!merged.empty()) {
+        merged_event_count += merged.size();
+        merged_cycle_count++;
+        merged.clear();
+    }
+    // The models in the cascade are active and will be scheduled again.
+    // If setNextTime() moved the clock away from the cascade then it
+    // goes back into the schedule.
+    bool const in_cascade = !cascade.empty() && cascade.front()->tN == tNext;
+    if (!in_cascade) {
+        for (auto model : cascade) {
+            sched.schedule(model, model->tN);
+        }
+    }
+    cascade.clear();
     for (auto model : active) {
         // Notify listeners of input events
-        for (auto x : model->inputs) {
-            for (auto listener : listeners) {
-                listener->inputEvent(*model, x, tNext);
+        if (!listeners.empty()) {
+            for (auto &x : model->inputs) {
+                for (auto const &listener : listeners) {
+                    listener->inputEvent(*model, x, tNext);
+                }
             }
         }
         // Internal event if no input
@@ -546,7 +948,7 @@ TimeType Simulator<ValueType, TimeType>::computeNextState() {
             model->delta_ext(tNext - model->tL, model->inputs);
             model->inputs.clear();
         }
-        for (auto listener : listeners) {
+        for (auto const &listener : listeners) {
             listener->stateChange(*model, tNext);
         }
         // Adjust position in the schedule
@@ -555,19 +957,33 @@ TimeType Simulator<ValueType, TimeType>::computeNextState() {
     active.clear();
     // Effect any changes in the model structure
     graph->set_provisional(false);
-    std::list<typename Graph<ValueType, TimeType>::graph_op> &pending = graph->get_pending();
+    typename Graph<ValueType, TimeType>::pending_list &pending = graph->get_pending();
+    if (!pending.empty()) {
+        // The order of the Mealy models must be calculated again
+        mealy_order_valid = false;
+    }
     while (!pending.empty()) {
         auto op = pending.front();
         pending.pop_front();
         switch (op.op) {
             case Graph<ValueType, TimeType>::ADD_ATOMIC:
                 graph->add_atomic(op.model);
+                add_mealy_model(op.model.get());
                 schedule(op.model.get(), t);
                 break;
-            case Graph<ValueType, TimeType>::REMOVE_ATOMIC:
+            case Graph<ValueType, TimeType>::REMOVE_ATOMIC: {
                 sched.schedule(op.model.get(), adevs_inf<TimeType>());
+                auto iter = std::find(cascade.begin(), cascade.end(), op.model.get());
+                if (iter != cascade.end()) {
+                    cascade.erase(iter);
+                }
                 graph->remove_atomic(op.model);
+                if (op.model->isMealyAtomic() != nullptr &&
+                    graph->get_atomics().find(op.model) == graph->get_atomics().end()) {
+                    mealy_models.erase(op.model->isMealyAtomic());
+                }
                 break;
+            }
             case Graph<ValueType, TimeType>::REMOVE_PIN:
                 graph->remove_pin(op.pin[0]);
                 break;
@@ -587,15 +1003,55 @@ TimeType Simulator<ValueType, TimeType>::computeNextState() {
     }
     graph->set_provisional(true);
     // Get the time of next event and return
-    tNext = sched.minPriority();
+    tNext = next_event_time();
+    if (in_cascade) {
+        cascade_cycle_count++;
+    }
+    if (cascade.empty()) {
+        cascade_depth = 0;
+    } else {
+        if (cascade_depth++ == 0) {
+            cascade_count++;
+        }
+        cascade_max_depth = std::max(cascade_max_depth, cascade_depth);
+        if (cascade_limit > 0 && cascade_depth > cascade_limit) {
+            throw adevs::exception("Zero time cascade is deeper than the limit", cascade.front());
+        }
+    }
     return t;
 }
 
+template <class ValueType, class TimeType>
+template <class Predicate>
+size_t Simulator<ValueType, TimeType>::run(Predicate pred, size_t max_events) {
+    bool const timed = wall_clock_limit != std::chrono::steady_clock::duration::max();
+    auto const start = (timed) ? std::chrono::steady_clock::now()
+                               : std::chrono::steady_clock::time_point();
+    size_t count = 0;
+    wall_clock_stop = false;
+    while (count < max_events && tNext < adevs_inf<TimeType>() && pred(tNext)) {
+        if (timed && count % wall_clock_interval == 0 && count > 0 &&
+            std::chrono::steady_clock::now() - start >= wall_clock_limit) {
+            wall_clock_stop = true;
+            break;
+        }
+        computeNextOutput();
+        computeNextState();
+        count++;
+    }
+    return count;
+}
+
 template <class ValueType, class TimeType>
 void Simulator<ValueType, TimeType>::schedule(Atomic<ValueType, TimeType>* model, TimeType t) {
     model->tL = t;
     TimeType dt = model->ta();
-    if (dt == adevs_inf<TimeType>()) {
+    if (dt == adevs_zero<TimeType>()) {
+        // Skip the schedule for a model that will be imminent in the next cycle
+        model->tN = t;
+        sched.schedule(model, adevs_inf<TimeType>());
+        cascade.push_back(model);
+    } else if (dt == adevs_inf<TimeType>()) {
         model->tN = adevs_inf<TimeType>();
         sched.schedule(model, adevs_inf<TimeType>());
     } else {
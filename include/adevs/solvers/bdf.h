@@ -0,0 +1,421 @@
+/*
+ * Copyright (c) 2025, James Nutaro
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ *
+ * Bugs, comments, and questions can be sent to nutaro@gmail.com
+ */
+
+#ifndef _adevs_bdf_h_
+#define _adevs_bdf_h_
+
+#include <cvode/cvode.h>
+#include <nvector/nvector_serial.h>
+#include <sundials/sundials_types.h>
+#include <sunlinsol/sunlinsol_band.h>
+#include <sunlinsol/sunlinsol_dense.h>
+#include <sunmatrix/sunmatrix_band.h>
+#include <sunmatrix/sunmatrix_dense.h>
+#include <algorithm>
+#include <any>
+#include <cstring>
+#include <utility>
+#include <vector>
+#include "adevs/solvers/colored_jacobian.h"
+#include "adevs/solvers/event_locators.h"
+#include "adevs/solvers/hybrid.h"
+#include "adevs/solvers/sparsity.h"
+
+namespace adevs {
+
+/**
+ * @brief A variable order, variable step backward differentiation formula
+ * for stiff ode_systems.
+ *
+ * This ode_solver uses the BDF methods of orders one through five in
+ * CVODE from <a href="https://computing.llnl.gov/projects/sundials">SUNDIALS</a>.
+ * CVODE keeps the history of the solution from one step to the next,
+ * and this history is used for as long as each call to integrate()
+ * begins where the previous one ended and reset() has not been called.
+ * Otherwise CVODE is started again at first order from the new state.
+ * The Hybrid class calls reset() after every discrete event of the
+ * ode_system, because the event may change der_func() without changing
+ * the state.
+ * The interpolating polynomial of the last step is available through
+ * interpolate(), and so event locators do not need to integrate again.
+ *
+ * The Newton iteration uses the Jacobian of the ode_system in the
+ * same way as the trap solver. If get_sparsity() gives a pattern whose
+ * band needs less storage than a dense matrix, then the matrix is stored
+ * as a band. If there is no Jacobian, then it is approximated with a
+ * colored_jacobian using the pattern from get_sparsity() or a pattern
+ * detected at the first step. Entries that were zero where the pattern
+ * was detected are missing from it, and so the pattern is detected again
+ * and added to the old one when the Newton iteration fails to converge.
+ */
+template <typename ValueType = std::any>
+class bdf : public ode_solver<ValueType> {
+  public:
+    /**
+     * @brief Create an integrator that will use the given
+     * maximum step size.
+     *
+     * @param sys The system to solve
+     * @param err_tol The relative and absolute error tolerance
+     * @param h_max Maximum allowed step size
+     * @param silent If set to true, the CVODE error messages are suppressed.
+     * The default value is false.
+     */
+    bdf(ode_system<ValueType>* sys, double err_tol, double h_max, bool silent = false);
+    /**
+     * @brief Destructor
+     *
+     * Leaves the supplied ode_system intact.
+     */
+    ~bdf();
+    /**
+     * @brief Take one step of at most h_lim.
+     *
+     * @param q The state at the start of a step. This is overwritten
+     * with the state at the end of the integration step.
+     * @param h_lim The maximum step size
+     * @return The step actually taken.
+     */
+    double integrate(double* q, double h_lim);
+    /**
+     * @brief Integrate to exactly the step h
+     *
+     * @param q The state at the start of a step. This is overwritten
+     * with the state at the end of the integration step.
+     * @param h The step in time by which to advance the solution
+     */
+    void advance(double* q, double h);
+    /**
+     * @brief Evaluate the interpolating polynomial of the last step.
+     *
+     * @param q Array to be filled with the state
+     * @param h Time relative to the start of the last step
+     * @return true
+     */
+    bool interpolate(double* q, double h);
+    /// @brief Start CVODE again at the next call to integrate().
+    void reset() { started = false; }
+
+  private:
+    SUNContext sunctx;
+    void* cvode_mem;
+    N_Vector y, y_dense;
+    SUNMatrix J;
+    SUNLinearSolver LS;
+    double const err_tol;
+    double const h_max;
+    // CVODE time at the end and start of the last step
+    double t_now, t_start;
+    // The state at t_now; a step that starts elsewhere restarts CVODE
+    std::vector<double> q_now;
+    bool started;
+
+    // Structure of the Jacobian supplied by the ode_system
+    sparsity_pattern pattern;
+    bool banded;
+    bool sparse_values;
+    bool detect;      // Detect the pattern at the next evaluation
+    bool detected;    // The pattern was found with colored_jacobian::detect()
+    long conv_fails;  // Convergence failures when the pattern was detected
+    std::vector<double> jac_values;
+    colored_jacobian<ValueType>* fd_jac;
+
+    void prep_cvode(bool silent);
+    // Find the sparsity pattern at q and add it to the one we have
+    void detect_pattern(double const* q);
+    static int func(double t, N_Vector y, N_Vector ydot, void* user_data);
+    static int jac(double t, N_Vector y, N_Vector fy, SUNMatrix J, void* user_data, N_Vector tmp1,
+                   N_Vector tmp2, N_Vector tmp3);
+
+#if SUNDIALS_VERSION_MAJOR < 7
+    static void silent_error_handler(int, char const*, char const*, char*, void*) {}
+#else  //SUNDIALS_VERSION_MAJOR >= 7
+    static void silent_error_handler(int, const char*, const char*, const char*, SUNErrCode, void*,
+                                     SUNContext) {}
+#endif
+};
+
+template <typename ValueType>
+int bdf<ValueType>::func(double, N_Vector y, N_Vector ydot, void* user_data) {
+    bdf<ValueType>* self = static_cast<bdf<ValueType>*>(user_data);
+    self->sys->der_func(N_VGetArrayPointer(y), N_VGetArrayPointer(ydot));
+    return 0;
+}
+
+template <typename ValueType>
+int bdf<ValueType>::jac(double, N_Vector y, N_Vector, SUNMatrix J, void* user_data, N_Vector,
+                        N_Vector, N_Vector) {
+    bdf<ValueType>* self = static_cast<bdf<ValueType>*>(user_data);
+    auto yd = N_VGetArrayPointer(y);
+    int const N = self->sys->numVars();
+    // CVODE asks for a new Jacobian after the Newton iteration fails
+    // and the detected pattern may have missed entries that were zero
+    long conv_fails = 0;
+    if (self->detect || self->detected) {
+        CVodeGetNumNonlinSolvConvFails(self->cvode_mem, &conv_fails);
+        self->detect = self->detect || conv_fails > self->conv_fails;
+    }
+    if (self->detect) {
+        self->detect_pattern(yd);
+        self->conv_fails = conv_fails;
+    }
+    // Scatter the nonzero entries into a band or dense matrix
+    if (self->sparse_values || self->fd_jac != nullptr) {
+        if (self->sparse_values) {
+            self->sys->get_sparse_jacobian(yd, self->jac_values.data());
+        } else {
+            self->fd_jac->evaluate(yd, self->jac_values.data());
+        }
+        SUNMatZero(J);
+        int const* start = self->pattern.row_start();
+        int const* col = self->pattern.col_index();
+        for (int i = 0; i < N; i++) {
+            for (int k = start[i]; k < start[i + 1]; k++) {
+                if (self->banded) {
+                    SM_ELEMENT_B(J, i, col[k]) = self->jac_values[k];
+                } else {
+                    SM_ELEMENT_D(J, i, col[k]) = self->jac_values[k];
+                }
+            }
+        }
+        return 0;
+    }
+    self->sys->get_jacobian(yd, SUNDenseMatrix_Data(J));
+    return 0;
+}
+
+template <typename ValueType>
+void bdf<ValueType>::detect_pattern(double const* q) {
+    int const N = this->sys->numVars();
+    sparsity_pattern found = colored_jacobian<ValueType>::detect(this->sys, q);
+    if (!pattern.empty()) {
+        std::vector<std::pair<int, int>> entries;
+        for (auto const* p : {&pattern, &found}) {
+            for (int i = 0; i < N; i++) {
+                for (int k = p->row_start()[i]; k < p->row_start()[i + 1]; k++) {
+                    entries.push_back(std::make_pair(i, p->col_index()[k]));
+                }
+            }
+        }
+        found = sparsity_pattern(N, N, entries);
+    }
+    pattern = found;
+    delete fd_jac;
+    fd_jac = new colored_jacobian<ValueType>(this->sys, pattern);
+    jac_values.resize(pattern.nnz());
+    detected = true;
+    detect = false;
+}
+
+template <typename ValueType>
+void bdf<ValueType>::prep_cvode(bool silent) {
+    int const N = this->sys->numVars();
+    int retval;
+#if SUNDIALS_VERSION_MAJOR < 7
+    retval = SUNContext_Create(nullptr, &sunctx);
+#else  // SUNDIALS_VERSION_MAJOR >= 7
+    retval = SUNContext_Create(0, &sunctx);
+#endif
+    if (retval < 0) {
+        throw adevs::exception("SUNContext_Create failed");
+    }
+    y = N_VNew_Serial(N, sunctx);
+    y_dense = N_VNew_Serial(N, sunctx);
+    if (y == nullptr || y_dense == nullptr) {
+        throw adevs::exception("N_VNew_Serial failed");
+    }
+    N_VConst(0.0, y);
+    /* Find the band that contains the Jacobian, if there is one */
+    int upper = 0, lower = 0;
+    pattern = this->sys->get_sparsity();
+    if (!pattern.empty()) {
+        if (pattern.rows() != N || pattern.cols() != N) {
+            throw adevs::exception("Sparsity pattern does not match the number of variables");
+        }
+        for (int i = 0; i < N; i++) {
+            for (int k = pattern.row_start()[i]; k < pattern.row_start()[i + 1]; k++) {
+                upper = std::max(upper, pattern.col_index()[k] - i);
+                lower = std::max(lower, i - pattern.col_index()[k]);
+            }
+        }
+        sparse_values = this->sys->get_sparse_jacobian(nullptr, nullptr);
+        jac_values.resize(sparse_values ? pattern.nnz() : 0);
+    }
+    // A band matrix keeps upper+2*lower+1 entries for each column
+    banded = !pattern.empty() && upper + 2 * lower + 1 < N;
+    if (banded) {
+        J = SUNBandMatrix(N, upper, lower, sunctx);
+        LS = (J == nullptr) ? nullptr : SUNLinSol_Band(y, J, sunctx);
+    } else {
+        J = SUNDenseMatrix(N, N, sunctx);
+        LS = (J == nullptr) ? nullptr : SUNLinSol_Dense(y, J, sunctx);
+    }
+    if (LS == nullptr) {
+        throw adevs::exception("Could not create the linear solver for CVODE");
+    }
+    /* If there is no support for a symbolic jacobian, then
+       approximate it with difference quotients. */
+    if (!sparse_values && (banded || !this->sys->get_jacobian(NULL, NULL))) {
+        if (pattern.empty()) {
+            detect = true;
+        } else {
+            fd_jac = new colored_jacobian<ValueType>(this->sys, pattern);
+            jac_values.resize(pattern.nnz());
+        }
+    }
+    cvode_mem = CVodeCreate(CV_BDF, sunctx);
+    if (cvode_mem == nullptr) {
+        throw adevs::exception("CVodeCreate failed");
+    }
+    if (CVodeInit(cvode_mem, func, 0.0, y) < 0 ||
+        CVodeSStolerances(cvode_mem, err_tol, err_tol) < 0 ||
+        CVodeSetUserData(cvode_mem, this) < 0 || CVodeSetMaxStep(cvode_mem, h_max) < 0 ||
+        CVodeSetLinearSolver(cvode_mem, LS, J) < 0 || CVodeSetJacFn(cvode_mem, jac) < 0) {
+        throw adevs::exception("Could not initialize CVODE");
+    }
+    if (silent) {
+#if SUNDIALS_VERSION_MAJOR < 7
+        CVodeSetErrHandlerFn(cvode_mem, silent_error_handler, NULL);
+#else  //SUNDIALS_VERSION_MAJOR >= 7
+        SUNContext_PushErrHandler(sunctx, silent_error_handler, NULL);
+#endif
+    }
+}
+
+template <typename ValueType>
+bdf<ValueType>::bdf(ode_system<ValueType>* sys, double err_tol, double h_max, bool silent)
+    : ode_solver<ValueType>(sys),
+      err_tol(err_tol),
+      h_max(h_max),
+      t_now(0.0),
+      t_start(0.0),
+      q_now(sys->numVars()),
+      started(false),
+      banded(false),
+      sparse_values(false),
+      detect(false),
+      detected(false),
+      conv_fails(0),
+      fd_jac(nullptr) {
+    prep_cvode(silent);
+}
+
+template <typename ValueType>
+bdf<ValueType>::~bdf() {
+    delete fd_jac;
+    CVodeFree(&cvode_mem);
+    SUNLinSolFree(LS);
+    SUNMatDestroy(J);
+    N_VDestroy(y);
+    N_VDestroy(y_dense);
+    SUNContext_Free(&sunctx);
+}
+
+template <typename ValueType>
+double bdf<ValueType>::integrate(double* q, double h_lim) {
+    int const N = this->sys->numVars();
+    if (h_lim <= 0.0) {
+        return 0.0;
+    }
+    // Keep the history if we continue from the end of the last step. The
+    // system is autonomous, so CVODE restarts its clock at zero and the
+    // restart is forced if the clock is too large to resolve h_lim.
+    if (!started || t_now + h_lim == t_now ||
+        memcmp(q, q_now.data(), sizeof(double) * N) != 0) {
+        memcpy(N_VGetArrayPointer(y), q, sizeof(double) * N);
+        t_now = 0.0;
+        if (CVodeReInit(cvode_mem, t_now, y) < 0) {
+            throw adevs::exception("CVodeReInit failed");
+        }
+        // The counters of CVODE start again from zero
+        conv_fails = 0;
+        started = true;
+    }
+    t_start = t_now;
+    double const t_stop = t_now + h_lim;
+    CVodeSetStopTime(cvode_mem, t_stop);
+    int retval = CVode(cvode_mem, t_stop, y, &t_now, CV_ONE_STEP);
+    if (retval < 0) {
+        throw adevs::exception("CVode failed");
+    }
+    memcpy(q, N_VGetArrayPointer(y), sizeof(double) * N);
+    memcpy(q_now.data(), q, sizeof(double) * N);
+    // Report the full limit when CVODE stopped at it
+    return (retval == CV_TSTOP_RETURN) ? h_lim : t_now - t_start;
+}
+
+template <typename ValueType>
+void bdf<ValueType>::advance(double* q, double h) {
+    double dt;
+    while ((dt = integrate(q, h)) < h) {
+        h -= dt;
+    }
+}
+
+template <typename ValueType>
+bool bdf<ValueType>::interpolate(double* q, double h) {
+    if (CVodeGetDky(cvode_mem, std::min(t_start + h, t_now), 0, y_dense) < 0) {
+        return false;
+    }
+    memcpy(q, N_VGetArrayPointer(y_dense), sizeof(double) * this->sys->numVars());
+    return true;
+}
+
+/**
+ * @brief A Hybrid equation solver that uses the BDF integrator and
+ * the Illinois method to find state events.
+ *
+ * This specialization of the Hybrid method is a convenience shortcut
+ * for creating a Hybrid object with a bdf ODE solver and an
+ * illinois_event_locator. You need the
+ * <a href="https://computing.llnl.gov/projects/sundials/cvode">CVODE</a>
+ * library to use this solver.
+ */
+template <typename ValueType = std::any>
+class StiffHybrid : public Hybrid<ValueType> {
+  public:
+    /**
+     * @brief Create and initialize solvers for the ode_system.
+     *
+     * The ode_sytems is adopted by the StiffHybrid object and
+     * is deleted when it is.
+     *
+     * @param sys The system of equations to solve
+     * @param tol The error tolerance for the solvers
+     * @param h_max The step size limit for the solvers
+     */
+    StiffHybrid(ode_system<ValueType>* sys, double tol, double h_max)
+        : Hybrid<ValueType>(sys, new bdf<ValueType>(sys, tol, h_max),
+                            new illinois_event_locator<ValueType>(sys, tol)) {}
+};
+
+}  // namespace adevs
+#endif
@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2025, James Nutaro
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ *
+ * Bugs, comments, and questions can be sent to nutaro@gmail.com
+ */
+
+#ifndef _adevs_colored_jacobian_h_
+#define _adevs_colored_jacobian_h_
+
+#include <algorithm>
+#include <any>
+#include <cfloat>
+#include <cmath>
+#include <utility>
+#include <vector>
+#include "adevs/solvers/hybrid.h"
+#include "adevs/solvers/sparsity.h"
+
+namespace adevs {
+
+/**
+ * @brief Approximate a sparse Jacobian with difference quotients.
+ *
+ * The columns of the Jacobian are grouped with
+ * sparsity_pattern::color_columns() so that no two columns in a group
+ * have an entry in the same row. All of the variables in a group are
+ * perturbed at once, and so an approximation of the Jacobian costs one
+ * call to der_func() for each group rather than one for each variable.
+ * A banded Jacobian with bandwidth b needs at most b groups regardless
+ * of its size.
+ */
+template <typename ValueType = std::any>
+class colored_jacobian {
+  public:
+    /**
+     * @brief Prepare to approximate the Jacobian of an ode_system.
+     *
+     * @param sys The system whose Jacobian will be approximated. It is
+     * not deleted by the colored_jacobian.
+     * @param pattern The pattern of nonzero entries in the Jacobian
+     */
+    colored_jacobian(ode_system<ValueType>* sys, sparsity_pattern const &pattern);
+
+    /**
+     * @brief Find a sparsity pattern by perturbing each variable in turn.
+     *
+     * This costs numVars()+1 calls to der_func(). An entry of the Jacobian
+     * that happens to be zero at q is not found, but the diagonal is
+     * always included in the pattern.
+     *
+     * @param sys The system to examine
+     * @param q The state at which to examine it
+     * @return The pattern of entries that change der_func()
+     */
+    static sparsity_pattern detect(ode_system<ValueType>* sys, double const* q);
+
+    /**
+     * @brief Approximate the Jacobian at q.
+     *
+     * @param q The state at which to evaluate the Jacobian
+     * @param values Array of pattern().nnz() entries that is filled with
+     * the Jacobian in the order of the sparsity pattern
+     */
+    void evaluate(double const* q, double* values);
+
+    /// @brief Get the number of der_func() calls for one Jacobian, not counting f(q)
+    int num_colors() const { return static_cast<int>(groups.size()); }
+
+    /// @brief Get the sparsity pattern of the Jacobian
+    sparsity_pattern const &pattern() const { return jac_pattern; }
+
+  private:
+    ode_system<ValueType>* sys;
+    sparsity_pattern const jac_pattern;
+    // Columns in each group and the entries that they fill
+    std::vector<std::vector<int>> groups, entries;
+    std::vector<double> q_pert, f0, f1, delta;
+    std::vector<int> row;  // Row of each entry
+
+    static double perturbation(double q) { return sqrt(DBL_EPSILON) * std::max(fabs(q), 1.0); }
+};
+
+template <typename ValueType>
+colored_jacobian<ValueType>::colored_jacobian(ode_system<ValueType>* sys,
+                                             sparsity_pattern const &pattern)
+    : sys(sys),
+      jac_pattern(pattern),
+      q_pert(sys->numVars()),
+      f0(sys->numVars()),
+      f1(sys->numVars()),
+      delta(sys->numVars()),
+      row(pattern.nnz()) {
+    int const N = sys->numVars();
+    if (pattern.rows() != N || pattern.cols() != N) {
+        throw adevs::exception("Sparsity pattern does not match the number of variables");
+    }
+    std::vector<int> const color = pattern.color_columns();
+    int const num_groups = N > 0 ? *std::max_element(color.begin(), color.end()) + 1 : 0;
+    groups.resize(num_groups);
+    entries.resize(num_groups);
+    for (int j = 0; j < N; j++) {
+        groups[color[j]].push_back(j);
+    }
+    for (int i = 0; i < N; i++) {
+        for (int k = pattern.row_start()[i]; k < pattern.row_start()[i + 1]; k++) {
+            entries[color[pattern.col_index()[k]]].push_back(k);
+            row[k] = i;
+        }
+    }
+}
+
+template <typename ValueType>
+sparsity_pattern colored_jacobian<ValueType>::detect(ode_system<ValueType>* sys,
+                                                     double const* q) {
+    int const N = sys->numVars();
+    std::vector<double> q_pert(q, q + N), f0(N), f1(N);
+    std::vector<std::pair<int, int>> found;
+    sys->der_func(q, f0.data());
+    for (int j = 0; j < N; j++) {
+        q_pert[j] = q[j] + perturbation(q[j]);
+        sys->der_func(q_pert.data(), f1.data());
+        q_pert[j] = q[j];
+        for (int i = 0; i < N; i++) {
+            if (i == j || f1[i] != f0[i]) {
+                found.push_back(std::make_pair(i, j));
+            }
+        }
+    }
+    return sparsity_pattern(N, N, found);
+}
+
+template <typename ValueType>
+void colored_jacobian<ValueType>::evaluate(double const* q, double* values) {
+    int const* col = jac_pattern.col_index();
+    int const N = sys->numVars();
+    sys->der_func(q, f0.data());
+    std::copy(q, q + N, q_pert.begin());
+    for (size_t c = 0; c < groups.size(); c++) {
+        for (int j : groups[c]) {
+            delta[j] = perturbation(q[j]);
+            q_pert[j] = q[j] + delta[j];
+            // Use the step that is actually represented
+            delta[j] = q_pert[j] - q[j];
+        }
+        sys->der_func(q_pert.data(), f1.data());
+        for (int j : groups[c]) {
+            q_pert[j] = q[j];
+        }
+        for (int k : entries[c]) {
+            values[k] = (f1[row[k]] - f0[row[k]]) / delta[col[k]];
+        }
+    }
+}
+
+}  // namespace adevs
+#endif
@@ -0,0 +1,284 @@
+/*
+ * Copyright (c) 2025, James Nutaro
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ *
+ * Bugs, comments, and questions can be sent to nutaro@gmail.com
+ */
+
+#ifndef _adevs_dormand_prince_h_
+#define _adevs_dormand_prince_h_
+
+#include <algorithm>
+#include <any>
+#include <cfloat>
+#include <cmath>
+#include "adevs/solvers/hybrid.h"
+
+namespace adevs {
+
+/**
+ * @brief This ode_solver implements the 5th order Dormand-Prince method
+ * with an embedded 4th order error estimate.
+ *
+ * The last stage of an accepted step is the derivative at the new state,
+ * and it is reused as the first stage of the next step when that step
+ * begins where the previous one ended (first same as last). A rejected
+ * step keeps its first stage. Hence an accepted step costs six calls
+ * to der_func() and a rejected step costs six at most. The step size
+ * is selected by a proportional-integral controller, and the solver
+ * retains a 4th order continuous extension of its last accepted step
+ * that can be evaluated with interpolate() without calling der_func().
+ *
+ * The last stage is not reused after reset(), which the Hybrid class
+ * calls after each discrete event of the ode_system.
+ *
+ * @see ode_system
+ * @see Hybrid
+ */
+template <typename ValueType = std::any>
+class dormand_prince : public ode_solver<ValueType> {
+  public:
+    /**
+     * @brief Constructor
+     *
+     * An explicit numerical integration method. The integrator
+     * will adjust its step size to maintain a per step error
+     * less than err_tol, and will use a step size no larger
+     * than h_max.
+     *
+     * @param sys The ode_system whose der_func() method is to be integrated
+     * @param err_tol The maximum allowable per step error
+     * @param h_max The largest allowable step size
+     */
+    dormand_prince(ode_system<ValueType>* sys, double err_tol, double h_max);
+    /**
+     * @brief Destructor
+     *
+     * Leaves the supplied ode_system intact
+     */
+    ~dormand_prince();
+    /**
+     * @brief Integrate up to h_lim.
+     *
+     * @param q The state at the start of a step. This is overwritten
+     * with the state at the end of the integration step.
+     * @param h_lim The maximum step size
+     * @return The step actually taken.
+     */
+    double integrate(double* q, double h_lim);
+    /**
+     * @brief Integrate to exactly the step h
+     *
+     * As with integrate() but advance the step by exactly the
+     * specified step size.
+     *
+     * @param q The state at the start of a step. This is overwritten
+     * with the state at the end of the integration step.
+     * @param h The step in time by which to advance the solution
+     */
+    void advance(double* q, double h);
+    /**
+     * @brief Evaluate the continuous extension of the last accepted step.
+     *
+     * @param q The state at time h after the start of the last step
+     * taken by integrate() is written to this array.
+     * @param h The time relative to the start of the last step. This
+     * must be in the interval [0,h_last] where h_last is the size of
+     * that step.
+     * @return Always true
+     */
+    bool interpolate(double* q, double h);
+    /// @brief Compute the first stage of the next step anew.
+    void reset() { fsal = false; }
+
+  private:
+    double *y0,            // state at the start of the last accepted step
+        *y1,               // trial solution and end of the last accepted step
+        *t,                // temporary variables for computing stages
+        *k[7],             // the seven stage derivatives
+        *d;                // coefficients of the continuous extension
+    double const err_tol;  // Error tolerance
+    double const h_max;    // Maximum time step
+    double h_cur;          // Step size proposed by the controller
+    double h_last;         // Size of the last accepted step
+    double err_prev;       // Scaled error of the last accepted step
+    bool fsal;             // True if k[6] is the derivative at y1
+    // Compute a trial step of size h from y0, store the result in y1, and return the error
+    double trial_step(double h);
+};
+
+template <typename ValueType>
+dormand_prince<ValueType>::dormand_prince(ode_system<ValueType>* sys, double err_tol,
+                                          double h_max)
+    : ode_solver<ValueType>(sys),
+      err_tol(err_tol),
+      h_max(h_max),
+      h_cur(h_max),
+      h_last(0.0),
+      err_prev(1.0),
+      fsal(false) {
+    for (int i = 0; i < 7; i++) {
+        k[i] = new double[sys->numVars()];
+    }
+    y0 = new double[sys->numVars()];
+    y1 = new double[sys->numVars()];
+    t = new double[sys->numVars()];
+    d = new double[sys->numVars()];
+}
+
+template <typename ValueType>
+dormand_prince<ValueType>::~dormand_prince() {
+    delete[] y0;
+    delete[] y1;
+    delete[] t;
+    delete[] d;
+    for (int i = 0; i < 7; i++) {
+        delete[] k[i];
+    }
+}
+
+template <typename ValueType>
+void dormand_prince<ValueType>::advance(double* q, double h) {
+    double dt;
+    while ((dt = integrate(q, h)) < h) {
+        h -= dt;
+    }
+}
+
+template <typename ValueType>
+double dormand_prince<ValueType>::integrate(double* q, double h_lim) {
+    int const N = this->sys->numVars();
+    // Reuse the last stage of the previous step if this step starts where it ended
+    bool reuse = fsal;
+    for (int i = 0; i < N && reuse; i++) {
+        reuse = (q[i] == y1[i]);
+    }
+    for (int i = 0; i < N; i++) {
+        y0[i] = q[i];
+    }
+    if (reuse) {
+        std::swap(k[0], k[6]);
+    } else {
+        this->sys->der_func(y0, k[0]);
+    }
+    fsal = false;
+    double h = std::min(h_cur, std::min(h_max, h_lim));
+    double err;
+    // The first stage does not depend on h and is kept if the step is rejected
+    while ((err = trial_step(h) / err_tol) > 1.0) {
+        h *= std::max(0.2, 0.9 * pow(err, -0.2));
+    }
+    // Proportional-integral control of the next step size
+    double fac = 5.0;
+    if (err > 0.0) {
+        fac = std::min(5.0, std::max(0.2, 0.9 * pow(err, -0.17) * pow(err_prev, 0.04)));
+    }
+    // Do not let a step that was cut short by h_lim shrink the next step
+    if (h < h_lim || h * fac > h_cur) {
+        h_cur = h * fac;
+    }
+    err_prev = std::max(err, 1E-4);
+    // Coefficients of the continuous extension
+    for (int i = 0; i < N; i++) {
+        d[i] = h * ((-12715105075.0 / 11282082432.0) * k[0][i] +
+                    (87487479700.0 / 32700410799.0) * k[2][i] -
+                    (10690763975.0 / 1880347072.0) * k[3][i] +
+                    (701980252875.0 / 199316789632.0) * k[4][i] -
+                    (1453857185.0 / 822651844.0) * k[5][i] +
+                    (69997945.0 / 29380423.0) * k[6][i]);
+        q[i] = y1[i];
+    }
+    h_last = h;
+    fsal = true;
+    return h;
+}
+
+template <typename ValueType>
+bool dormand_prince<ValueType>::interpolate(double* q, double h) {
+    int const N = this->sys->numVars();
+    double const s = (h_last > 0.0) ? h / h_last : 1.0, s1 = 1.0 - s;
+    for (int i = 0; i < N; i++) {
+        double const r1 = y1[i] - y0[i];
+        double const r2 = h_last * k[0][i] - r1;
+        double const r3 = r1 - h_last * k[6][i] - r2;
+        q[i] = y0[i] + s * (r1 + s1 * (r2 + s * (r3 + s1 * d[i])));
+    }
+    return true;
+}
+
+template <typename ValueType>
+double dormand_prince<ValueType>::trial_step(double h) {
+    int const N = this->sys->numVars();
+    // Compute k2
+    for (int j = 0; j < N; j++) {
+        t[j] = y0[j] + h * (0.2 * k[0][j]);
+    }
+    this->sys->der_func(t, k[1]);
+    // Compute k3
+    for (int j = 0; j < N; j++) {
+        t[j] = y0[j] + h * ((3.0 / 40.0) * k[0][j] + (9.0 / 40.0) * k[1][j]);
+    }
+    this->sys->der_func(t, k[2]);
+    // Compute k4
+    for (int j = 0; j < N; j++) {
+        t[j] = y0[j] + h * ((44.0 / 45.0) * k[0][j] - (56.0 / 15.0) * k[1][j] +
+                            (32.0 / 9.0) * k[2][j]);
+    }
+    this->sys->der_func(t, k[3]);
+    // Compute k5
+    for (int j = 0; j < N; j++) {
+        t[j] = y0[j] + h * ((19372.0 / 6561.0) * k[0][j] - (25360.0 / 2187.0) * k[1][j] +
+                            (64448.0 / 6561.0) * k[2][j] - (212.0 / 729.0) * k[3][j]);
+    }
+    this->sys->der_func(t, k[4]);
+    // Compute k6
+    for (int j = 0; j < N; j++) {
+        t[j] = y0[j] + h * ((9017.0 / 3168.0) * k[0][j] - (355.0 / 33.0) * k[1][j] +
+                            (46732.0 / 5247.0) * k[2][j] + (49.0 / 176.0) * k[3][j] -
+                            (5103.0 / 18656.0) * k[4][j]);
+    }
+    this->sys->der_func(t, k[5]);
+    // The fifth order solution
+    for (int j = 0; j < N; j++) {
+        y1[j] = y0[j] + h * ((35.0 / 384.0) * k[0][j] + (500.0 / 1113.0) * k[2][j] +
+                             (125.0 / 192.0) * k[3][j] - (2187.0 / 6784.0) * k[4][j] +
+                             (11.0 / 84.0) * k[5][j]);
+    }
+    // Compute k7, which is the derivative at the new state
+    this->sys->der_func(y1, k[6]);
+    // Component wise maximum of the difference between the 5th and 4th order solutions
+    double err = 0.0;
+    for (int j = 0; j < N; j++) {
+        err = std::max(err, fabs(h * ((71.0 / 57600.0) * k[0][j] - (71.0 / 16695.0) * k[2][j] +
+                                      (71.0 / 1920.0) * k[3][j] - (17253.0 / 339200.0) * k[4][j] +
+                                      (22.0 / 525.0) * k[5][j] - (1.0 / 40.0) * k[6][j])));
+    }
+    return err;
+}
+
+}  // namespace adevs
+#endif
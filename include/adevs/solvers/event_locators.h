@@ -172,10 +172,7 @@ bool event_locator_impl<ValueType>::find_events(bool* events, double const* qsta
             } else {
                 h = tguess;
             }
-            for (int i = 0; i < this->sys->numVars(); i++) {
-                qend[i] = qstart[i];
-            }
-            solver->advance(qend, h);
+            this->state_at(qend, qstart, solver, h);
         } else {
             return found_event;
         }
@@ -401,8 +398,7 @@ repeat:
     if (p != NULL) {
         p->interpolate(qend, hg);
     } else {
-        memcpy(qend, qstart, sizeof(double) * this->sys->numVars());
-        solver->advance(qend, hg);
+        this->state_at(qend, qstart, solver, hg);
     }
     // Calculate state event functions at new guess
     this->sys->state_event_func(qend, zf);
@@ -419,6 +415,143 @@ success:
     return true;
 }
 
+/**
+ * @brief An event locator that uses the Illinois variant of regula falsi.
+ *
+ * All of the state event functions are searched together. At each
+ * iteration every function that changes sign in the bracket proposes
+ * the root of its secant, and the earliest proposal becomes the next
+ * guess. The bracket therefore always contains the earliest zero
+ * crossing. When the same end of the bracket is kept twice in a row,
+ * the function values at the other end are halved, which prevents
+ * the one sided convergence of plain regula falsi. The search usually
+ * needs only a few evaluations of state_event_func() where bisection
+ * needs about log2(h/err_tol), and intermediate states come from the
+ * dense output of the solver when it has one.
+ */
+template <typename ValueType = std::any>
+class illinois_event_locator : public event_locator<ValueType> {
+  public:
+    /**
+     * @brief Create an event locator for a system.
+     *
+     * @param sys The system to solve. Its z functions must be continuous.
+     * @param err_tol The width of the time bracket around the event at
+     * which the search stops and reports success.
+     */
+    illinois_event_locator(ode_system<ValueType>* sys, double err_tol);
+    bool find_events(bool* events, double const* qstart, double* qend,
+                     ode_solver<ValueType>* solver, double &h);
+    ~illinois_event_locator();
+
+  private:
+    double const err_tol;
+    double *z0, *za, *zb, *zt, *qt;
+
+    // A function that starts at zero has just had its event and does not cross
+    static bool crosses(double z0, double z) {
+        return (z0 < 0.0) ? z >= 0.0 : (z0 > 0.0 && z <= 0.0);
+    }
+};
+
+template <typename ValueType>
+illinois_event_locator<ValueType>::illinois_event_locator(ode_system<ValueType>* sys,
+                                                          double err_tol)
+    : event_locator<ValueType>(sys),
+      err_tol(err_tol),
+      z0(new double[sys->numEvents()]),
+      za(new double[sys->numEvents()]),
+      zb(new double[sys->numEvents()]),
+      zt(new double[sys->numEvents()]),
+      qt(new double[sys->numVars()]) {}
+
+template <typename ValueType>
+illinois_event_locator<ValueType>::~illinois_event_locator() {
+    delete[] z0;
+    delete[] za;
+    delete[] zb;
+    delete[] zt;
+    delete[] qt;
+}
+
+template <typename ValueType>
+bool illinois_event_locator<ValueType>::find_events(bool* events, double const* qstart,
+                                                    double* qend,
+                                                    ode_solver<ValueType>* solver, double &h) {
+    int const N = this->sys->numEvents();
+    // No state events? Just return false
+    if (N == 0) {
+        return false;
+    }
+    this->sys->state_event_func(qstart, z0);
+    this->sys->state_event_func(qend, zb);
+    bool sign_change = false;
+    for (int i = 0; i < N; i++) {
+        za[i] = z0[i];
+        sign_change = sign_change || crosses(z0[i], zb[i]);
+    }
+    // No event? Don't change anything and report no event.
+    if (!sign_change) {
+        memset(events, 0, sizeof(bool) * N);
+        return false;
+    }
+    // The earliest crossing is in [a,b]. The end that was kept
+    // at the last iteration is -1 for a, 1 for b, and 0 for neither.
+    double a = 0.0, b = h;
+    int kept = 0;
+    while (b - a >= err_tol) {
+        // Earliest root of the secants of the functions that change sign
+        double t = b;
+        for (int i = 0; i < N; i++) {
+            if (crosses(z0[i], zb[i]) && za[i] != zb[i]) {
+                t = std::min(t, a + (b - a) * za[i] / (za[i] - zb[i]));
+            }
+        }
+        // Stay err_tol/2 inside of the bracket so that a guess which lands
+        // next to the root is followed by one on the other side of it
+        if (std::isnan(t)) {
+            t = (a + b) / 2.0;
+        } else {
+            t = std::max(a + err_tol / 2.0, std::min(b - err_tol / 2.0, t));
+        }
+        this->state_at(qt, qstart, solver, t);
+        this->sys->state_event_func(qt, zt);
+        sign_change = false;
+        for (int i = 0; i < N; i++) {
+            sign_change = sign_change || crosses(z0[i], zt[i]);
+        }
+        if (sign_change) {
+            // The crossing is in [a,t]
+            b = t;
+            for (int i = 0; i < N; i++) {
+                zb[i] = zt[i];
+                if (kept == -1) {
+                    za[i] /= 2.0;
+                }
+            }
+            memcpy(qend, qt, sizeof(double) * this->sys->numVars());
+            kept = -1;
+        } else {
+            // The crossing is in (t,b]
+            a = t;
+            for (int i = 0; i < N; i++) {
+                za[i] = zt[i];
+                if (kept == 1) {
+                    zb[i] /= 2.0;
+                }
+            }
+            kept = 1;
+        }
+    }
+    // Success! Step is b and solution is qend
+    h = b;
+    // Halving the values at b does not change their sign
+    for (int i = 0; i < N; i++) {
+        events[i] = crosses(z0[i], zb[i]);
+    }
+    return true;
+}
+
 }  // namespace adevs
 
 #endif
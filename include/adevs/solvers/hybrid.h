@@ -35,7 +35,9 @@
 #include <algorithm>
 #include <any>
 #include <cmath>
+#include <vector>
 #include "adevs/models.h"
+#include "adevs/solvers/sparsity.h"
 
 
 namespace adevs {
@@ -99,6 +101,25 @@ class ode_system {
      */
     virtual void der_func(double const* q, double* dq) = 0;
 
+    /**
+     * @brief Compute the derivative of state variable i for state q.
+     *
+     * Quantized state solvers update one variable at a time and use this
+     * method to evaluate just the derivatives that they need. The default
+     * implementation calls der_func() and returns entry i of the result,
+     * so that each call costs as much as the whole derivative. Override it
+     * if a single derivative can be computed more cheaply.
+     * 
+     * @param q The state of the model
+     * @param i The index of the state variable
+     * @return The value of dq[i]/dt
+     */
+    virtual double der_func_component(double const* q, int i) {
+        dq_scratch.resize(N);
+        der_func(q, dq_scratch.data());
+        return dq_scratch[i];
+    }
+
     /**
      * @brief Compute the state event functions for state q and put them in z.
      * 
@@ -187,6 +208,22 @@ class ode_system {
     virtual void external_event(double* q, double e,
                                 std::list<adevs::PinValue<ValueType>> const &xb) = 0;
 
+    /**
+     * @brief Did the last external event leave the continuous trajectory unchanged?
+     *
+     * This is called immediately after external_event(). Return true if
+     * that input did not change the values of der_func(), state_event_func(),
+     * or time_event_func() for any state. The Hybrid class will then keep
+     * the rest of its tentative step instead of integrating again, provided
+     * that q was not modified and the ode_solver supports interpolate().
+     * Models that receive frequent inputs which only update discrete variables
+     * can save most of their integration work this way. The default
+     * implementation returns false.
+     *
+     * @return true if the tentative step remains valid
+     */
+    virtual bool preserves_trajectory() { return false; }
+
     /**
      * @brief The confluent transition function
      * 
@@ -232,6 +269,52 @@ class ode_system {
      */
     virtual bool get_jacobian(double const* q, double* J) { return false; }
 
+    /**
+     * @brief Get the ith entry on the diagonal of the Jacobian matrix.
+     *
+     * This is the partial derivative of dq[i]/dt with respect to q[i].
+     * The LIQSS methods of the QSS class use it to select their quantized
+     * states. The method must return false if it is not supported, in which
+     * case the solver will approximate the entry with a difference quotient.
+     * The default implementation returns false.
+     *
+     * @param q The state of the model
+     * @param i The index of the diagonal entry
+     * @param J_ii Set this to the value of the diagonal entry
+     * @return True if J_ii was set and false otherwise.
+     */
+    virtual bool get_jacobian_diagonal(double const*, int, double &) { return false; }
+
+    /**
+     * @brief Get the pattern of nonzero entries in the Jacobian matrix.
+     *
+     * Row i of the pattern lists the state variables that are read by
+     * the derivative of variable i. Implicit solvers use the pattern to
+     * store and factor the Jacobian as a band matrix instead of a dense
+     * one, and the QSS class uses it to find the derivatives affected by
+     * a change in a variable. The default implementation returns an empty
+     * pattern, which means that every entry may be nonzero.
+     *
+     * @return The sparsity pattern of the Jacobian or an empty pattern
+     */
+    virtual sparsity_pattern get_sparsity() { return sparsity_pattern(); }
+
+    /**
+     * @brief Get the nonzero entries of the Jacobian matrix.
+     *
+     * The values array must be filled with the entries of the Jacobian
+     * in the order of the pattern returned by get_sparsity(), which is
+     * row by row and by increasing column within each row. The method
+     * must return false if it is not supported and true if it is supported.
+     * If the argument values is nullptr then the call is just to test for
+     * support. The default implementation returns false.
+     *
+     * @param q The state of the model
+     * @param values Array of get_sparsity().nnz() entries to be filled
+     * @return True if the method fills the values and false otherwise.
+     */
+    virtual bool get_sparse_jacobian(double const*, double*) { return false; }
+
     /// @brief Destructor
     virtual ~ode_system() {}
 
@@ -265,6 +348,8 @@ class ode_system {
 
   private:
     int N, M;
+    // Space for the default der_func_component()
+    std::vector<double> dq_scratch;
 };
 
 // Clang complains about the postTrialStep declaration.
@@ -322,6 +407,34 @@ class ode_solver {
      */
     virtual void advance(double* q, double h) = 0;
 
+    /**
+     * @brief Evaluate the solution inside of the last step taken by integrate().
+     *
+     * Solvers that retain a continuous extension of their last step can
+     * override this method so that event locators and the Hybrid class
+     * find intermediate states without integrating again. The default
+     * implementation has no dense output and returns false.
+     *
+     * @param q The state at time h after the start of the last step
+     * is written to this array if the solver supports dense output.
+     * @param h The time relative to the start of the last step. This
+     * must be in the interval [0,h_last] where h_last is the size of
+     * that step.
+     * @return true if q was set and false if dense output is not supported.
+     */
+    virtual bool interpolate(double*, double) { return false; }
+
+    /**
+     * @brief Discard anything kept from the steps taken so far.
+     *
+     * The Hybrid class calls this method after a discrete event of the
+     * ode_system, which may change der_func() without changing the state.
+     * Solvers that carry derivatives or a history of the solution from
+     * one step to the next must not use them after this is called. The
+     * default implementation does nothing.
+     */
+    virtual void reset() {}
+
     /**
      * @brief Destructor
      * 
@@ -365,7 +478,9 @@ class event_locator {
      * h is overwritten with the event time, and the state of the model
      * at that time is copied to qend. The event finding method should
      * select an instant of time when the zero crossing function is zero or
-     * has changed sign to trigger an event.
+     * has changed sign to trigger an event. The Hybrid class calls this
+     * method with qstart at the beginning of the last step taken by the
+     * solver, and so intermediate states can be computed with state_at().
      * 
      * @param events The entries in this array must be set to indicate which state
      * events were activated. A true entry indicates an event and false no event.
@@ -388,6 +503,26 @@ class event_locator {
   protected:
     /// The system of odes to be acted upon by the event locator
     ode_system<ValueType>* sys;
+
+    /**
+     * @brief Compute the state at time h after qstart.
+     *
+     * The dense output of the solver is used if it has one. Otherwise
+     * the solution is integrated from qstart.
+     *
+     * @param q The state at time h is written to this array
+     * @param qstart The state at the start of the last step of the solver
+     * @param solver The ode_solver used to compute the state
+     * @param h The time relative to qstart
+     */
+    void state_at(double* q, double const* qstart, ode_solver<ValueType>* solver, double h) {
+        if (!solver->interpolate(q, h)) {
+            for (int i = 0; i < sys->numVars(); i++) {
+                q[i] = qstart[i];
+            }
+            solver->advance(q, h);
+        }
+    }
 };
 
 /**
@@ -417,7 +552,9 @@ class Hybrid : public Atomic<ValueType, TimeType> {
         : sys(sys), solver(solver), event_finder(event_finder), e_accum(0.0) {
         q = new double[sys->numVars()];
         q_trial = new double[sys->numVars()];
+        q_input = new double[sys->numVars()];
         event = new bool[sys->numEvents() + 1];
+        missed = new bool[sys->numEvents()];
         event_exists = false;
         sys->init(q_trial);  // Get the initial state of the model
         for (int i = 0; i < sys->numVars(); i++) {
@@ -478,12 +615,13 @@ class Hybrid : public Atomic<ValueType, TimeType> {
             missedOutput.clear();
             return;
         }
-        e_accum += ta();
+        e_accum += sigma;
         // Execute any discrete events
         event_happened = event_exists;
         if (event_exists)  // Execute the internal event
         {
             sys->internal_event(q_trial, event);
+            solver->reset();
             e_accum = 0.0;
         }
         // Copy the new state vector to q
@@ -499,18 +637,26 @@ class Hybrid : public Atomic<ValueType, TimeType> {
      * This method is used for numerical integration and
      * invokes the ode_system to handle for external events as needed.
      */
-    void delta_ext(TimeType e, std::list<adevs::PinValue<ValueType>> const &xb) {
+    void delta_ext(TimeType elapsed, std::list<adevs::PinValue<ValueType>> const &xb) {
+        double e = static_cast<double>(elapsed);
         bool state_event_exists = false;
         event_happened = true;
-        // Check that we have not missed a state event
-        if (event_exists) {
-            for (int i = 0; i < sys->numVars(); i++) {
-                q_trial[i] = q[i];
+        // Check that we have not missed a state event. A step that was
+        // kept through an earlier input was already searched up to sigma.
+        if (event_exists && step_offset == 0.0) {
+            // The tentative step is still the last step of the solver
+            if (!solver->interpolate(q_trial, e)) {
+                for (int i = 0; i < sys->numVars(); i++) {
+                    q_trial[i] = q[i];
+                }
+                solver->advance(q_trial, e);
             }
-            solver->advance(q_trial, e);
-            state_event_exists = event_finder->find_events(event, q, q_trial, solver, e);
+            state_event_exists = event_finder->find_events(missed, q, q_trial, solver, e);
             // We missed an event
             if (state_event_exists) {
+                for (int i = 0; i < sys->numEvents(); i++) {
+                    event[i] = missed[i];
+                }
                 output_func(missedOutput);
                 sys->confluent_event(q_trial, event, xb);
                 for (int i = 0; i < sys->numVars(); i++) {
@@ -518,15 +664,33 @@ class Hybrid : public Atomic<ValueType, TimeType> {
                 }
             }
         }
+        bool keep_step = false;
         if (!state_event_exists)  // We didn't miss an event
         {
-            solver->advance(q, e);  // Advance the state q by e
+            // Advance the state q by e
+            keep_step = solver->interpolate(q, step_offset + e);
+            if (!keep_step) {
+                solver->advance(q, e);
+            }
             // Let the model adjust algebraic variables, etc. for the new state
             sys->postStep(q);
+            for (int i = 0; i < sys->numVars(); i++) {
+                q_input[i] = q[i];
+            }
             // Process the discrete input
             sys->external_event(q, e + e_accum, xb);
+            keep_step = keep_step && sys->preserves_trajectory();
+            for (int i = 0; i < sys->numVars() && keep_step; i++) {
+                keep_step = (q[i] == q_input[i]);
+            }
         }
         e_accum = 0.0;
+        // Keep the rest of the tentative step if the input did not change it
+        if (keep_step && resume_step(step_offset + e)) {
+            return;
+        }
+        // The discrete event may have changed der_func()
+        solver->reset();
         // Copy the new state to the trial solution
         for (int i = 0; i < sys->numVars(); i++) {
             q_trial[i] = q[i];
@@ -552,8 +716,9 @@ class Hybrid : public Atomic<ValueType, TimeType> {
         if (event_exists) {
             sys->confluent_event(q_trial, event, xb);
         } else {
-            sys->external_event(q_trial, e_accum + ta(), xb);
+            sys->external_event(q_trial, e_accum + sigma, xb);
         }
+        solver->reset();
         e_accum = 0.0;
         // Copy the new state vector to q
         for (int i = 0; i < sys->numVars(); i++) {
@@ -565,9 +730,9 @@ class Hybrid : public Atomic<ValueType, TimeType> {
     /// @brief Do not override.
     TimeType ta() {
         if (missedOutput.empty()) {
-            return sigma;
+            return TimeType(sigma);
         } else {
-            return 0.0;
+            return adevs_zero<TimeType>();
         }
     }
 
@@ -599,8 +764,13 @@ class Hybrid : public Atomic<ValueType, TimeType> {
     event_locator<ValueType>* event_finder;  // Event locator
     double sigma;                            // Time to the next internal event
     double *q, *q_trial;                     // Current and tentative states
+    double* q_input;                         // State before the last external event
     bool* event;                             // Flags indicating the encountered event surfaces
+    bool* missed;                            // Flags for events missed by an input
     bool event_exists;                       // True if there is at least one event
+    bool step_event;      // True if a state event ends the tentative step
+    double step_size;     // Length of the tentative step
+    double step_offset;   // Time from the start of the tentative step to q
     bool event_happened;  // True if a discrete event in the ode_system took place
     double e_accum;       // Accumulated time between discrete events
     std::list<adevs::PinValue<ValueType>> missedOutput;  // Output missed at an external event
@@ -609,15 +779,30 @@ class Hybrid : public Atomic<ValueType, TimeType> {
         // Check for a time event
         double time_event = sys->time_event_func(q);
         // Integrate up to that time at most
-        double step_size = solver->integrate(q_trial, time_event);
+        step_size = solver->integrate(q_trial, time_event);
+        step_offset = 0.0;
         // Look for state events inside of the interval [0,step_size]
-        bool state_event_exists = event_finder->find_events(event, q, q_trial, solver, step_size);
+        step_event = event_finder->find_events(event, q, q_trial, solver, step_size);
         // Find the time advance and set the time event flag
         sigma = std::min<double>(step_size, time_event);
         event[sys->numEvents()] = time_event <= sigma;
-        event_exists = event[sys->numEvents()] || state_event_exists;
+        event_exists = event[sys->numEvents()] || step_event;
         sys->postTrialStep(q);
     }
+    // Continue the tentative step from time t after its start. This
+    // fails if a time event now comes before the end of the step.
+    bool resume_step(double t) {
+        double time_event = sys->time_event_func(q);
+        if (time_event < step_size - t) {
+            return false;
+        }
+        step_offset = t;
+        sigma = step_size - t;
+        solver->interpolate(q_trial, step_size);
+        event[sys->numEvents()] = time_event <= sigma;
+        event_exists = event[sys->numEvents()] || step_event;
+        return true;
+    }
 };
 
 }  // namespace adevs
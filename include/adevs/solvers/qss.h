@@ -0,0 +1,713 @@
+/*
+ * Copyright (c) 2025, James Nutaro
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ *
+ * Bugs, comments, and questions can be sent to nutaro@gmail.com
+ */
+
+#ifndef _adevs_qss_h_
+#define _adevs_qss_h_
+
+#include <algorithm>
+#include <any>
+#include <cfloat>
+#include <cmath>
+#include <list>
+#include <vector>
+#include "adevs/exception.h"
+#include "adevs/solvers/event_locators.h"
+#include "adevs/solvers/hybrid.h"
+#include "adevs/solvers/sparsity.h"
+
+namespace adevs {
+
+/**
+ * @brief This Atomic model simulates an ode_system with a quantized state
+ * system (QSS) integrator.
+ *
+ * A QSS method advances each state variable on its own schedule. The
+ * variable x[i] is followed by a quantized trajectory q[i], and x[i] is
+ * updated only when it drifts from q[i] by more than its quantum
+ * max(abs_tol,rel_tol*|x[i]|). Such an update changes only the derivatives
+ * that read q[i], and these are found with a sparsity_pattern whose row i
+ * lists the variables read by the derivative of variable i. Derivatives
+ * are computed one at a time with der_func_component(). In a large system
+ * where only a few variables are active at once, the work is proportional
+ * to the activity rather than to the size of the system. This is only true
+ * if the ode_system overrides der_func_component(). The default calls
+ * der_func() for every derivative, and so each update costs as much as
+ * evaluating the whole system once for each derivative that it changes.
+ *
+ * The QSS1, QSS2, and QSS3 methods are of first, second, and third order.
+ * The time derivatives of der_func_component() needed by QSS2 and QSS3
+ * are approximated by central differences along the quantized trajectories.
+ * The linearly implicit LIQSS1 and LIQSS2 methods are of first and second
+ * order and are meant for stiff systems. When a variable whose derivative
+ * decreases with the variable itself is requantized, they place q[i] one
+ * quantum ahead of x[i] in the direction that x[i] will move, or at the
+ * point where it stops moving, rather than at x[i]. The slope is taken from
+ * get_jacobian_diagonal() or, failing that, from a difference quotient.
+ * This removes the fast oscillations that make QSS slow on stiff systems.
+ * The LIQSS methods let x[i] drift up to two quanta from q[i].
+ *
+ * Discrete events work as they do for the Hybrid class. The state
+ * events of the ode_system are located along the piecewise polynomial
+ * trajectories by the supplied event_locator. Doing so evaluates every
+ * state variable at each update, and so models without state events
+ * should not supply a locator. The time_event_func() is evaluated after
+ * each discrete event. An internal, external, or confluent event restarts
+ * every variable from the new state unless preserves_trajectory() reports
+ * that an input left the trajectory alone. The postStep() method is called
+ * only before an external event.
+ */
+template <typename ValueType = std::any, class TimeType = double>
+class QSS : public Atomic<ValueType, TimeType> {
+  public:
+    /// @brief The integration methods that are available
+    enum Method {
+        /// First order QSS
+        QSS1,
+        /// Second order QSS
+        QSS2,
+        /// Third order QSS
+        QSS3,
+        /// First order linearly implicit QSS
+        LIQSS1,
+        /// Second order linearly implicit QSS
+        LIQSS2
+    };
+
+    /**
+     * @brief Create and initialize the solver for an ode_system.
+     *
+     * The ode_system and event_locator are adopted by the QSS object
+     * and deleted when it is.
+     *
+     * @param sys The system of equations to solve
+     * @param method The integration method
+     * @param abs_tol The smallest quantum for any variable
+     * @param rel_tol The quantum relative to the magnitude of a variable
+     * @param deps The variables read by each derivative. If this is empty,
+     * then the pattern from ode_system::get_sparsity() is used, and if
+     * that is also empty then every derivative is assumed to read every
+     * variable.
+     * @param event_finder The state event detection algorithm. This may be
+     * nullptr if the system has no state events.
+     */
+    QSS(ode_system<ValueType>* sys, Method method, double abs_tol, double rel_tol,
+        sparsity_pattern const &deps = sparsity_pattern(),
+        event_locator<ValueType>* event_finder = nullptr);
+
+    /// @brief Destructor deletes the ode_system and event_locator
+    ~QSS();
+
+    /**
+     * @brief Get the value of the kth continuous state variable
+     *
+     * @param k The index of the state variable
+     * @return The value of the state variable
+     */
+    double getState(int k) const { return value(v[k].x, order, t_now - v[k].tx); }
+
+    /**
+     * @brief Get the array of state variables
+     *
+     * This evaluates every state variable.
+     *
+     * @return The array of state variable values
+     */
+    double const* getState() {
+        states_at(q_out, t_now);
+        return q_out;
+    }
+
+    /**
+     * @brief Get the ode_system that this QSS model is simulating
+     *
+     * @return the ode_system passed to the constructor
+     */
+    ode_system<ValueType>* getSystem() { return sys; }
+
+    /**
+     * @brief Did a discrete event occur at the last state transition?
+     *
+     * @return true if the ode_system caused a state or time event or
+     * received an input
+     */
+    bool eventHappened() const { return event_happened; }
+
+    /// @brief Get the number of times that a variable was requantized
+    unsigned long long get_updates() const { return updates; }
+
+    /**
+     * @brief Set the time step of the central differences that approximate
+     * the time derivatives of der_func_component().
+     *
+     * The default is 1E-6 and is suitable for systems whose time constants
+     * are near one. Scale it with the time constants of your system.
+     *
+     * @param h The time step
+     */
+    void set_derivative_step(double h) { fd_step = h; }
+
+    /// @brief Do not override.
+    void delta_int();
+    /// @brief Do not override.
+    void delta_ext(TimeType e, std::list<PinValue<ValueType>> const &xb);
+    /// @brief Do not override.
+    void delta_conf(std::list<PinValue<ValueType>> const &xb);
+    /// @brief Do not override.
+    TimeType ta();
+    /// @brief Do not override.
+    void output_func(std::list<PinValue<ValueType>> &yb);
+
+  private:
+    // The trajectories of the state variables as seen by an event locator
+    class trajectory : public ode_solver<ValueType> {
+      public:
+        trajectory(QSS* owner) : ode_solver<ValueType>(owner->sys), owner(owner) {}
+        double integrate(double* q, double h_lim) {
+            interpolate(q, h_lim);
+            return h_lim;
+        }
+        void advance(double* q, double h) { interpolate(q, h); }
+        bool interpolate(double* q, double h) {
+            owner->states_at(q, owner->t_now + h);
+            return true;
+        }
+
+      private:
+        QSS* owner;
+    };
+    // A state variable and its quantized trajectory. The polynomials
+    // x and q are in powers of the time since tx and tq.
+    struct variable {
+        double x[4], q[3];
+        double tx, tq, quantum, tn;
+        int pos;  // Position in the heap
+    };
+
+    ode_system<ValueType>* sys;
+    event_locator<ValueType>* event_finder;
+    trajectory traj;
+    int const order;
+    bool const implicit;
+    double const abs_tol, rel_tol;
+    double fd_step;
+    sparsity_pattern reads, read_by;  // The dependency pattern and its transpose
+    std::vector<bool> reads_self;     // True if a derivative reads its own variable
+    std::vector<variable> v;
+    std::vector<int> heap;            // Variables ordered by their next update
+    double *qv,                       // Quantized states passed to der_func_component
+        *q_out, *q_start, *q_end;     // Full states
+    bool* event;                      // Flags for the next discrete event
+    bool event_exists, event_happened;
+    double t_now, t_next, t_discrete, t_time_event;
+    unsigned long long updates;
+
+    static double value(double const* p, int n, double dt) {
+        double y = p[n];
+        for (int k = n - 1; k >= 0; k--) {
+            y = y * dt + p[k];
+        }
+        return y;
+    }
+    static void shift(double* p, int n, double dt);
+    static double min_positive_root(double const* c, int n);
+    void states_at(double* q, double t) const;
+    void restart(double const* q);
+    void derivatives(int i, double t);
+    double der_at(int i, double t);
+    double der_with(int i, double t, double qi);
+    void implicit_quantize(int k, double t);
+    void next_time(int i);
+    void requantize(int k, double t);
+    void schedule();
+    void heap_update(int i);
+    void sift_down(int pos);
+};
+
+template <typename ValueType, class TimeType>
+QSS<ValueType, TimeType>::QSS(ode_system<ValueType>* sys, Method method, double abs_tol,
+                              double rel_tol, sparsity_pattern const &deps,
+                              event_locator<ValueType>* event_finder)
+    : Atomic<ValueType, TimeType>(),
+      sys(sys),
+      event_finder(event_finder),
+      traj(this),
+      order((method == LIQSS1) ? 1 : (method == LIQSS2) ? 2 : static_cast<int>(method) + 1),
+      implicit(method == LIQSS1 || method == LIQSS2),
+      abs_tol(abs_tol),
+      rel_tol(rel_tol),
+      fd_step(1E-6),
+      reads(deps.empty() ? sys->get_sparsity() : deps),
+      reads_self(sys->numVars(), false),
+      v(sys->numVars()),
+      heap(sys->numVars()),
+      event_exists(false),
+      event_happened(false),
+      t_now(0.0),
+      t_next(0.0),
+      t_discrete(0.0),
+      t_time_event(DBL_MAX),
+      updates(0) {
+    int const N = sys->numVars();
+    if (reads.empty()) {
+        reads = sparsity_pattern::dense(N, N);
+    }
+    if (reads.rows() != N || reads.cols() != N) {
+        throw adevs::exception("QSS dependency pattern does not match the number of variables",
+                               this);
+    }
+    if (sys->numEvents() > 0 && event_finder == nullptr) {
+        throw adevs::exception("QSS needs an event locator for a system with state events",
+                               this);
+    }
+    read_by = reads.transpose();
+    for (int i = 0; i < N; i++) {
+        for (int k = reads.row_start()[i]; k < reads.row_start()[i + 1]; k++) {
+            reads_self[i] = reads_self[i] || reads.col_index()[k] == i;
+        }
+    }
+    qv = new double[N];
+    q_out = new double[N];
+    q_start = new double[N];
+    q_end = new double[N];
+    event = new bool[sys->numEvents() + 1];
+    for (int i = 0; i < N; i++) {
+        heap[i] = i;
+        v[i].pos = i;
+    }
+    sys->init(q_out);
+    restart(q_out);
+    schedule();
+}
+
+template <typename ValueType, class TimeType>
+QSS<ValueType, TimeType>::~QSS() {
+    delete[] qv;
+    delete[] q_out;
+    delete[] q_start;
+    delete[] q_end;
+    delete[] event;
+    delete event_finder;
+    delete sys;
+}
+
+template <typename ValueType, class TimeType>
+void QSS<ValueType, TimeType>::delta_int() {
+    t_now = t_next;
+    event_happened = event_exists;
+    if (event_exists) {
+        states_at(q_out, t_now);
+        sys->internal_event(q_out, event);
+        t_discrete = t_now;
+        restart(q_out);
+    } else {
+        // Update every variable that has reached its quantum
+        while (!heap.empty() && v[heap[0]].tn <= t_now) {
+            requantize(heap[0], t_now);
+        }
+    }
+    schedule();
+}
+
+template <typename ValueType, class TimeType>
+void QSS<ValueType, TimeType>::delta_ext(TimeType e, std::list<PinValue<ValueType>> const &xb) {
+    int const N = sys->numVars();
+    t_now += static_cast<double>(e);
+    event_happened = true;
+    states_at(q_out, t_now);
+    // Let the model adjust algebraic variables, etc. for the new state
+    sys->postStep(q_out);
+    for (int i = 0; i < N; i++) {
+        q_start[i] = q_out[i];
+    }
+    sys->external_event(q_out, t_now - t_discrete, xb);
+    t_discrete = t_now;
+    // Keep the trajectories if the input did not change them
+    bool keep = sys->preserves_trajectory();
+    for (int i = 0; i < N && keep; i++) {
+        keep = (q_out[i] == q_start[i]);
+    }
+    if (!keep) {
+        restart(q_out);
+    }
+    schedule();
+}
+
+template <typename ValueType, class TimeType>
+void QSS<ValueType, TimeType>::delta_conf(std::list<PinValue<ValueType>> const &xb) {
+    t_now = t_next;
+    event_happened = true;
+    states_at(q_out, t_now);
+    if (event_exists) {
+        sys->confluent_event(q_out, event, xb);
+    } else {
+        sys->external_event(q_out, t_now - t_discrete, xb);
+    }
+    t_discrete = t_now;
+    restart(q_out);
+    schedule();
+}
+
+template <typename ValueType, class TimeType>
+TimeType QSS<ValueType, TimeType>::ta() {
+    if (t_next >= DBL_MAX) {
+        return adevs_inf<TimeType>();
+    }
+    return TimeType(t_next - t_now);
+}
+
+template <typename ValueType, class TimeType>
+void QSS<ValueType, TimeType>::output_func(std::list<PinValue<ValueType>> &yb) {
+    if (event_exists) {
+        states_at(q_out, t_next);
+        sys->output_func(q_out, event, yb);
+    }
+}
+
+template <typename ValueType, class TimeType>
+void QSS<ValueType, TimeType>::shift(double* p, int n, double dt) {
+    // Taylor shift of the polynomial by synthetic division
+    for (int k = 0; k < n; k++) {
+        for (int j = n - 1; j >= k; j--) {
+            p[j] += dt * p[j + 1];
+        }
+    }
+}
+
+template <typename ValueType, class TimeType>
+double QSS<ValueType, TimeType>::min_positive_root(double const* c, int n) {
+    while (n > 0 && c[n] == 0.0) {
+        n--;
+    }
+    if (n == 0) {
+        return DBL_MAX;
+    } else if (n == 1) {
+        double r = -c[0] / c[1];
+        return (r > 0.0) ? r : DBL_MAX;
+    } else if (n == 2) {
+        double disc = c[1] * c[1] - 4.0 * c[2] * c[0];
+        if (disc < 0.0) {
+            return DBL_MAX;
+        }
+        double s = -0.5 * (c[1] + std::copysign(sqrt(disc), c[1]));
+        double r1 = s / c[2], r2 = (s != 0.0) ? c[0] / s : r1;
+        double r = DBL_MAX;
+        if (r1 > 0.0) {
+            r = r1;
+        }
+        if (r2 > 0.0 && r2 < r) {
+            r = r2;
+        }
+        return r;
+    }
+    // A cubic is monotone between its critical points and has no roots
+    // beyond the Cauchy bound. Look for the first of these intervals where
+    // the sign changes and bisect it.
+    double bound = 1.0 + std::max(fabs(c[0]), std::max(fabs(c[1]), fabs(c[2]))) / fabs(c[3]);
+    double ends[3];
+    int m = 0;
+    double const dc[3] = {c[1], 2.0 * c[2], 3.0 * c[3]};
+    double disc = dc[1] * dc[1] - 4.0 * dc[2] * dc[0];
+    if (disc > 0.0) {
+        double s = -0.5 * (dc[1] + std::copysign(sqrt(disc), dc[1]));
+        double r1 = s / dc[2], r2 = (s != 0.0) ? dc[0] / s : r1;
+        if (r1 > r2) {
+            std::swap(r1, r2);
+        }
+        if (r1 > 0.0 && r1 < bound) {
+            ends[m++] = r1;
+        }
+        if (r2 > 0.0 && r2 < bound) {
+            ends[m++] = r2;
+        }
+    }
+    ends[m++] = bound;
+    double lo = 0.0, plo = c[0];
+    for (int k = 0; k < m; k++) {
+        double hi = ends[k], phi = value(c, 3, hi);
+        if ((plo < 0.0) != (phi < 0.0) || phi == 0.0) {
+            for (int iter = 0; iter < 200 && hi - lo > 4.0 * DBL_EPSILON * hi; iter++) {
+                double mid = 0.5 * (lo + hi);
+                double pmid = value(c, 3, mid);
+                if ((plo < 0.0) != (pmid < 0.0) || pmid == 0.0) {
+                    hi = mid;
+                } else {
+                    lo = mid;
+                    plo = pmid;
+                }
+            }
+            return hi;
+        }
+        lo = hi;
+        plo = phi;
+    }
+    return DBL_MAX;
+}
+
+template <typename ValueType, class TimeType>
+void QSS<ValueType, TimeType>::states_at(double* q, double t) const {
+    for (int i = 0; i < sys->numVars(); i++) {
+        q[i] = value(v[i].x, order, t - v[i].tx);
+    }
+}
+
+template <typename ValueType, class TimeType>
+void QSS<ValueType, TimeType>::restart(double const* q) {
+    int const N = sys->numVars();
+    for (int i = 0; i < N; i++) {
+        v[i].x[0] = v[i].q[0] = qv[i] = q[i];
+        v[i].x[1] = v[i].x[2] = v[i].x[3] = 0.0;
+        v[i].q[1] = v[i].q[2] = 0.0;
+        v[i].tx = v[i].tq = t_now;
+        v[i].quantum = std::max(abs_tol, rel_tol * fabs(q[i]));
+    }
+    for (int i = 0; i < N; i++) {
+        derivatives(i, t_now);
+    }
+    // Give the quantized trajectories their slopes and compute
+    // the derivatives again along these trajectories
+    if (order > 1) {
+        for (int i = 0; i < N; i++) {
+            for (int k = 1; k < order; k++) {
+                v[i].q[k] = v[i].x[k];
+            }
+        }
+        for (int i = 0; i < N; i++) {
+            derivatives(i, t_now);
+        }
+    }
+    for (int i = 0; i < N; i++) {
+        next_time(i);
+    }
+    for (int pos = N / 2 - 1; pos >= 0; pos--) {
+        sift_down(pos);
+    }
+    double time_event = sys->time_event_func(q);
+    t_time_event = (time_event < DBL_MAX - t_now) ? t_now + time_event : DBL_MAX;
+}
+
+template <typename ValueType, class TimeType>
+double QSS<ValueType, TimeType>::der_at(int i, double t) {
+    int const* col = reads.col_index();
+    for (int k = reads.row_start()[i]; k < reads.row_start()[i + 1]; k++) {
+        int j = col[k];
+        qv[j] = value(v[j].q, order - 1, t - v[j].tq);
+    }
+    return sys->der_func_component(qv, i);
+}
+
+template <typename ValueType, class TimeType>
+double QSS<ValueType, TimeType>::der_with(int i, double t, double qi) {
+    int const* col = reads.col_index();
+    for (int k = reads.row_start()[i]; k < reads.row_start()[i + 1]; k++) {
+        int j = col[k];
+        qv[j] = value(v[j].q, order - 1, t - v[j].tq);
+    }
+    qv[i] = qi;
+    return sys->der_func_component(qv, i);
+}
+
+template <typename ValueType, class TimeType>
+void QSS<ValueType, TimeType>::implicit_quantize(int k, double t) {
+    variable &vk = v[k];
+    double const x = vk.x[0], dQ = vk.quantum;
+    // Linearize the derivative of x as u + a*q with q the constant value x
+    double const f0 = der_with(k, t, x);
+    double a;
+    if (!sys->get_jacobian_diagonal(qv, k, a)) {
+        a = (der_with(k, t, x + dQ) - f0) / dQ;
+    }
+    // Without a stable dependence on itself the variable is quantized as usual
+    if (!(a < 0.0)) {
+        for (int j = 0; j < order; j++) {
+            vk.q[j] = vk.x[j];
+        }
+        return;
+    }
+    double const u = f0 - a * x;
+    // The derivative of x that must point from x to q is g0 + s*q. This is
+    // the first derivative for LIQSS1 and the second derivative for LIQSS2.
+    double g0 = u, s = a;
+    if (order > 1) {
+        double const du = (der_with(k, t + fd_step, x) - der_with(k, t - fd_step, x)) /
+                          (2.0 * fd_step);
+        g0 = a * u + du;
+        s = a * a;
+    }
+    bool const up = g0 + s * (x + dQ) > 0.0, down = g0 + s * (x - dQ) < 0.0;
+    double q;
+    if (up == down) {
+        // Put q where x stops moving
+        q = std::max(x - dQ, std::min(x + dQ, -g0 / s));
+    } else {
+        q = (up) ? x + dQ : x - dQ;
+    }
+    vk.q[0] = q;
+    if (order > 1) {
+        vk.q[1] = a * q + u;
+    }
+}
+
+template <typename ValueType, class TimeType>
+void QSS<ValueType, TimeType>::derivatives(int i, double t) {
+    variable &vi = v[i];
+    shift(vi.x, order, t - vi.tx);
+    vi.tx = t;
+    vi.x[1] = der_at(i, t);
+    if (order > 1) {
+        double const fp = der_at(i, t + fd_step), fm = der_at(i, t - fd_step);
+        vi.x[2] = (fp - fm) / (4.0 * fd_step);
+        if (order > 2) {
+            vi.x[3] = (fp - 2.0 * vi.x[1] + fm) / (6.0 * fd_step * fd_step);
+        }
+    }
+}
+
+template <typename ValueType, class TimeType>
+void QSS<ValueType, TimeType>::next_time(int i) {
+    variable &vi = v[i];
+    // Difference between the state and its quantized trajectory at time tx
+    double d[4], q[3] = {vi.q[0], vi.q[1], vi.q[2]};
+    shift(q, order - 1, vi.tx - vi.tq);
+    for (int k = 0; k < order; k++) {
+        d[k] = vi.x[k] - q[k];
+    }
+    d[order] = vi.x[order];
+    // The LIQSS methods also requantize when x reaches q
+    double const limit = (implicit) ? 2.0 * vi.quantum : vi.quantum;
+    if (fabs(d[0]) >= limit) {
+        vi.tn = vi.tx;
+        return;
+    }
+    double dt = (implicit) ? min_positive_root(d, order) : DBL_MAX;
+    // First time that the difference reaches plus or minus the limit
+    double const d0 = d[0];
+    d[0] = d0 - limit;
+    dt = std::min(dt, min_positive_root(d, order));
+    d[0] = d0 + limit;
+    dt = std::min(dt, min_positive_root(d, order));
+    vi.tn = (dt < DBL_MAX - vi.tx) ? vi.tx + dt : DBL_MAX;
+}
+
+template <typename ValueType, class TimeType>
+void QSS<ValueType, TimeType>::requantize(int k, double t) {
+    variable &vk = v[k];
+    shift(vk.x, order, t - vk.tx);
+    vk.tx = vk.tq = t;
+    vk.quantum = std::max(abs_tol, rel_tol * fabs(vk.x[0]));
+    if (implicit && reads_self[k]) {
+        implicit_quantize(k, t);
+    } else {
+        for (int j = 0; j < order; j++) {
+            vk.q[j] = vk.x[j];
+        }
+    }
+    updates++;
+    // Update the derivatives that read q[k]
+    bool self = false;
+    int const* row = read_by.col_index();
+    for (int m = read_by.row_start()[k]; m < read_by.row_start()[k + 1]; m++) {
+        int i = row[m];
+        self = self || (i == k);
+        derivatives(i, t);
+        next_time(i);
+        heap_update(i);
+    }
+    if (!self) {
+        next_time(k);
+        heap_update(k);
+    }
+}
+
+template <typename ValueType, class TimeType>
+void QSS<ValueType, TimeType>::schedule() {
+    int const M = sys->numEvents();
+    double const t_update = heap.empty() ? DBL_MAX : v[heap[0]].tn;
+    t_next = std::min(t_update, t_time_event);
+    event_exists = false;
+    for (int i = 0; i < M; i++) {
+        event[i] = false;
+    }
+    // Look for state events along the trajectories up to t_next
+    if (M > 0 && t_next < DBL_MAX) {
+        double h = t_next - t_now;
+        states_at(q_start, t_now);
+        states_at(q_end, t_next);
+        double const h_max = h;
+        event_exists = event_finder->find_events(event, q_start, q_end, &traj, h);
+        // The locator may also stop short of an event
+        if (h != h_max) {
+            t_next = t_now + h;
+        }
+    }
+    event[M] = t_time_event <= t_next;
+    event_exists = event_exists || event[M];
+}
+
+template <typename ValueType, class TimeType>
+void QSS<ValueType, TimeType>::heap_update(int i) {
+    int pos = v[i].pos;
+    double const tn = v[i].tn;
+    while (pos > 0 && v[heap[(pos - 1) / 2]].tn > tn) {
+        heap[pos] = heap[(pos - 1) / 2];
+        v[heap[pos]].pos = pos;
+        pos = (pos - 1) / 2;
+    }
+    heap[pos] = i;
+    v[i].pos = pos;
+    sift_down(pos);
+}
+
+template <typename ValueType, class TimeType>
+void QSS<ValueType, TimeType>::sift_down(int pos) {
+    int const n = static_cast<int>(heap.size());
+    int const i = heap[pos];
+    double const tn = v[i].tn;
+    for (;;) {
+        int child = 2 * pos + 1;
+        if (child >= n) {
+            break;
+        }
+        if (child + 1 < n && v[heap[child + 1]].tn < v[heap[child]].tn) {
+            child++;
+        }
+        if (v[heap[child]].tn >= tn) {
+            break;
+        }
+        heap[pos] = heap[child];
+        v[heap[pos]].pos = pos;
+        pos = child;
+    }
+    heap[pos] = i;
+    v[i].pos = pos;
+}
+
+}  // namespace adevs
+#endif
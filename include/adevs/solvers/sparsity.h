@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) 2025, James Nutaro
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ *
+ * Bugs, comments, and questions can be sent to nutaro@gmail.com
+ */
+
+#ifndef _adevs_sparsity_h_
+#define _adevs_sparsity_h_
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+#include "adevs/exception.h"
+
+namespace adevs {
+
+/**
+ * @brief The pattern of nonzero entries in a sparse matrix stored in
+ * compressed sparse row format.
+ *
+ * The columns of the entries in row i are col_index()[row_start()[i]]
+ * through col_index()[row_start()[i+1]-1] in increasing order. For the
+ * Jacobian of an ode_system, row i lists the state variables that are
+ * read by the derivative of variable i.
+ */
+class sparsity_pattern {
+  public:
+    /// @brief Create an empty pattern with no rows
+    sparsity_pattern() : n_rows(0), n_cols(0), start(1, 0) {}
+
+    /**
+     * @brief Create a pattern from a list of entries.
+     *
+     * The entries may be in any order and duplicates are removed.
+     *
+     * @param rows The number of rows in the matrix
+     * @param cols The number of columns in the matrix
+     * @param entries The (row,column) pairs of the nonzero entries
+     */
+    sparsity_pattern(int rows, int cols, std::vector<std::pair<int, int>> entries)
+        : n_rows(rows), n_cols(cols), start(rows + 1, 0) {
+        std::sort(entries.begin(), entries.end());
+        entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+        col.reserve(entries.size());
+        for (auto const &entry : entries) {
+            if (entry.first < 0 || entry.first >= rows || entry.second < 0 ||
+                entry.second >= cols) {
+                throw adevs::exception("Sparsity pattern entry is outside of the matrix");
+            }
+            start[entry.first + 1]++;
+            col.push_back(entry.second);
+        }
+        for (int i = 0; i < rows; i++) {
+            start[i + 1] += start[i];
+        }
+    }
+
+    /**
+     * @brief Create a pattern in which every entry is nonzero.
+     *
+     * @param rows The number of rows in the matrix
+     * @param cols The number of columns in the matrix
+     */
+    static sparsity_pattern dense(int rows, int cols) {
+        sparsity_pattern p;
+        p.n_rows = rows;
+        p.n_cols = cols;
+        p.start.resize(rows + 1);
+        p.col.resize(static_cast<size_t>(rows) * cols);
+        for (int i = 0; i <= rows; i++) {
+            p.start[i] = i * cols;
+        }
+        for (size_t k = 0; k < p.col.size(); k++) {
+            p.col[k] = k % cols;
+        }
+        return p;
+    }
+
+    /// @brief The pattern of the transposed matrix
+    sparsity_pattern transpose() const {
+        sparsity_pattern p;
+        p.n_rows = n_cols;
+        p.n_cols = n_rows;
+        p.start.assign(n_cols + 1, 0);
+        p.col.resize(col.size());
+        for (int j : col) {
+            p.start[j + 1]++;
+        }
+        for (int j = 0; j < n_cols; j++) {
+            p.start[j + 1] += p.start[j];
+        }
+        std::vector<int> next(p.start.begin(), p.start.end() - 1);
+        for (int i = 0; i < n_rows; i++) {
+            for (int k = start[i]; k < start[i + 1]; k++) {
+                p.col[next[col[k]]++] = i;
+            }
+        }
+        return p;
+    }
+
+    /**
+     * @brief Group the columns so that no two columns in a group have an
+     * entry in the same row.
+     *
+     * This is the greedy grouping of Curtis, Powell, and Reid. The columns
+     * of a group can be perturbed together when a Jacobian is approximated
+     * with difference quotients, because each row sees the perturbation of
+     * at most one of them.
+     *
+     * @return The group of each column numbered from zero
+     */
+    std::vector<int> color_columns() const {
+        sparsity_pattern const by_col = transpose();
+        std::vector<int> color(n_cols, -1);
+        // The last column that claimed each color
+        std::vector<int> used_by(n_cols, -1);
+        for (int j = 0; j < n_cols; j++) {
+            for (int k = by_col.start[j]; k < by_col.start[j + 1]; k++) {
+                int const i = by_col.col[k];
+                for (int kk = start[i]; kk < start[i + 1]; kk++) {
+                    if (color[col[kk]] >= 0) {
+                        used_by[color[col[kk]]] = j;
+                    }
+                }
+            }
+            int c = 0;
+            while (used_by[c] == j) {
+                c++;
+            }
+            color[j] = c;
+        }
+        return color;
+    }
+
+    /// @brief Get the number of rows
+    int rows() const { return n_rows; }
+    /// @brief Get the number of columns
+    int cols() const { return n_cols; }
+    /// @brief Get the number of nonzero entries
+    int nnz() const { return start[n_rows]; }
+    /// @brief True if the pattern has no rows
+    bool empty() const { return n_rows == 0; }
+    /// @brief Offsets of the rows in col_index(). This array has rows()+1 entries.
+    int const* row_start() const { return start.data(); }
+    /// @brief Column of each nonzero entry, row by row
+    int const* col_index() const { return col.data(); }
+
+  private:
+    int n_rows, n_cols;
+    std::vector<int> start, col;
+};
+
+}  // namespace adevs
+#endif
@@ -35,15 +35,22 @@
 #include <kinsol/kinsol.h>
 #include <nvector/nvector_serial.h>
 #include <sundials/sundials_types.h>
+#include <sunlinsol/sunlinsol_band.h>
 #include <sunlinsol/sunlinsol_dense.h>
+#include <sunmatrix/sunmatrix_band.h>
 #include <sunmatrix/sunmatrix_dense.h>
 #include <algorithm>
 #include <cassert>
 #include <cfloat>
+#include <climits>
 #include <cmath>
 #include <cstring>
+#include <utility>
+#include <vector>
+#include "adevs/solvers/colored_jacobian.h"
 #include "adevs/solvers/event_locators.h"
 #include "adevs/solvers/hybrid.h"
+#include "adevs/solvers/sparsity.h"
 
 namespace adevs {
 
@@ -51,17 +58,46 @@ namespace adevs {
  * @brief A second order accurate implicit method for numerical integration
  * of an ode_system der_func() 
  * 
- * This is the second order accurate trapezoidal method. You must supply
- * a Jacobian to use this integration method, otherwise it will approximate
- * the Jacobian numerically (and slowly!). Using this method requires that
+ * This is the second order accurate trapezoidal method. If you do not supply
+ * a Jacobian, then it is approximated with a colored_jacobian, which needs one
+ * der_func() call for each group of variables that do not share a derivative.
+ * The groups are found with the sparsity pattern from get_sparsity() or,
+ * if there is none, with a pattern detected at the first step and updated
+ * when a step fails. Using this method requires that
  * the KINSOL library from Sundials be installed and linked with your
  * application; see <https://computing.llnl.gov/projects/sundials/kinsol>
  * and there is probably a pre-built version packaged for your operating
  * system.
+ *
+ * If the ode_system supplies a sparsity pattern with get_sparsity() and
+ * that pattern lies within a band whose storage, N*(upper+2*lower+1)
+ * for upper and lower bandwidths, is smaller than N*N, then the Jacobian
+ * is stored and factored as a band matrix. Its entries are taken from
+ * get_sparse_jacobian() when that is supported and otherwise approximated
+ * with difference quotients. Only banded patterns avoid the dense matrix.
+ * Any other pattern, including one that is sparse but has entries far from
+ * the diagonal, is stored and factored as a dense N by N matrix; the pattern
+ * then only reduces the number of der_func() calls needed to approximate
+ * the Jacobian. Numbering the variables so that each derivative depends
+ * on nearby variables keeps the band narrow.
+ *
+ * The Newton iteration keeps its factored Jacobian from one step to the
+ * next. It is evaluated again when the step size changes by more than a
+ * set fraction, when the previous step needed too many iterations to
+ * converge, and when a step fails. See set_newton() and set_jacobian_refresh().
  */
 template <typename ValueType = std::any>
 class trap : public ode_solver<ValueType> {
   public:
+    /// @brief How often the Jacobian is evaluated by the Newton iteration
+    enum Newton {
+        /// A new Jacobian for every iteration of every step
+        FULL,
+        /// Reuse the Jacobian for up to ten iterations and across steps
+        MODIFIED,
+        /// Reuse the Jacobian until the iteration fails or the refresh policy asks for a new one
+        SIMPLIFIED
+    };
     /**
      * @brief Create an integrator that will use the given
      * maximum step size.
@@ -105,6 +141,29 @@ class trap : public ode_solver<ValueType> {
      * @param h The step in time by which to advance the solution
      */
     void advance(double* q, double h);
+    /**
+     * @brief Select the Newton iteration.
+     *
+     * The default is MODIFIED.
+     *
+     * @param mode How often to evaluate the Jacobian
+     */
+    void set_newton(Newton mode);
+    /**
+     * @brief Set the policy for evaluating the Jacobian at the start of a step.
+     *
+     * The Jacobian kept from an earlier step is used again unless the
+     * step size differs from the one it was computed for by more than
+     * the fraction h_change, or unless the previous step needed more
+     * than max_iters Newton iterations. This has no effect on FULL
+     * Newton iterations.
+     *
+     * @param h_change The largest relative change in step size. The default is 0.2.
+     * @param max_iters The largest number of iterations for a step. The default is 4.
+     */
+    void set_jacobian_refresh(double h_change, int max_iters);
+    /// @brief Get the number of Jacobian evaluations
+    long get_jacobian_evaluations();
 
   private:
     SUNContext sunctx;
@@ -117,6 +176,13 @@ class trap : public ode_solver<ValueType> {
     double const h_max;  // Maximum time step
     double h_cur;
 
+    // Jacobian reuse policy
+    Newton newton;
+    double h_change;
+    int max_iters;
+    double h_jac;      // Step size of the current Jacobian; zero if there is none
+    long last_iters;   // Newton iterations of the last step
+
     // Advance the solution q by h. Return result by overwriting q.
     // Returns true on success. On failure, returns false and q is
     // left alone. The dq0 argument contains the derivative f(q).
@@ -128,6 +194,16 @@ class trap : public ode_solver<ValueType> {
     SUNMatrix J;
     SUNLinearSolver LS;
 
+    // Structure of the Jacobian supplied by the ode_system
+    sparsity_pattern pattern;
+    bool banded;
+    bool sparse_values;
+    std::vector<double> jac_values;
+    // Difference quotients for a Jacobian that is not supplied
+    colored_jacobian<ValueType>* fd_jac;
+    bool detected;  // The pattern was found with colored_jacobian::detect()
+    bool redetect;  // Detect the pattern at the next evaluation
+
     struct kinsol_data_t {
         trap<ValueType>* self;
         double h;
@@ -136,6 +212,8 @@ class trap : public ode_solver<ValueType> {
     kinsol_data_t kinsol_data;
 
     void prep_kinsol(bool silent);
+    // Find the sparsity pattern at q and add it to the one we have
+    void detect_pattern(double const* q);
 
     static int func(N_Vector y, N_Vector f, void* user_data);
     static int jac(N_Vector y, N_Vector f, SUNMatrix J, void* user_data, N_Vector tmp1,
@@ -189,10 +267,41 @@ int trap<ValueType>::func(N_Vector y, N_Vector f, void* user_data) {
 template <typename ValueType>
 int trap<ValueType>::jac(N_Vector y, N_Vector, SUNMatrix J, void* user_data, N_Vector, N_Vector) {
     auto yd = N_VGetArrayPointer(y);
-    auto Jd = SUNDenseMatrix_Data(J);
     kinsol_data_t* data = static_cast<kinsol_data_t*>(user_data);
-    int const N = data->self->sys->numVars();
-    data->self->sys->get_jacobian(yd, Jd);
+    trap<ValueType>* self = data->self;
+    int const N = self->sys->numVars();
+    if (self->redetect) {
+        self->detect_pattern(yd);
+    }
+    // Scatter the nonzero entries into a band or dense matrix
+    if (self->sparse_values || self->fd_jac != nullptr) {
+        if (self->sparse_values) {
+            self->sys->get_sparse_jacobian(yd, self->jac_values.data());
+        } else {
+            self->fd_jac->evaluate(yd, self->jac_values.data());
+        }
+        SUNMatZero(J);
+        int const* start = self->pattern.row_start();
+        int const* col = self->pattern.col_index();
+        for (int i = 0; i < N; i++) {
+            for (int k = start[i]; k < start[i + 1]; k++) {
+                double const Jij = self->jac_values[k] * (data->h / 2.0);
+                if (self->banded) {
+                    SM_ELEMENT_B(J, i, col[k]) = Jij;
+                } else {
+                    SM_ELEMENT_D(J, i, col[k]) = Jij;
+                }
+            }
+            if (self->banded) {
+                SM_ELEMENT_B(J, i, i) -= 1.0;
+            } else {
+                SM_ELEMENT_D(J, i, i) -= 1.0;
+            }
+        }
+        return 0;
+    }
+    auto Jd = SUNDenseMatrix_Data(J);
+    self->sys->get_jacobian(yd, Jd);
     // Get the matrix for the linear solver
     for (int i = 0; i < N * N; i++) {
         Jd[i] *= data->h / 2.0;
@@ -203,6 +312,29 @@ int trap<ValueType>::jac(N_Vector y, N_Vector, SUNMatrix J, void* user_data, N_V
     return 0;
 }
 
+template <typename ValueType>
+void trap<ValueType>::detect_pattern(double const* q) {
+    int const N = this->sys->numVars();
+    sparsity_pattern found = colored_jacobian<ValueType>::detect(this->sys, q);
+    if (!pattern.empty()) {
+        std::vector<std::pair<int, int>> entries;
+        for (auto const* p : {&pattern, &found}) {
+            for (int i = 0; i < N; i++) {
+                for (int k = p->row_start()[i]; k < p->row_start()[i + 1]; k++) {
+                    entries.push_back(std::make_pair(i, p->col_index()[k]));
+                }
+            }
+        }
+        found = sparsity_pattern(N, N, entries);
+    }
+    pattern = found;
+    delete fd_jac;
+    fd_jac = new colored_jacobian<ValueType>(this->sys, pattern);
+    jac_values.resize(pattern.nnz());
+    detected = true;
+    redetect = false;
+}
+
 template <typename ValueType>
 void trap<ValueType>::prep_kinsol(bool silent) {
     int retval;
@@ -235,14 +367,46 @@ void trap<ValueType>::prep_kinsol(bool silent) {
 #endif
 
     N_VConst(1.0, scale);
-    J = SUNDenseMatrix(this->sys->numVars(), this->sys->numVars(), sunctx);
-    if (check_retval((void*)J, "SUNDenseMatrix", 0)) {
-        throw adevs::exception("SUNDenseMatrix failed");
+    /* Find the band that contains the Jacobian, if there is one */
+    int const N = this->sys->numVars();
+    int upper = 0, lower = 0;
+    pattern = this->sys->get_sparsity();
+    if (!pattern.empty()) {
+        if (pattern.rows() != N || pattern.cols() != N) {
+            throw adevs::exception("Sparsity pattern does not match the number of variables");
+        }
+        for (int i = 0; i < N; i++) {
+            for (int k = pattern.row_start()[i]; k < pattern.row_start()[i + 1]; k++) {
+                upper = std::max(upper, pattern.col_index()[k] - i);
+                lower = std::max(lower, i - pattern.col_index()[k]);
+            }
+        }
+        sparse_values = this->sys->get_sparse_jacobian(nullptr, nullptr);
+        jac_values.resize(sparse_values ? pattern.nnz() : 0);
     }
-    /* Create dense SUNLinearSolver object */
-    LS = SUNLinSol_Dense(y, J, sunctx);
-    if (check_retval((void*)LS, "SUNLinSol_Dense", 0)) {
-        throw adevs::exception("SUNLinSol_Dense failed");
+    // A band matrix keeps upper+2*lower+1 entries for each column to
+    // leave room for the fill in of its factors
+    banded = !pattern.empty() && upper + 2 * lower + 1 < N;
+    if (banded) {
+        J = SUNBandMatrix(N, upper, lower, sunctx);
+        if (check_retval((void*)J, "SUNBandMatrix", 0)) {
+            throw adevs::exception("SUNBandMatrix failed");
+        }
+        /* Create banded SUNLinearSolver object */
+        LS = SUNLinSol_Band(y, J, sunctx);
+        if (check_retval((void*)LS, "SUNLinSol_Band", 0)) {
+            throw adevs::exception("SUNLinSol_Band failed");
+        }
+    } else {
+        J = SUNDenseMatrix(N, N, sunctx);
+        if (check_retval((void*)J, "SUNDenseMatrix", 0)) {
+            throw adevs::exception("SUNDenseMatrix failed");
+        }
+        /* Create dense SUNLinearSolver object */
+        LS = SUNLinSol_Dense(y, J, sunctx);
+        if (check_retval((void*)LS, "SUNLinSol_Dense", 0)) {
+            throw adevs::exception("SUNLinSol_Dense failed");
+        }
     }
     /* Initialize and allocate memory for KINSOL */
     kmem = KINCreate(sunctx);
@@ -261,15 +425,21 @@ void trap<ValueType>::prep_kinsol(bool silent) {
     if (check_retval(&retval, "KINSetScaledStepTol", 1)) {
         throw adevs::exception("KINSetScaledStepTol failed");
     }
-    /* If there is support for symbolic jacobian, then register
-       the function. Otherwise KINSOL provides a numerical
-       approximation. */
-    if (this->sys->get_jacobian(NULL, NULL)) {
-        retval = KINSetJacFn(kmem, jac);
-        if (check_retval(&retval, "KINSetJacFn", 1)) {
-            throw adevs::exception("KINSetJacFn failed");
+    /* If there is no support for a symbolic jacobian, then
+       approximate it with difference quotients. A dense jacobian
+       can not fill a band matrix. */
+    if (!sparse_values && (banded || !this->sys->get_jacobian(NULL, NULL))) {
+        if (pattern.empty()) {
+            redetect = true;
+        } else {
+            fd_jac = new colored_jacobian<ValueType>(this->sys, pattern);
+            jac_values.resize(pattern.nnz());
         }
     }
+    retval = KINSetJacFn(kmem, jac);
+    if (check_retval(&retval, "KINSetJacFn", 1)) {
+        throw adevs::exception("KINSetJacFn failed");
+    }
     if (silent) {
 #if SUNDIALS_VERSION_MAJOR < 7
         KINSetErrHandlerFn(kmem, silent_error_handler, NULL);
@@ -284,7 +454,20 @@ void trap<ValueType>::prep_kinsol(bool silent) {
 
 template <typename ValueType>
 trap<ValueType>::trap(ode_system<ValueType>* sys, double err_tol, double h_max, bool silent)
-    : ode_solver<ValueType>(sys), err_tol(err_tol), h_max(h_max), h_cur(h_max) {
+    : ode_solver<ValueType>(sys),
+      err_tol(err_tol),
+      h_max(h_max),
+      h_cur(h_max),
+      newton(MODIFIED),
+      h_change(0.2),
+      max_iters(4),
+      h_jac(0.0),
+      last_iters(0),
+      banded(false),
+      sparse_values(false),
+      fd_jac(nullptr),
+      detected(false),
+      redetect(false) {
     guess = new double[sys->numVars()];
     dq = new double[sys->numVars()];
     k = new double[sys->numVars()];
@@ -297,6 +480,7 @@ trap<ValueType>::~trap() {
     delete[] guess;
     delete[] dq;
     delete[] k;
+    delete fd_jac;
     N_VDestroy(y);
     N_VDestroy(scale);
     KINFree(&kmem);
@@ -313,6 +497,32 @@ void trap<ValueType>::advance(double* q, double h) {
     }
 }
 
+template <typename ValueType>
+void trap<ValueType>::set_newton(Newton mode) {
+    newton = mode;
+    // The number of iterations between calls to the Jacobian. Zero
+    // selects the KINSOL default of ten.
+    long const msbset = (mode == FULL) ? 1 : (mode == MODIFIED) ? 0 : LONG_MAX;
+    int retval = KINSetMaxSetupCalls(kmem, msbset);
+    if (check_retval(&retval, "KINSetMaxSetupCalls", 1)) {
+        throw adevs::exception("KINSetMaxSetupCalls failed");
+    }
+    h_jac = 0.0;
+}
+
+template <typename ValueType>
+void trap<ValueType>::set_jacobian_refresh(double h_change, int max_iters) {
+    this->h_change = h_change;
+    this->max_iters = max_iters;
+}
+
+template <typename ValueType>
+long trap<ValueType>::get_jacobian_evaluations() {
+    long njevals = 0;
+    KINGetNumJacEvals(kmem, &njevals);
+    return njevals;
+}
+
 template <typename ValueType>
 bool trap<ValueType>::step(double* q, double h, double const* dq0) {
     int const N = this->sys->numVars();
@@ -324,14 +534,27 @@ bool trap<ValueType>::step(double* q, double h, double const* dq0) {
         guess[i] = yd[i] = q[i] + h * dq0[i];
     }
     kinsol_data.h = h;
+    // Decide if the Jacobian from an earlier step can be used again
+    bool const refresh = newton == FULL || h_jac == 0.0 || fabs(h - h_jac) > h_change * h_jac ||
+                         last_iters > max_iters;
+    KINSetNoInitSetup(kmem, !refresh);
+    long const njevals = get_jacobian_evaluations();
     int retval = KINSol(kmem,           /* KINSol memory block */
                         y,              /* initial guess on input; solution vector */
                         KIN_LINESEARCH, /* global strategy choice */
                         scale,          /* scaling vector, for the variable cc */
                         scale);         /* scaling vector for function values fval */
+    // Remember the step size of the newest Jacobian
+    if (get_jacobian_evaluations() > njevals) {
+        h_jac = h;
+    }
     if (retval < 0) {
+        // The detected pattern may have missed entries that were zero
+        redetect = detected;
+        h_jac = 0.0;
         return false;
     }
+    KINGetNumNonlinSolvIters(kmem, &last_iters);
     memcpy(q, yd, sizeof(double) * N);
     return true;
 }
@@ -384,7 +607,8 @@ double trap<ValueType>::integrate(double* q, double h_lim) {
  * for create a Hybrid object with a trap ODE solver and discontinuous_event_locator.
  * You need the <a href="https://computing.llnl.gov/projects/sundials/kinsol">KINSOL</a>
  * library, which is part of <a href="https://computing.llnl.gov/projects/sundials">SUNDIALS</a>
- * to use this solver.
+ * to use this solver. The trap solver uses a band matrix for the Jacobian
+ * if the ode_system supplies a sparsity pattern that lies in a narrow band.
  */
 template <typename ValueType = std::any>
 class ImplicitHybrid : public Hybrid<ValueType> {
@@ -34,8 +34,11 @@
 
 #include <cfloat>
 #include <cmath>
+#include <cstdint>
 #include <iostream>
 #include <limits>
+#include <ratio>
+#include <type_traits>
 
 
 /// @brief Returns the maximum value for a time type
@@ -102,9 +105,9 @@ class sd_time {
     /// @brief Order by t then by k
     bool operator<(sd_time const &t2) const { return (t < t2.t || (t == t2.t && k < t2.k)); }
     /// @brief Less than or equal
-    bool operator<=(sd_time const &t2) const { return (*this == t2 || *this < t2); }
+    bool operator<=(sd_time const &t2) const { return (t < t2.t || (t == t2.t && k <= t2.k)); }
     /// @brief Greater than
-    bool operator>(sd_time const &t2) const { return !(*this <= t2); }
+    bool operator>(sd_time const &t2) const { return t2 < *this; }
     /// @brief Greater than or equal
     bool operator>=(sd_time const &t2) const { return !(*this < t2); }
     /// Advance this value by a step size t2
@@ -166,7 +169,8 @@ class sd_time {
  * 
  * It may be useful for simulating with time granules as described in the article
  * <a href = "https://dl.acm.org/doi/10.1145/268823.268901">"The threshold of
- * event simultaneity"</a>.
+ * event simultaneity"</a>. The Simulator::set_time_granule() method
+ * is another way to do this that works with any time type.
  */
 class double_fcmp {
 
@@ -251,6 +255,276 @@ class double_fcmp {
     static int fcmp(double x1, double x2, double epsilon);
 };
 
+
+/**
+ * @brief A super dense time type with an integer real part that is
+ * packed into a single unsigned key.
+ *
+ * This has the same meaning and arithmetic as sd_time<IntType>, but
+ * the pair (t,k) is stored as one unsigned integer with the real part
+ * in the high bits and the logical part in the low 32 bits. Both
+ * parts are stored with their sign bit flipped so that the order of
+ * the keys is the lexicographic order of the pairs. Every comparison
+ * is then a single unsigned compare, which makes this type much
+ * cheaper than sd_time for the Schedule. A real part of up to 32 bits
+ * packs into 64 bits. A 64 bit real part packs into an unsigned
+ * __int128 where the compiler supports it and otherwise into a pair
+ * of 64 bit words.
+ *
+ * @tparam IntType A signed integer type for the real part of time.
+ */
+template <typename IntType = int>
+class packed_sd_time {
+    static_assert(std::is_integral<IntType>::value && std::is_signed<IntType>::value,
+                  "The real part must be a signed integer");
+    static_assert(sizeof(IntType) <= 8, "The real part must fit in 64 bits");
+
+  public:
+    /// @brief Creates the zero value (0,0)
+    packed_sd_time() : key(pack(0, 0)) {}
+    /// @brief Create a time (t,k)
+    packed_sd_time(IntType t, int k) : key(pack(t, k)) {}
+    /// @brief Get the real part of time
+    IntType real() const { return unpack_real(key); }
+    /// @brief Get the logical (integer) part of time
+    int integer() const { return unpack_integer(key); }
+    /// @brief Equivalence
+    bool operator==(packed_sd_time const &t2) const { return key == t2.key; }
+    /// @brief Not equal
+    bool operator!=(packed_sd_time const &t2) const { return !(key == t2.key); }
+    /// @brief Order by t then by k
+    bool operator<(packed_sd_time const &t2) const { return key < t2.key; }
+    /// @brief Less than or equal
+    bool operator<=(packed_sd_time const &t2) const { return !(t2.key < key); }
+    /// @brief Greater than
+    bool operator>(packed_sd_time const &t2) const { return t2.key < key; }
+    /// @brief Greater than or equal
+    bool operator>=(packed_sd_time const &t2) const { return !(key < t2.key); }
+    /// @brief Advance this value by a step size t2
+    packed_sd_time operator+(packed_sd_time const &t2) const {
+        packed_sd_time result(*this);
+        result += t2;
+        return result;
+    }
+    /// @brief Advance this value by a step size t2
+    packed_sd_time const &operator+=(packed_sd_time const &t2) {
+        IntType dt = t2.real();
+        if (dt == 0) {
+            key = pack(real(), integer() + t2.integer());
+        } else {
+            key = pack(real() + dt, t2.integer());
+        }
+        return *this;
+    }
+    /// @brief Length of the interval from now to t2
+    packed_sd_time operator-(packed_sd_time const &t2) const {
+        packed_sd_time result(*this);
+        result -= t2;
+        return result;
+    }
+    /// @brief Length of the interval from now to t2
+    packed_sd_time const &operator-=(packed_sd_time const &t2) {
+        IntType t = real(), t1 = t2.real();
+        if (t == t1) {
+            key = pack(0, integer() - t2.integer());
+        } else {
+            key = pack(t - t1, integer());
+        }
+        return *this;
+    }
+    /// @brief Print a time to the output stream
+    friend std::ostream &operator<<(std::ostream &out, packed_sd_time const &t) {
+        out << "(" << t.real() << "," << t.integer() << ")";
+        return out;
+    }
+    /// @brief Read a time from the input stream
+    friend std::istream &operator>>(std::istream &in, packed_sd_time &t) {
+        char junk;
+        IntType real;
+        int k;
+        in >> junk >> real >> junk >> k >> junk;
+        t = packed_sd_time(real, k);
+        return in;
+    }
+
+  private:
+    using real_bits = typename std::make_unsigned<IntType>::type;
+    static constexpr real_bits real_sign = real_bits(1) << (8 * sizeof(IntType) - 1);
+    static constexpr uint32_t integer_sign = uint32_t(1) << 31;
+
+#if defined(__SIZEOF_INT128__)
+    __extension__ typedef unsigned __int128 wide_key;
+#else
+    // The high and low words of a 128 bit key
+    struct wide_key {
+        uint64_t hi, lo;
+        bool operator==(wide_key const &other) const { return hi == other.hi && lo == other.lo; }
+        bool operator<(wide_key const &other) const {
+            return (hi < other.hi) | ((hi == other.hi) & (lo < other.lo));
+        }
+    };
+#endif
+    using key_t = typename std::conditional<(sizeof(IntType) <= 4), uint64_t, wide_key>::type;
+
+    key_t key;
+
+    static key_t pack(IntType t, int k) {
+        uint64_t high = uint64_t(real_bits(t) ^ real_sign);
+        uint32_t low = uint32_t(k) ^ integer_sign;
+        if constexpr (std::is_same<key_t, uint64_t>::value) {
+            return (high << 32) | low;
+        } else {
+#if defined(__SIZEOF_INT128__)
+            return (key_t(high) << 32) | low;
+#else
+            return key_t{high >> 32, (high << 32) | low};
+#endif
+        }
+    }
+    static IntType unpack_real(key_t key) {
+#if defined(__SIZEOF_INT128__)
+        return IntType(real_bits(key >> 32) ^ real_sign);
+#else
+        if constexpr (std::is_same<key_t, uint64_t>::value) {
+            return IntType(real_bits(key >> 32) ^ real_sign);
+        } else {
+            return IntType(real_bits((key.hi << 32) | (key.lo >> 32)) ^ real_sign);
+        }
+#endif
+    }
+    static int unpack_integer(key_t key) {
+#if defined(__SIZEOF_INT128__)
+        return int(uint32_t(key) ^ integer_sign);
+#else
+        if constexpr (std::is_same<key_t, uint64_t>::value) {
+            return int(uint32_t(key) ^ integer_sign);
+        } else {
+            return int(uint32_t(key.lo) ^ integer_sign);
+        }
+#endif
+    }
+};
+
+/**
+ * @brief A fixed point time type that counts ticks with a 64 bit integer.
+ *
+ * Time is measured in the units of your model, as it is with double,
+ * but it is stored as a whole number of ticks whose length is
+ * Resolution units. With the default resolution of std::nano and
+ * time in seconds, each tick is a nanosecond and times up to about
+ * 292 years can be represented. Because every operation is on
+ * integers, events that should be simultaneous are exactly equal,
+ * and comparisons in the schedule are as fast as for int.
+ *
+ * A double is rounded to the nearest tick when it is converted to
+ * a fixed_time. Integers are converted exactly. The largest value is
+ * adevs_inf() and sums that would exceed it saturate at adevs_inf().
+ *
+ * The limits adevs_inf(), adevs_zero(), adevs_epsilon(), and
+ * adevs_sentinel() are defined for std::nano, std::micro, and std::milli.
+ *
+ * @tparam Resolution A std::ratio that is the length of a tick in model units.
+ */
+template <class Resolution = std::nano>
+class fixed_time {
+  public:
+    /// @brief The number of ticks for the largest value
+    static constexpr int64_t max_ticks = std::numeric_limits<int64_t>::max();
+    /// @brief Creates the zero value
+    constexpr fixed_time() : ticks(0) {}
+    /// @brief Create a time from a number of model units, which is rounded to the nearest tick
+    fixed_time(double t) : ticks(to_ticks(t)) {}
+    /// @brief Create a time from a whole number of model units
+    template <typename IntType,
+              typename std::enable_if<std::is_integral<IntType>::value, int>::type = 0>
+    constexpr fixed_time(IntType t) : ticks(saturate_mul(int64_t(t))) {}
+    /// @brief Create a time from a number of ticks
+    static constexpr fixed_time from_ticks(int64_t n) {
+        fixed_time result;
+        result.ticks = n;
+        return result;
+    }
+    /// @brief Get the number of ticks
+    constexpr int64_t get_ticks() const { return ticks; }
+    /// @brief Get the time in model units. The largest value becomes the largest double.
+    explicit operator double() const {
+        if (ticks == max_ticks) {
+            return std::numeric_limits<double>::max();
+        }
+        return double(ticks) * double(Resolution::num) / double(Resolution::den);
+    }
+    /// @brief Equivalence
+    constexpr bool operator==(fixed_time const &t2) const { return ticks == t2.ticks; }
+    /// @brief Not equal
+    constexpr bool operator!=(fixed_time const &t2) const { return ticks != t2.ticks; }
+    /// @brief Less than
+    constexpr bool operator<(fixed_time const &t2) const { return ticks < t2.ticks; }
+    /// @brief Less than or equal
+    constexpr bool operator<=(fixed_time const &t2) const { return ticks <= t2.ticks; }
+    /// @brief Greater than
+    constexpr bool operator>(fixed_time const &t2) const { return ticks > t2.ticks; }
+    /// @brief Greater than or equal
+    constexpr bool operator>=(fixed_time const &t2) const { return ticks >= t2.ticks; }
+    /// @brief Advance this value by a step size t2, saturating at adevs_inf()
+    fixed_time operator+(fixed_time const &t2) const {
+        fixed_time result(*this);
+        result += t2;
+        return result;
+    }
+    /// @brief Advance this value by a step size t2, saturating at adevs_inf()
+    fixed_time const &operator+=(fixed_time const &t2) {
+        if (t2.ticks > 0 && ticks > max_ticks - t2.ticks) {
+            ticks = max_ticks;
+        } else {
+            ticks += t2.ticks;
+        }
+        return *this;
+    }
+    /// @brief Length of the interval from t2 to now. Infinity less a finite time is infinity.
+    fixed_time operator-(fixed_time const &t2) const {
+        fixed_time result(*this);
+        result -= t2;
+        return result;
+    }
+    /// @brief Length of the interval from t2 to now. Infinity less a finite time is infinity.
+    fixed_time const &operator-=(fixed_time const &t2) {
+        if (ticks != max_ticks || t2.ticks == max_ticks) {
+            ticks -= t2.ticks;
+        }
+        return *this;
+    }
+    /// @brief Print a time in model units to the output stream
+    friend std::ostream &operator<<(std::ostream &out, fixed_time const &t) {
+        out << double(t);
+        return out;
+    }
+    /// @brief Read a time in model units from the input stream
+    friend std::istream &operator>>(std::istream &in, fixed_time &t) {
+        double d;
+        in >> d;
+        t = fixed_time(d);
+        return in;
+    }
+
+  private:
+    int64_t ticks;
+
+    static int64_t to_ticks(double t) {
+        double scaled = std::round(t * double(Resolution::den) / double(Resolution::num));
+        if (!(scaled < 9.2e18)) {
+            return max_ticks;
+        } else if (scaled < -9.2e18) {
+            return -max_ticks;
+        }
+        return int64_t(scaled);
+    }
+    // Ticks in a whole number of model units
+    static constexpr int64_t saturate_mul(int64_t t) {
+        static_assert(Resolution::num == 1, "Use ticks shorter than one unit");
+        return (t > max_ticks / Resolution::den) ? max_ticks : t * Resolution::den;
+    }
+};
+
 }  // namespace adevs
 
 template <>
@@ -290,6 +564,33 @@ template <>
 inline adevs::sd_time<int> adevs_inf() {
     return adevs::sd_time<int>(std::numeric_limits<int>::max(), std::numeric_limits<int>::max());
 }
+template <>
+inline adevs::packed_sd_time<int> adevs_inf() {
+    return adevs::packed_sd_time<int>(std::numeric_limits<int>::max(),
+                                      std::numeric_limits<int>::max());
+}
+template <>
+inline adevs::packed_sd_time<long> adevs_inf() {
+    return adevs::packed_sd_time<long>(std::numeric_limits<long>::max(),
+                                       std::numeric_limits<int>::max());
+}
+template <>
+inline adevs::packed_sd_time<long long> adevs_inf() {
+    return adevs::packed_sd_time<long long>(std::numeric_limits<long long>::max(),
+                                            std::numeric_limits<int>::max());
+}
+template <>
+inline adevs::fixed_time<std::nano> adevs_inf() {
+    return adevs::fixed_time<std::nano>::from_ticks(adevs::fixed_time<std::nano>::max_ticks);
+}
+template <>
+inline adevs::fixed_time<std::micro> adevs_inf() {
+    return adevs::fixed_time<std::micro>::from_ticks(adevs::fixed_time<std::micro>::max_ticks);
+}
+template <>
+inline adevs::fixed_time<std::milli> adevs_inf() {
+    return adevs::fixed_time<std::milli>::from_ticks(adevs::fixed_time<std::milli>::max_ticks);
+}
 
 template <>
 inline float adevs_zero() {
@@ -327,6 +628,30 @@ template <>
 inline adevs::sd_time<int> adevs_zero() {
     return adevs::sd_time<int>(0, 0);
 }
+template <>
+inline adevs::packed_sd_time<int> adevs_zero() {
+    return adevs::packed_sd_time<int>(0, 0);
+}
+template <>
+inline adevs::packed_sd_time<long> adevs_zero() {
+    return adevs::packed_sd_time<long>(0, 0);
+}
+template <>
+inline adevs::packed_sd_time<long long> adevs_zero() {
+    return adevs::packed_sd_time<long long>(0, 0);
+}
+template <>
+inline adevs::fixed_time<std::nano> adevs_zero() {
+    return adevs::fixed_time<std::nano>::from_ticks(0);
+}
+template <>
+inline adevs::fixed_time<std::micro> adevs_zero() {
+    return adevs::fixed_time<std::micro>::from_ticks(0);
+}
+template <>
+inline adevs::fixed_time<std::milli> adevs_zero() {
+    return adevs::fixed_time<std::milli>::from_ticks(0);
+}
 
 template <>
 inline float adevs_sentinel() {
@@ -364,6 +689,30 @@ template <>
 inline adevs::sd_time<int> adevs_sentinel() {
     return adevs::sd_time<int>(-1, 0);
 }
+template <>
+inline adevs::packed_sd_time<int> adevs_sentinel() {
+    return adevs::packed_sd_time<int>(-1, 0);
+}
+template <>
+inline adevs::packed_sd_time<long> adevs_sentinel() {
+    return adevs::packed_sd_time<long>(-1, 0);
+}
+template <>
+inline adevs::packed_sd_time<long long> adevs_sentinel() {
+    return adevs::packed_sd_time<long long>(-1, 0);
+}
+template <>
+inline adevs::fixed_time<std::nano> adevs_sentinel() {
+    return adevs::fixed_time<std::nano>::from_ticks(-1);
+}
+template <>
+inline adevs::fixed_time<std::micro> adevs_sentinel() {
+    return adevs::fixed_time<std::micro>::from_ticks(-1);
+}
+template <>
+inline adevs::fixed_time<std::milli> adevs_sentinel() {
+    return adevs::fixed_time<std::milli>::from_ticks(-1);
+}
 
 template <>
 inline float adevs_epsilon() {
@@ -401,5 +750,29 @@ template <>
 inline adevs::sd_time<int> adevs_epsilon() {
     return adevs::sd_time<int>(0, 1);
 }
+template <>
+inline adevs::packed_sd_time<int> adevs_epsilon() {
+    return adevs::packed_sd_time<int>(0, 1);
+}
+template <>
+inline adevs::packed_sd_time<long> adevs_epsilon() {
+    return adevs::packed_sd_time<long>(0, 1);
+}
+template <>
+inline adevs::packed_sd_time<long long> adevs_epsilon() {
+    return adevs::packed_sd_time<long long>(0, 1);
+}
+template <>
+inline adevs::fixed_time<std::nano> adevs_epsilon() {
+    return adevs::fixed_time<std::nano>::from_ticks(0);
+}
+template <>
+inline adevs::fixed_time<std::micro> adevs_epsilon() {
+    return adevs::fixed_time<std::micro>::from_ticks(0);
+}
+template <>
+inline adevs::fixed_time<std::milli> adevs_epsilon() {
+    return adevs::fixed_time<std::milli>::from_ticks(0);
+}
 
 #endif
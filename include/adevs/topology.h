@@ -0,0 +1,378 @@
+
+/*
+ * Copyright (c) 2025, James Nutaro
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ *
+ * Bugs, comments, and questions can be sent to nutaro@gmail.com
+ */
+#ifndef _adevs_topology_h_
+#define _adevs_topology_h_
+#include <any>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "adevs/exception.h"
+#include "adevs/graph.h"
+#include "adevs/graph_builder.h"
+#ifdef _WIN32
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace adevs {
+
+/**
+ * @brief Creates Atomic models from a type tag and identifier.
+ *
+ * A function is registered for each type tag. The function receives
+ * the identifier of the model and returns a new model.
+ */
+template <typename ValueType = std::any, typename TimeType = double>
+class model_factory {
+  public:
+    /// @brief The function that creates models with a given tag.
+    using maker_t = std::function<std::shared_ptr<Atomic<ValueType, TimeType>>(uint64_t id)>;
+    /// @brief Register the function that creates models with the given tag.
+    void add_type(uint32_t tag, maker_t maker) { makers[tag] = maker; }
+    /// @brief Create a model. An exception is thrown if the tag is unknown.
+    std::shared_ptr<Atomic<ValueType, TimeType>> operator()(uint64_t id, uint32_t tag) const {
+        auto iter = makers.find(tag);
+        if (iter == makers.end()) {
+            throw adevs::exception("No model type is registered for the tag");
+        }
+        return iter->second(id);
+    }
+
+  private:
+    std::map<uint32_t, maker_t> makers;
+};
+
+/**
+ * @brief Saves the structure of a Graph to a file and loads it back.
+ *
+ * The file is a compact binary list of models and edges. Each Atomic
+ * model is described by a stable identifier and a type tag that are
+ * supplied by the caller, and each pin is described by a stable
+ * identifier that is also supplied by the caller. This allows the
+ * file to be written by one program and loaded by another that makes
+ * the same models from their tags and finds the same pins from their
+ * identifiers. The file is loaded by mapping it into memory, so there
+ * is no parsing; the models and edges are handed to a GraphBuilder.
+ *
+ * The file uses the byte order of the machine that wrote it.
+ *
+ * @tparam ValueType The type of value exchanged by models in the Graph.
+ * @tparam TimeType The type used for time.
+ */
+template <typename ValueType = std::any, typename TimeType = double>
+class Topology {
+  public:
+    using atomic_ptr = std::shared_ptr<Atomic<ValueType, TimeType>>;
+    /// @brief The stable identifier and type tag of a model.
+    struct model_info {
+        uint64_t id;
+        uint32_t tag;
+    };
+    /**
+     * @brief Save the models and edges of a Graph.
+     *
+     * @param graph The Graph to save.
+     * @param file The name of the file to write.
+     * @param describe_model Returns the identifier and tag of a model.
+     * @param pin_id Returns the identifier of a pin.
+     * @param partition If not null, the partition of each model is saved
+     * with the model. This is usually made by a Partitioner.
+     */
+    static void save(Graph<ValueType, TimeType> const &graph, std::string const &file,
+                     std::function<model_info(atomic_ptr const &)> describe_model,
+                     std::function<uint64_t(pin_t)> pin_id,
+                     std::map<Atomic<ValueType, TimeType>*, int> const* partition = nullptr);
+    /**
+     * @brief Load models and edges into a Graph.
+     *
+     * The models are created first. After that the pins are found
+     * with pin_for_id(), which may therefore refer to the new models.
+     *
+     * @param graph The Graph that receives the models and edges.
+     * @param file The name of the file to read.
+     * @param factory Returns a new model for an identifier and tag.
+     * @param pin_for_id Returns the pin with an identifier.
+     * @param threads The number of threads to use for sorting the edges.
+     * @param partition If not null, this is filled with the partition of each
+     * model indexed by its identifier. It is left empty if the file has no partition.
+     * @return The new models indexed by their identifiers.
+     */
+    static std::map<uint64_t, atomic_ptr> load(
+        Graph<ValueType, TimeType> &graph, std::string const &file,
+        std::function<atomic_ptr(uint64_t id, uint32_t tag)> factory,
+        std::function<pin_t(uint64_t id)> pin_for_id, unsigned int threads = 1,
+        std::map<uint64_t, int>* partition = nullptr);
+
+  private:
+    static constexpr char magic[8] = {'A', 'D', 'E', 'V', 'S', 'T', 'O', 'P'};
+    static constexpr uint32_t version = 1;
+    // Set in the flags when the file ends with the partition of each model
+    static constexpr uint32_t has_partition = 1;
+    struct file_header {
+        char magic[8];
+        uint32_t version;
+        uint32_t flags;
+        uint64_t models, pins, pin_edges, atomic_edges;
+    };
+    struct model_record {
+        uint64_t id;
+        uint32_t tag;
+        uint32_t instances;
+    };
+    // Edges refer to pins and models by their position in the file
+    struct edge_record {
+        uint32_t src, dst, count;
+    };
+
+    // A read only view of a file in memory
+    class mapped_file {
+      public:
+        mapped_file(std::string const &file);
+        ~mapped_file();
+        char const* data() const { return begin; }
+        size_t size() const { return length; }
+
+      private:
+        char const* begin;
+        size_t length;
+#ifdef _WIN32
+        std::vector<char> buffer;
+#endif
+    };
+};
+
+template <typename ValueType, typename TimeType>
+Topology<ValueType, TimeType>::mapped_file::mapped_file(std::string const &file)
+    : begin(nullptr), length(0) {
+#ifdef _WIN32
+    std::ifstream in(file, std::ios::binary);
+    if (!in) {
+        throw adevs::exception("Could not open the topology file");
+    }
+    buffer.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    begin = buffer.data();
+    length = buffer.size();
+#else
+    int fd = open(file.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw adevs::exception("Could not open the topology file");
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        throw adevs::exception("Could not read the size of the topology file");
+    }
+    length = size_t(info.st_size);
+    if (length > 0) {
+        void* p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            close(fd);
+            throw adevs::exception("Could not map the topology file into memory");
+        }
+        begin = static_cast<char const*>(p);
+    }
+    close(fd);
+#endif
+}
+
+template <typename ValueType, typename TimeType>
+Topology<ValueType, TimeType>::mapped_file::~mapped_file() {
+#ifndef _WIN32
+    if (begin != nullptr) {
+        munmap(const_cast<char*>(begin), length);
+    }
+#endif
+}
+
+template <typename ValueType, typename TimeType>
+void Topology<ValueType, TimeType>::save(
+    Graph<ValueType, TimeType> const &graph, std::string const &file,
+    std::function<model_info(atomic_ptr const &)> describe_model,
+    std::function<uint64_t(pin_t)> pin_id,
+    std::map<Atomic<ValueType, TimeType>*, int> const* partition) {
+    std::vector<model_record> models;
+    std::vector<uint32_t> parts;
+    std::map<Atomic<ValueType, TimeType>*, uint32_t> model_index;
+    std::vector<uint64_t> pins;
+    std::map<pin_t, uint32_t> pin_index;
+    std::vector<edge_record> pin_edges, atomic_edges;
+    auto index_of = [&](pin_t pin) {
+        auto iter = pin_index.find(pin);
+        if (iter != pin_index.end()) {
+            return iter->second;
+        }
+        pins.push_back(pin_id(pin));
+        return pin_index[pin] = uint32_t(pins.size() - 1);
+    };
+    for (auto const &model : graph.models) {
+        model_info info = describe_model(model);
+        model_record r;
+        r.id = info.id;
+        r.tag = info.tag;
+        r.instances = uint32_t(graph.atomic_instance_count.at(model.get()));
+        model_index[model.get()] = uint32_t(models.size());
+        models.push_back(r);
+        if (partition != nullptr) {
+            auto iter = partition->find(model.get());
+            if (iter == partition->end()) {
+                throw adevs::exception("The model has no partition", model.get());
+            }
+            parts.push_back(uint32_t(iter->second));
+        }
+    }
+    for (auto const &src : graph.pin_to_pin) {
+        for (auto const &dst : src.second) {
+            pin_edges.push_back({index_of(src.first), index_of(dst.first), uint32_t(dst.second)});
+        }
+    }
+    for (auto const &src : graph.pin_to_atomic) {
+        for (auto const &dst : src.second) {
+            auto iter = model_index.find(dst.first.get());
+            if (iter == model_index.end()) {
+                throw adevs::exception("An edge leads to a model that is not in the Graph",
+                                       dst.first.get());
+            }
+            atomic_edges.push_back({index_of(src.first), iter->second, uint32_t(dst.second)});
+        }
+    }
+    file_header header;
+    memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.flags = (partition != nullptr) ? has_partition : 0;
+    header.models = models.size();
+    header.pins = pins.size();
+    header.pin_edges = pin_edges.size();
+    header.atomic_edges = atomic_edges.size();
+    std::ofstream out(file, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<char const*>(&header), sizeof(header));
+    out.write(reinterpret_cast<char const*>(models.data()), models.size() * sizeof(model_record));
+    out.write(reinterpret_cast<char const*>(pins.data()), pins.size() * sizeof(uint64_t));
+    out.write(reinterpret_cast<char const*>(pin_edges.data()),
+              pin_edges.size() * sizeof(edge_record));
+    out.write(reinterpret_cast<char const*>(atomic_edges.data()),
+              atomic_edges.size() * sizeof(edge_record));
+    out.write(reinterpret_cast<char const*>(parts.data()), parts.size() * sizeof(uint32_t));
+    if (!out) {
+        throw adevs::exception("Could not write the topology file");
+    }
+}
+
+template <typename ValueType, typename TimeType>
+std::map<uint64_t, typename Topology<ValueType, TimeType>::atomic_ptr>
+Topology<ValueType, TimeType>::load(Graph<ValueType, TimeType> &graph, std::string const &file,
+                                    std::function<atomic_ptr(uint64_t id, uint32_t tag)> factory,
+                                    std::function<pin_t(uint64_t id)> pin_for_id,
+                                    unsigned int threads, std::map<uint64_t, int>* partition) {
+    if (partition != nullptr) {
+        partition->clear();
+    }
+    mapped_file mapped(file);
+    file_header header;
+    if (mapped.size() < sizeof(header)) {
+        throw adevs::exception("The topology file is too short");
+    }
+    memcpy(&header, mapped.data(), sizeof(header));
+    if (memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != version) {
+        throw adevs::exception("The file does not contain a topology");
+    }
+    if (mapped.size() != sizeof(header) + header.models * sizeof(model_record) +
+                             header.pins * sizeof(uint64_t) +
+                             (header.pin_edges + header.atomic_edges) * sizeof(edge_record) +
+                             ((header.flags & has_partition) ? header.models * sizeof(uint32_t)
+                                                             : 0)) {
+        throw adevs::exception("The size of the topology file is wrong");
+    }
+    // The sections are read in place
+    char const* p = mapped.data() + sizeof(header);
+    model_record const* models = reinterpret_cast<model_record const*>(p);
+    p += header.models * sizeof(model_record);
+    uint64_t const* pin_ids = reinterpret_cast<uint64_t const*>(p);
+    p += header.pins * sizeof(uint64_t);
+    edge_record const* pin_edges = reinterpret_cast<edge_record const*>(p);
+    p += header.pin_edges * sizeof(edge_record);
+    edge_record const* atomic_edges = reinterpret_cast<edge_record const*>(p);
+    p += header.atomic_edges * sizeof(edge_record);
+    uint32_t const* parts = reinterpret_cast<uint32_t const*>(p);
+    // Create the models and then find the pins
+    std::vector<atomic_ptr> made(header.models);
+    std::map<uint64_t, atomic_ptr> result;
+    GraphBuilder<ValueType, TimeType> builder;
+    builder.reserve(header.models, header.pin_edges, header.atomic_edges);
+    for (uint64_t i = 0; i < header.models; i++) {
+        made[i] = factory(models[i].id, models[i].tag);
+        result[models[i].id] = made[i];
+        if (partition != nullptr && (header.flags & has_partition)) {
+            (*partition)[models[i].id] = int(parts[i]);
+        }
+        for (uint32_t k = 0; k < models[i].instances; k++) {
+            builder.add_atomic(made[i]);
+        }
+    }
+    std::vector<pin_t> pins;
+    pins.reserve(header.pins);
+    for (uint64_t i = 0; i < header.pins; i++) {
+        pins.push_back(pin_for_id(pin_ids[i]));
+    }
+    for (uint64_t i = 0; i < header.pin_edges; i++) {
+        edge_record const &e = pin_edges[i];
+        if (e.src >= header.pins || e.dst >= header.pins) {
+            throw adevs::exception("The topology file has an edge to a missing pin");
+        }
+        for (uint32_t k = 0; k < e.count; k++) {
+            builder.connect(pins[e.src], pins[e.dst]);
+        }
+    }
+    for (uint64_t i = 0; i < header.atomic_edges; i++) {
+        edge_record const &e = atomic_edges[i];
+        if (e.src >= header.pins || e.dst >= header.models) {
+            throw adevs::exception("The topology file has an edge to a missing model");
+        }
+        for (uint32_t k = 0; k < e.count; k++) {
+            builder.connect(pins[e.src], made[e.dst]);
+        }
+    }
+    builder.build(graph, threads);
+    return result;
+}
+
+}  // namespace adevs
+
+#endif
@@ -0,0 +1,181 @@
+/**
+ * Test cases for the AgentBatch. The batch is compared to
+ * a population of Atomic models with the same behavior.
+ */
+#include <cassert>
+#include <map>
+#include <memory>
+#include <vector>
+#include "adevs/adevs.h"
+
+using PinValue = adevs::PinValue<int>;
+using pin_t = adevs::pin_t;
+using Simulator = adevs::Simulator<int>;
+using Atomic = adevs::Atomic<int>;
+using Graph = adevs::Graph<int>;
+
+// Agent i sends its identity every period(i) units of time. An
+// input with value i makes agent i wait for a full period.
+double period(int i) {
+    return 1.0 + (i % 7) * 0.5;
+}
+
+class Agent : public Atomic {
+  public:
+    Agent(int id, pin_t output) : Atomic(), id(id), sent(0), output(output) {}
+    double ta() { return (sent < 20) ? period(id) : adevs_inf<double>(); }
+    void delta_int() { sent++; }
+    void delta_ext(double, std::list<PinValue> const &) {}
+    void delta_conf(std::list<PinValue> const &) { delta_int(); }
+    void output_func(std::list<PinValue> &yb) { yb.push_back(PinValue(output, id)); }
+    int const id;
+    int sent;
+
+  private:
+    pin_t const output;
+};
+
+class Batch : public adevs::AgentBatch<int> {
+  public:
+    Batch(int n, pin_t output) : adevs::AgentBatch<int>(n), sent(n, 0), output(output) {}
+    double agent_ta(unsigned int i) { return (sent[i] < 20) ? period(i) : adevs_inf<double>(); }
+    void agent_output(std::vector<unsigned int> const &imminent, std::list<PinValue> &yb) {
+        for (auto i : imminent) {
+            yb.push_back(PinValue(output, i));
+        }
+    }
+    void agent_internal(std::vector<unsigned int> const &imminent) {
+        for (auto i : imminent) {
+            sent[i]++;
+        }
+    }
+    void agent_external(std::list<PinValue> const &xb) {
+        for (auto const &x : xb) {
+            touch(x.value);
+        }
+    }
+    std::vector<int> sent;
+
+  private:
+    pin_t const output;
+};
+
+// Sends input to one agent at a time on the agent's own pin
+class Disturbance : public Atomic {
+  public:
+    Disturbance(int n) : Atomic(), pins(n), k(0) {}
+    double ta() { return (k < 30) ? 1.25 : adevs_inf<double>(); }
+    void delta_int() { k++; }
+    void delta_ext(double, std::list<PinValue> const &) {}
+    void delta_conf(std::list<PinValue> const &) {}
+    void output_func(std::list<PinValue> &yb) {
+        int i = (k * 13) % pins.size();
+        yb.push_back(PinValue(pins[i], i));
+    }
+    std::vector<pin_t> pins;
+
+  private:
+    int k;
+};
+
+// Records the time of every output of every agent
+class Recorder : public Atomic {
+  public:
+    Recorder() : Atomic(), t(0.0) {}
+    double ta() { return adevs_inf<double>(); }
+    void delta_int() {}
+    void delta_ext(double e, std::list<PinValue> const &xb) {
+        t += e;
+        for (auto const &x : xb) {
+            log[x.value].push_back(t);
+        }
+    }
+    void delta_conf(std::list<PinValue> const &xb) { delta_ext(0.0, xb); }
+    void output_func(std::list<PinValue> &) {}
+    std::map<int, std::vector<double>> log;
+
+  private:
+    double t;
+};
+
+std::map<int, std::vector<double>> run(bool batch, int n) {
+    auto graph = std::make_shared<Graph>();
+    auto recorder = std::make_shared<Recorder>();
+    auto disturbance = std::make_shared<Disturbance>(n);
+    pin_t output;
+    graph->add_atomic(recorder);
+    graph->add_atomic(disturbance);
+    graph->connect(output, recorder);
+    if (batch) {
+        auto b = std::make_shared<Batch>(n, output);
+        graph->add_atomic(b);
+        for (auto pin : disturbance->pins) {
+            graph->connect(pin, b);
+        }
+    } else {
+        for (int i = 0; i < n; i++) {
+            auto a = std::make_shared<Agent>(i, output);
+            graph->add_atomic(a);
+            graph->connect(disturbance->pins[i], a);
+        }
+    }
+    Simulator sim(graph);
+    sim.run_until(adevs_inf<double>());
+    return recorder->log;
+}
+
+// The batch produces the same output as a population of Atomic models
+void test1() {
+    int const n = 50;
+    auto expect = run(false, n);
+    auto log = run(true, n);
+    assert(int(log.size()) == n);
+    assert(log == expect);
+    for (int i = 0; i < n; i++) {
+        assert(log[i].size() == 20);
+    }
+}
+
+// Agents can be added while the simulation is running
+void test2() {
+    pin_t output;
+    auto batch = std::make_shared<Batch>(1, output);
+    Simulator sim(batch);
+    assert(sim.nextEventTime() == 1.0);
+    sim.execNextEvent();
+    batch->sent.resize(3, 0);
+    assert(batch->add_agents(2) == 1);
+    assert(batch->next_event(1) == 1.0 + period(1));
+    assert(batch->next_event(2) == 1.0 + period(2));
+    while (sim.nextEventTime() < 10.0) {
+        sim.execNextEvent();
+    }
+    assert(batch->sent[0] == 9);
+    assert(batch->sent[1] == 5);
+    assert(batch->sent[2] == 4);
+}
+
+// Calculating the output does not change the batch
+void test3() {
+    pin_t output;
+    auto batch = std::make_shared<Batch>(2, output);
+    Simulator sim(batch);
+    assert(sim.nextEventTime() == 1.0);
+    sim.computeNextOutput();
+    sim.computeNextOutput();
+    assert(batch->get_time() == 0.0);
+    assert(batch->next_event(0) == 1.0);
+    assert(batch->next_event(1) == period(1));
+    sim.computeNextState();
+    assert(batch->get_time() == 1.0);
+    assert(batch->sent[0] == 1);
+    assert(batch->sent[1] == 0);
+    assert(sim.nextEventTime() == period(1));
+}
+
+int main() {
+    test1();
+    test2();
+    test3();
+    return 0;
+}
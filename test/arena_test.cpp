@@ -0,0 +1,144 @@
+/**
+ * Test cases for the model_arena and the allocators in arena.h.
+ */
+#include <cassert>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <set>
+#include "adevs/adevs.h"
+
+using PinValue = adevs::PinValue<int>;
+using pin_t = adevs::pin_t;
+using Simulator = adevs::Simulator<int>;
+using Atomic = adevs::Atomic<int>;
+using Graph = adevs::Graph<int>;
+
+// A model that passes a token to the next model in a ring
+class Relay : public Atomic {
+  public:
+    static int alive;
+    Relay(bool token) : Atomic(), token(token), count(0) { alive++; }
+    ~Relay() { alive--; }
+    double ta() { return (token) ? 1.0 : adevs_inf<double>(); }
+    void delta_int() { token = false; }
+    void delta_ext(double, std::list<PinValue> const &) {
+        token = true;
+        count++;
+    }
+    void delta_conf(std::list<PinValue> const &) {}
+    void output_func(std::list<PinValue> &yb) { yb.push_back(PinValue(output, 1)); }
+    pin_t const output;
+    bool token;
+    int count;
+};
+
+int Relay::alive = 0;
+
+// Models made by the arena are next to each other and are
+// destroyed with the graph
+void test1() {
+    int const N = 1000;
+    std::list<std::shared_ptr<Relay>> relays;
+    auto graph = std::make_shared<Graph>();
+    {
+        adevs::model_arena arena(1 << 16);
+        for (int i = 0; i < N; i++) {
+            relays.push_back(arena.make<Relay>(i == 0));
+            graph->add_atomic(relays.back());
+        }
+        assert(arena.bytes_used() >= N * sizeof(Relay));
+        assert(arena.block_count() < N / 10);
+        // Consecutive models are next to each other except where a new block starts
+        size_t adjacent = 0;
+        for (auto prev = relays.begin(), iter = std::next(prev); iter != relays.end();
+             prev = iter++) {
+            intptr_t d = reinterpret_cast<intptr_t>(iter->get()) -
+                         reinterpret_cast<intptr_t>(prev->get());
+            adjacent += (d > 0 && d < intptr_t(2 * sizeof(Relay)));
+        }
+        assert(adjacent + arena.block_count() >= size_t(N));
+    }
+    // The arena is gone but the models are still usable
+    for (auto iter = relays.begin(); iter != relays.end(); iter++) {
+        auto next = std::next(iter);
+        graph->connect((*iter)->output, (next == relays.end()) ? relays.front() : *next);
+    }
+    {
+        Simulator sim(graph);
+        sim.run_until(2.0 * N);
+        for (auto r : relays) {
+            assert(r->count == 2);
+        }
+    }
+    assert(Relay::alive == N);
+    relays.clear();
+    graph.reset();
+    assert(Relay::alive == 0);
+}
+
+// The recycling allocator hands back nodes that were freed
+void test2() {
+    std::list<int, adevs::recycling_allocator<int>> l;
+    l.push_back(1);
+    int* first = &l.front();
+    l.pop_back();
+    l.push_back(2);
+    assert(&l.front() == first);
+    std::set<int, std::less<int>, adevs::recycling_allocator<int>> s;
+    for (int i = 0; i < 100; i++) {
+        s.insert(i);
+    }
+    s.clear();
+    for (int i = 0; i < 100; i++) {
+        s.insert(i);
+    }
+    assert(s.size() == 100);
+}
+
+// An arena allocator can be used by containers
+void test3() {
+    adevs::model_arena arena;
+    std::vector<double, adevs::arena_allocator<double>> v(arena.get_allocator<double>());
+    for (int i = 0; i < 1000; i++) {
+        v.push_back(i);
+    }
+    assert(v[999] == 999.0);
+    assert(arena.bytes_used() >= 1000 * sizeof(double));
+}
+
+// A static object that uses the recycling allocator when it is destroyed,
+// which is after the thread_local node cache of the main thread is gone
+struct late_user {
+    std::list<int, adevs::recycling_allocator<int>>* l;
+    late_user() : l(nullptr) {}
+    ~late_user() {
+        l->clear();
+        for (int i = 0; i < 10; i++) {
+            l->push_back(i);
+        }
+        assert(l->size() == 10 && l->back() == 9);
+        delete l;
+    }
+};
+
+late_user late;
+
+// Containers keep working after the node cache is destroyed
+void test4() {
+    late.l = new std::list<int, adevs::recycling_allocator<int>>();
+    // Fill the cache so that it has nodes when it is destroyed
+    for (int i = 0; i < 10; i++) {
+        late.l->push_back(i);
+    }
+    std::list<int, adevs::recycling_allocator<int>> tmp(late.l->begin(), late.l->end());
+    tmp.clear();
+}
+
+int main() {
+    test1();
+    test2();
+    test3();
+    test4();
+    return 0;
+}
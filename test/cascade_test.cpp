@@ -0,0 +1,166 @@
+/**
+ * Test cases for zero time cascades.
+ */
+#include <cassert>
+#include <vector>
+#include "adevs/adevs.h"
+
+using pin_t = adevs::pin_t;
+using PinValue = adevs::PinValue<int>;
+using Atomic = adevs::Atomic<int>;
+
+// Fires every second and then starts a cascade of the given depth
+class Burst : public Atomic {
+  public:
+    Burst(int depth) : Atomic(), depth(depth), left(0), fired(0) {}
+    double ta() { return (left > 0) ? 0.0 : 1.0; }
+    void delta_int() {
+        fired++;
+        left = (left > 0) ? left - 1 : depth;
+    }
+    void delta_ext(double, std::list<PinValue> const &) {}
+    void delta_conf(std::list<PinValue> const &) {}
+    void output_func(std::list<PinValue> &yb) { yb.push_back(PinValue(output, left)); }
+    pin_t const output;
+    int const depth;
+    int left, fired;
+};
+
+// Passes each input on with no delay
+class Relay : public Atomic {
+  public:
+    Relay() : Atomic(), received(0) {}
+    double ta() { return (pending.empty()) ? adevs_inf<double>() : 0.0; }
+    void delta_int() { pending.clear(); }
+    void delta_ext(double, std::list<PinValue> const &xb) {
+        for (auto const &x : xb) {
+            pending.push_back(x.value);
+            received++;
+        }
+    }
+    void delta_conf(std::list<PinValue> const &xb) {
+        delta_int();
+        delta_ext(0.0, xb);
+    }
+    void output_func(std::list<PinValue> &yb) {
+        for (int v : pending) {
+            yb.push_back(PinValue(output, v));
+        }
+    }
+    pin_t const output;
+    std::vector<int> pending;
+    int received;
+};
+
+// Records the time of each input
+class Log : public Atomic {
+  public:
+    Log() : Atomic() {}
+    double ta() { return adevs_inf<double>(); }
+    void delta_int() {}
+    void delta_ext(double e, std::list<PinValue> const &xb) {
+        t += e;
+        for (auto const &x : xb) {
+            times.push_back(t);
+            values.push_back(x.value);
+        }
+    }
+    void delta_conf(std::list<PinValue> const &) {}
+    void output_func(std::list<PinValue> &) {}
+    double t = 0.0;
+    std::vector<double> times;
+    std::vector<int> values;
+};
+
+// Cascades are counted and their outputs are delivered in order
+void test1() {
+    auto graph = std::make_shared<adevs::Graph<int>>();
+    auto burst = std::make_shared<Burst>(4);
+    auto relay = std::make_shared<Relay>();
+    auto log = std::make_shared<Log>();
+    graph->add_atomic(burst);
+    graph->add_atomic(relay);
+    graph->add_atomic(log);
+    graph->connect(burst->output, relay);
+    graph->connect(relay->output, log);
+    adevs::Simulator<int> sim(graph);
+    sim.run_until(3.0);
+    // Each second starts one cascade. The burst fires five times and
+    // the relay fires once more after the last burst.
+    assert(burst->fired == 15);
+    assert(log->values.size() == 15);
+    for (int i = 0; i < 15; i++) {
+        assert(log->times[i] == double(1 + i / 5));
+        assert(log->values[i] == ((i % 5 == 0) ? 0 : 5 - i % 5));
+    }
+    assert(sim.zero_time_cascades() == 3);
+    assert(sim.max_cascade_depth() == 5);
+    assert(sim.cascade_cycles() == 15);
+}
+
+// A model that never advances time is caught by the limit
+class Spin : public Atomic {
+  public:
+    Spin() : Atomic(), count(0) {}
+    double ta() { return 0.0; }
+    void delta_int() { count++; }
+    void delta_ext(double, std::list<PinValue> const &) {}
+    void delta_conf(std::list<PinValue> const &) {}
+    void output_func(std::list<PinValue> &) {}
+    int count;
+};
+
+void test2() {
+    auto spin = std::make_shared<Spin>();
+    adevs::Simulator<int> sim(spin);
+    sim.set_cascade_limit(100);
+    bool caught = false;
+    try {
+        sim.run_events(1000);
+    } catch (adevs::exception &err) {
+        caught = true;
+        assert(err.who() == spin.get());
+    }
+    assert(caught);
+    assert(spin->count == 101);
+    assert(sim.nextEventTime() == 0.0);
+}
+
+// Removing a model in a cascade takes it out of the cascade
+class Remover : public Atomic {
+  public:
+    Remover(adevs::Graph<int>* graph, std::shared_ptr<Atomic> victim)
+        : Atomic(), graph(graph), victim(victim) {}
+    double ta() { return (victim) ? 0.0 : adevs_inf<double>(); }
+    void delta_int() {
+        graph->remove_atomic(victim);
+        victim = nullptr;
+    }
+    void delta_ext(double, std::list<PinValue> const &) {}
+    void delta_conf(std::list<PinValue> const &) {}
+    void output_func(std::list<PinValue> &) {}
+    // The Graph owns this model and so is not owned by it
+    adevs::Graph<int>* graph;
+    std::shared_ptr<Atomic> victim;
+};
+
+void test3() {
+    auto graph = std::make_shared<adevs::Graph<int>>();
+    auto spin = std::make_shared<Spin>();
+    graph->add_atomic(spin);
+    graph->add_atomic(std::make_shared<Remover>(graph.get(), spin));
+    adevs::Simulator<int> sim(graph);
+    sim.execNextEvent();
+    assert(spin->count == 1);
+    assert(sim.nextEventTime() == adevs_inf<double>());
+    // The removal ended the cascade before it could continue
+    assert(sim.cascade_cycles() == 1);
+    assert(sim.max_cascade_depth() == 0);
+}
+
+int main() {
+    test1();
+    test2();
+    test3();
+    return 0;
+}
@@ -0,0 +1,366 @@
+/**
+ * Test cases for the CellSpace.
+ */
+#include <cassert>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+#include "adevs/adevs.h"
+
+using PinValue = adevs::PinValue<int>;
+using pin_t = adevs::pin_t;
+using Simulator = adevs::Simulator<int, int>;
+using Atomic = adevs::Atomic<int, int>;
+using Graph = adevs::Graph<int, int>;
+
+// State of a cell in the game of life
+struct Life {
+    bool alive;
+    int nalive;
+};
+
+// The game of life where a cell changes state one unit of time
+// after its birth or death rule is satisfied
+class LifeSpace : public adevs::CellSpace<Life, int, int> {
+  public:
+    LifeSpace(unsigned int w, unsigned int h)
+        : adevs::CellSpace<Life, int, int>(w, h, moore_neighborhood(), true) {}
+    int cell_ta(unsigned int, unsigned int, Life const &s) {
+        bool change = (s.alive && (s.nalive < 2 || s.nalive > 3)) || (!s.alive && s.nalive == 3);
+        return (change) ? 1 : adevs_inf<int>();
+    }
+    bool cell_output(unsigned int, unsigned int, Life const &s, Life &msg) {
+        msg.alive = !s.alive;
+        return true;
+    }
+    void cell_delta(CellEvent const &event, Life &s) {
+        if (event.imminent) {
+            s.alive = !s.alive;
+        }
+        for (unsigned int k = 0; k < 8; k++) {
+            if (event.received(k)) {
+                s.nalive += (event.message(k).alive) ? 1 : -1;
+            }
+        }
+        assert(s.nalive >= 0 && s.nalive <= 8);
+    }
+};
+
+// One synchronous step of the game of life on a torus
+std::vector<bool> life_step(std::vector<bool> const &b, int w, int h) {
+    std::vector<bool> next(b.size());
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            int n = 0;
+            for (int dy = -1; dy <= 1; dy++) {
+                for (int dx = -1; dx <= 1; dx++) {
+                    if (dx != 0 || dy != 0) {
+                        n += b[((y + dy + h) % h) * w + (x + dx + w) % w];
+                    }
+                }
+            }
+            bool alive = b[y * w + x];
+            next[y * w + x] = (alive && (n == 2 || n == 3)) || (!alive && n == 3);
+        }
+    }
+    return next;
+}
+
+// The cell space matches a direct calculation of the game of life
+void test1(unsigned int threads = 1, unsigned int tile_size = 64) {
+    int const w = 40, h = 30;
+    std::vector<bool> board(w * h);
+    srand(1);
+    for (auto &&b : board) {
+        b = (rand() % 4 == 0);
+    }
+    auto space = std::make_shared<LifeSpace>(w, h);
+    space->set_threads(threads, tile_size);
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            Life s;
+            s.alive = board[y * w + x];
+            s.nalive = 0;
+            for (int dy = -1; dy <= 1; dy++) {
+                for (int dx = -1; dx <= 1; dx++) {
+                    if (dx != 0 || dy != 0) {
+                        s.nalive += board[((y + dy + h) % h) * w + (x + dx + w) % w];
+                    }
+                }
+            }
+            space->set_state(x, y, s);
+        }
+    }
+    Simulator sim(space);
+    for (int t = 1; t <= 50 && sim.nextEventTime() < adevs_inf<int>(); t++) {
+        assert(sim.nextEventTime() == t);
+        sim.execNextEvent();
+        board = life_step(board, w, h);
+        for (int y = 0; y < h; y++) {
+            for (int x = 0; x < w; x++) {
+                assert(space->get_state(x, y).alive == board[y * w + x]);
+            }
+        }
+    }
+}
+
+// A signal that moves from left to right one cell per delay
+class WaveSpace : public adevs::CellSpace<int, int, int> {
+  public:
+    WaveSpace(unsigned int w, int delay)
+        : adevs::CellSpace<int, int, int>(w, 1, {{-1, 0}}), delay(delay) {}
+    int cell_ta(unsigned int, unsigned int, int const &s) {
+        return (s > 0) ? delay : adevs_inf<int>();
+    }
+    bool cell_output(unsigned int, unsigned int, int const &s, int &msg) {
+        msg = s;
+        return true;
+    }
+    void cell_delta(CellEvent const &event, int &s) {
+        if (event.imminent) {
+            s = 0;
+        }
+        if (event.received(0)) {
+            s = event.message(0) + 1;
+        }
+        for (auto v : event.input()) {
+            s = v;
+        }
+    }
+
+  private:
+    int const delay;
+};
+
+class Source : public Atomic {
+  public:
+    Source(int t) : Atomic(), t(t) {}
+    int ta() { return t; }
+    void delta_int() { t = adevs_inf<int>(); }
+    void delta_ext(int, std::list<PinValue> const &) {}
+    void delta_conf(std::list<PinValue> const &) {}
+    void output_func(std::list<PinValue> &yb) { yb.push_back(PinValue(output, 1)); }
+    pin_t const output;
+
+  private:
+    int t;
+};
+
+class Sink : public Atomic {
+  public:
+    Sink() : Atomic(), t(0), arrival(-1), value(-1) {}
+    int ta() { return adevs_inf<int>(); }
+    void delta_int() {}
+    void delta_ext(int e, std::list<PinValue> const &xb) {
+        t += e;
+        arrival = t;
+        value = xb.front().value;
+    }
+    void delta_conf(std::list<PinValue> const &xb) { delta_ext(0, xb); }
+    void output_func(std::list<PinValue> &) {}
+    int t, arrival, value;
+};
+
+// The cell space exchanges values with other models in a graph
+void test2(unsigned int threads = 1, unsigned int tile_size = 64) {
+    unsigned int const w = 1000;
+    int const delay = 3000;
+    auto graph = std::make_shared<Graph>();
+    auto space = std::make_shared<WaveSpace>(w, delay);
+    auto src = std::make_shared<Source>(5);
+    auto sink = std::make_shared<Sink>();
+    space->set_threads(threads, tile_size);
+    graph->add_atomic(space);
+    graph->add_atomic(src);
+    graph->add_atomic(sink);
+    graph->connect(src->output, space->input_pin(0, 0));
+    graph->connect(space->input_pin(0, 0), space);
+    graph->connect(space->output_pin(w - 1, 0), sink);
+    Simulator sim(graph);
+    int events = 0;
+    while (sim.nextEventTime() < adevs_inf<int>()) {
+        sim.execNextEvent();
+        events++;
+    }
+    assert(events == int(w) + 1);
+    assert(sink->arrival == 5 + int(w) * delay);
+    assert(sink->value == int(w));
+    assert(space->get_time() == sink->arrival);
+}
+
+// Tiles processed by several threads give the same result as one thread
+void test3() {
+    int const w = 64, h = 48;
+    auto serial = std::make_shared<LifeSpace>(w, h);
+    auto parallel = std::make_shared<LifeSpace>(w, h);
+    parallel->set_threads(4, 5);
+    srand(2);
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            Life s;
+            s.alive = (rand() % 3 == 0);
+            s.nalive = 0;
+            serial->set_state(x, y, s);
+            parallel->set_state(x, y, s);
+        }
+    }
+    // Count the living neighbors
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            Life s = serial->get_state(x, y);
+            for (auto d : serial->get_stencil()) {
+                s.nalive += serial->get_state((x + d.first + w) % w, (y + d.second + h) % h).alive;
+            }
+            serial->set_state(x, y, s);
+            parallel->set_state(x, y, s);
+        }
+    }
+    Simulator sim1(serial), sim2(parallel);
+    while (sim1.nextEventTime() < 200) {
+        assert(sim1.nextEventTime() == sim2.nextEventTime());
+        sim1.execNextEvent();
+        sim2.execNextEvent();
+        for (int y = 0; y < h; y++) {
+            for (int x = 0; x < w; x++) {
+                assert(serial->get_state(x, y).alive == parallel->get_state(x, y).alive);
+                assert(serial->get_state(x, y).nalive == parallel->get_state(x, y).nalive);
+            }
+        }
+    }
+    // Threads cannot be changed after the simulation starts
+    bool except = false;
+    try {
+        parallel->set_threads(2);
+    } catch (adevs::exception const &) {
+        except = true;
+    }
+    assert(except);
+}
+
+// State of a cell that keeps its time of next event when it gets input
+struct Timer {
+    int sigma;
+    int fired;
+};
+
+// Cell 1 fires at t = 3 and sends a message to cell 0, which
+// fires at t = 10 as it was scheduled to
+class TimerSpace : public adevs::CellSpace<Timer, int, int> {
+  public:
+    TimerSpace() : adevs::CellSpace<Timer, int, int>(2, 1, {{-1, 0}, {1, 0}}), outputs(2, 0) {}
+    int cell_ta(unsigned int, unsigned int, Timer const &s) { return s.sigma; }
+    bool cell_output(unsigned int x, unsigned int, Timer const &, Timer &msg) {
+        outputs[x]++;
+        msg.sigma = 0;
+        return true;
+    }
+    void cell_delta(CellEvent const &event, Timer &s) {
+        if (event.imminent) {
+            s.fired++;
+            s.sigma = adevs_inf<int>();
+        } else if (s.sigma < adevs_inf<int>()) {
+            s.sigma -= event.elapsed;
+        }
+    }
+    std::vector<int> outputs;
+};
+
+// A cell is imminent once even if it receives input before that
+void test4(unsigned int threads = 1) {
+    auto space = std::make_shared<TimerSpace>();
+    space->set_threads(threads, 1);
+    space->set_state(0, 0, Timer{10, 0});
+    space->set_state(1, 0, Timer{3, 0});
+    Simulator sim(space);
+    while (sim.nextEventTime() < adevs_inf<int>()) {
+        sim.execNextEvent();
+    }
+    assert(space->get_state(0, 0).fired == 1);
+    assert(space->get_state(1, 0).fired == 1);
+    assert(space->outputs[0] == 1);
+    assert(space->outputs[1] == 1);
+    assert(space->get_time() == 10);
+}
+
+// State of a cell that passes a message to its right one unit of time after getting it
+struct Relay {
+    int sigma = adevs_inf<int>();
+    int got = 0;
+};
+
+// Cell 0 starts the relay at t = 1 and the last cell puts its message on a pin
+class RelaySpace : public adevs::CellSpace<Relay, int, int> {
+  public:
+    RelaySpace(unsigned int width) : adevs::CellSpace<Relay, int, int>(width, 1, {{-1, 0}}) {}
+    int cell_ta(unsigned int, unsigned int, Relay const &s) { return s.sigma; }
+    bool cell_output(unsigned int x, unsigned int, Relay const &, Relay &msg) {
+        msg.sigma = x;
+        return true;
+    }
+    void cell_delta(CellEvent const &event, Relay &s) {
+        s.sigma = adevs_inf<int>();
+        if (event.received(0)) {
+            s.got++;
+            s.sigma = 1;
+        }
+    }
+    void boundary_output(unsigned int, unsigned int, Relay const &msg, pin_t pin,
+                         std::list<PinValue> &yb) {
+        yb.push_back(PinValue(pin, msg.sigma));
+    }
+};
+
+// Records the values of the output events
+class Recorder : public adevs::EventListener<int, int> {
+  public:
+    void outputEvent(Atomic &, PinValue &y, int) { values.push_back(y.value); }
+    void inputEvent(Atomic &, PinValue &, int) {}
+    void stateChange(Atomic &, int) {}
+    std::vector<int> values;
+};
+
+// Calculating the output more than once does not change the space
+void test5(unsigned int threads = 1) {
+    unsigned int const N = 4;
+    auto space = std::make_shared<RelaySpace>(N);
+    space->set_threads(threads, 1);
+    space->set_state(0, 0, Relay{1, 0});
+    space->output_pin(N - 1, 0);
+    auto recorder = std::make_shared<Recorder>();
+    Simulator sim(space);
+    sim.addEventListener(recorder);
+    for (int t = 1; t <= int(N); t++) {
+        assert(sim.nextEventTime() == t);
+        sim.computeNextOutput();
+        std::vector<int> first;
+        first.swap(recorder->values);
+        sim.computeNextOutput();
+        assert(recorder->values == first);
+        recorder->values.clear();
+        // Only the last cell has output for its pin
+        assert(first == ((t == int(N)) ? std::vector<int>(1, N - 1) : std::vector<int>()));
+        // Nothing was delivered to the cells
+        assert(space->get_time() == t - 1);
+        for (unsigned int x = 0; x < N; x++) {
+            assert(space->get_state(x, 0).got == int(x > 0 && x < unsigned(t)));
+        }
+        sim.computeNextState();
+    }
+    assert(sim.nextEventTime() == adevs_inf<int>());
+    for (unsigned int x = 1; x < N; x++) {
+        assert(space->get_state(x, 0).got == 1);
+    }
+}
+
+int main() {
+    test1();
+    test2();
+    test1(3, 7);
+    test2(2, 16);
+    test3();
+    test4();
+    test4(2);
+    test5();
+    test5(2);
+    return 0;
+}
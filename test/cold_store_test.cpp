@@ -0,0 +1,158 @@
+/**
+ * Test cases for moving dormant models into a ColdStore.
+ */
+#include <cassert>
+#include <cstring>
+#include <vector>
+#include "adevs/adevs.h"
+
+using pin_t = adevs::pin_t;
+using PinValue = adevs::PinValue<int>;
+using Atomic = adevs::Atomic<int>;
+
+// Sleeps until it gets input, reports the elapsed time, and sleeps again
+class Sleeper : public Atomic {
+  public:
+    Sleeper(int id, pin_t output) : Atomic(), id(id), output(output), wakes(0), report(-1.0) {
+        alive++;
+    }
+    ~Sleeper() { alive--; }
+    double ta() { return (report < 0.0) ? adevs_inf<double>() : 0.5; }
+    void delta_int() { report = -1.0; }
+    void delta_ext(double e, std::list<PinValue> const &xb) {
+        wakes += int(xb.size());
+        report = e;
+    }
+    void delta_conf(std::list<PinValue> const &) { assert(false); }
+    void output_func(std::list<PinValue> &yb) { yb.push_back(PinValue(output, id * 1000 + wakes)); }
+    int const id;
+    pin_t const output;
+    int wakes;
+    double report;
+    static int alive;
+};
+
+int Sleeper::alive = 0;
+
+// Sends to sleeper k % N at time k
+class Alarm : public Atomic {
+  public:
+    Alarm(std::vector<pin_t> const &pins) : Atomic(), pins(pins), k(0) {}
+    double ta() { return (k < 2 * int(pins.size())) ? 1.0 : adevs_inf<double>(); }
+    void delta_int() { k++; }
+    void delta_ext(double, std::list<PinValue> const &) {}
+    void delta_conf(std::list<PinValue> const &) {}
+    void output_func(std::list<PinValue> &yb) { yb.push_back(PinValue(pins[k % pins.size()], k)); }
+    std::vector<pin_t> const pins;
+    int k;
+};
+
+class Sink : public Atomic {
+  public:
+    Sink() : Atomic() {}
+    double ta() { return adevs_inf<double>(); }
+    void delta_int() {}
+    void delta_ext(double, std::list<PinValue> const &xb) {
+        for (auto const &x : xb) {
+            values.push_back(x.value);
+        }
+    }
+    void delta_conf(std::list<PinValue> const &) {}
+    void output_func(std::list<PinValue> &) {}
+    std::vector<int> values;
+};
+
+void test1() {
+    int const N = 200;
+    auto graph = std::make_shared<adevs::Graph<int>>();
+    std::vector<pin_t> inputs(N);
+    pin_t output;
+    auto sink = std::make_shared<Sink>();
+    graph->add_atomic(sink);
+    graph->connect(output, sink);
+    for (int i = 0; i < N; i++) {
+        auto sleeper = std::make_shared<Sleeper>(i, output);
+        graph->add_atomic(sleeper);
+        graph->connect(inputs[i], sleeper);
+    }
+    graph->add_atomic(std::make_shared<Alarm>(inputs));
+    // Save the number of wakes and the time of the report
+    auto store = std::make_shared<adevs::ColdStore<int>>(
+        [](Atomic &model, std::vector<char> &state) {
+            Sleeper* sleeper = dynamic_cast<Sleeper*>(&model);
+            if (sleeper == nullptr) {
+                return false;
+            }
+            int data[2] = {sleeper->id, sleeper->wakes};
+            state.resize(sizeof(data));
+            memcpy(state.data(), data, sizeof(data));
+            return true;
+        },
+        [&](char const* state, size_t size) {
+            int data[2];
+            assert(size == sizeof(data));
+            memcpy(data, state, sizeof(data));
+            auto sleeper = std::make_shared<Sleeper>(data[0], output);
+            sleeper->wakes = data[1];
+            return sleeper;
+        });
+    adevs::Simulator<int> sim(graph);
+    sim.set_cold_store(store);
+    // The sink is dormant too but it is not accepted by the store
+    assert(sim.compact() == size_t(N));
+    assert(store->size() == size_t(N));
+    assert(Sleeper::alive == 0);
+    assert(graph->get_atomics().size() == 2);
+    while (sim.nextEventTime() < adevs_inf<double>()) {
+        sim.execNextEvent();
+        sim.compact();
+        // Only the sleeper that is reporting is awake
+        assert(Sleeper::alive <= 1);
+    }
+    assert(store->size() == size_t(N));
+    assert(store->woken() == size_t(2 * N));
+    // Every sleeper reported twice with the right count
+    assert(sink->values.size() == size_t(2 * N));
+    for (int k = 0; k < 2 * N; k++) {
+        assert(sink->values[k] == (k % N) * 1000 + k / N + 1);
+    }
+    // The space of woken models is reused
+    assert(store->bytes() <= 2 * N * 2 * sizeof(int));
+}
+
+// The elapsed time of a restored model is measured from its last event
+void test2() {
+    pin_t input, output;
+    auto graph = std::make_shared<adevs::Graph<int>>();
+    graph->add_atomic(std::make_shared<Sleeper>(0, output));
+    graph->connect(input, *graph->get_atomics().begin());
+    std::vector<std::shared_ptr<Sleeper>> restored;
+    auto store = std::make_shared<adevs::ColdStore<int>>(
+        [](Atomic &, std::vector<char> &) { return true; },
+        [&](char const*, size_t size) {
+            assert(size == 0);
+            restored.push_back(std::make_shared<Sleeper>(0, output));
+            return restored.back();
+        });
+    adevs::Simulator<int> sim(graph);
+    sim.set_cold_store(store);
+    sim.setNextTime(2.0);
+    sim.injectInput(PinValue(input, 1));
+    sim.execNextEvent();
+    sim.execNextEvent();
+    assert(sim.nextEventTime() == adevs_inf<double>());
+    assert(sim.compact() == 1);
+    sim.setNextTime(7.0);
+    sim.injectInput(PinValue(input, 1));
+    sim.execNextEvent();
+    assert(restored.size() == 1);
+    assert(restored[0]->report == 4.5);
+    assert(store->size() == 0);
+    assert(graph->get_atomics().size() == 1);
+}
+
+int main() {
+    test1();
+    test2();
+    return 0;
+}
@@ -0,0 +1,126 @@
+/**
+ * Test cases for the fixed_time type.
+ */
+#include <cassert>
+#include <sstream>
+#include "adevs/adevs.h"
+
+using pin_t = adevs::pin_t;
+using ns_time = adevs::fixed_time<std::nano>;
+using us_time = adevs::fixed_time<std::micro>;
+
+// Arithmetic is exact and saturates at infinity
+void test1() {
+    assert(ns_time(0.1) + ns_time(0.2) == ns_time(0.3));
+    assert(ns_time(3).get_ticks() == 3000000000);
+    assert(us_time(3).get_ticks() == 3000000);
+    assert(ns_time(1.5e-9).get_ticks() == 2);
+    assert(ns_time(2.5) - ns_time(1) == ns_time(1.5));
+    assert(static_cast<double>(ns_time(0.25)) == 0.25);
+    assert(ns_time(1) < ns_time(2) && ns_time(2) > ns_time(1));
+    assert(ns_time(1) <= ns_time(1) && ns_time(1) >= ns_time(1));
+    assert(ns_time(1) != ns_time(1.000000001));
+    ns_time inf = adevs_inf<ns_time>();
+    assert(inf + ns_time(1) == inf);
+    assert(inf - ns_time(1) == inf);
+    assert(ns_time(5e9) + ns_time(5e9) == inf);
+    assert(ns_time(adevs_inf<double>()) == inf);
+    assert(ns_time(1e300) == inf);
+    assert(static_cast<double>(inf) == adevs_inf<double>());
+    assert(adevs_sentinel<ns_time>() < adevs_zero<ns_time>());
+    assert(adevs_zero<ns_time>() + adevs_epsilon<ns_time>() == adevs_zero<ns_time>());
+    std::stringstream ss;
+    ss << ns_time(0.5);
+    ns_time t;
+    ss >> t;
+    assert(t == ns_time(0.5));
+}
+
+// Periodic models with fractional periods meet at exactly the same time
+template <typename TimeType>
+class Clock : public adevs::Atomic<int, TimeType> {
+  public:
+    Clock(double period) : adevs::Atomic<int, TimeType>(), period(period), count(0) {}
+    TimeType ta() { return TimeType(period); }
+    void delta_int() { count++; }
+    void delta_ext(TimeType, std::list<adevs::PinValue<int>> const &) {}
+    void delta_conf(std::list<adevs::PinValue<int>> const &) {}
+    void output_func(std::list<adevs::PinValue<int>> &) {}
+    double const period;
+    int count;
+};
+
+void test2() {
+    auto graph = std::make_shared<adevs::Graph<int, ns_time>>();
+    auto fast = std::make_shared<Clock<ns_time>>(0.1);
+    auto slow = std::make_shared<Clock<ns_time>>(0.3);
+    graph->add_atomic(fast);
+    graph->add_atomic(slow);
+    adevs::Simulator<int, ns_time> sim(graph);
+    int steps = 0;
+    while (sim.nextEventTime() <= ns_time(30)) {
+        sim.execNextEvent();
+        steps++;
+    }
+    assert(fast->count == 300);
+    assert(slow->count == 100);
+    assert(steps == 300);
+}
+
+// A Hybrid model and a generator with the same period always act together
+static double const period = 0.001;
+
+class Genr : public adevs::Atomic<int, ns_time> {
+  public:
+    Genr() : adevs::Atomic<int, ns_time>() {}
+    ns_time ta() { return period; }
+    void delta_int() {}
+    void delta_ext(ns_time, std::list<adevs::PinValue<int>> const &) {}
+    void delta_conf(std::list<adevs::PinValue<int>> const &) {}
+    void output_func(std::list<adevs::PinValue<int>> &yb) {
+        yb.push_back(adevs::PinValue<int>(output, 1));
+    }
+    pin_t const output;
+};
+
+class Countdown : public adevs::ode_system<int> {
+  public:
+    Countdown() : adevs::ode_system<int>(1, 0), confluent(0) {}
+    void init(double* q) { q[0] = period; }
+    void der_func(double const*, double* dq) { dq[0] = -1.0; }
+    void state_event_func(double const*, double*) {}
+    double time_event_func(double const* q) { return q[0]; }
+    void internal_event(double*, bool const*) { assert(false); }
+    void external_event(double*, double, std::list<adevs::PinValue<int>> const &) {
+        assert(false);
+    }
+    void confluent_event(double* q, bool const*, std::list<adevs::PinValue<int>> const &xb) {
+        assert(xb.size() == 1);
+        q[0] = period;
+        confluent++;
+    }
+    void output_func(double const*, bool const*, std::list<adevs::PinValue<int>> &) {}
+    int confluent;
+};
+
+void test3() {
+    auto sys = new Countdown();
+    auto hybrid = std::make_shared<adevs::Hybrid<int, ns_time>>(
+        sys, new adevs::corrected_euler<int>(sys, 1E-6, 0.01),
+        new adevs::linear_event_locator<int>(sys, 1E-7));
+    auto genr = std::make_shared<Genr>();
+    auto graph = std::make_shared<adevs::Graph<int, ns_time>>();
+    graph->add_atomic(hybrid);
+    graph->add_atomic(genr);
+    graph->connect(genr->output, hybrid);
+    adevs::Simulator<int, ns_time> sim(graph);
+    sim.run_until(ns_time(1));
+    assert(sys->confluent == 1000);
+}
+
+int main() {
+    test1();
+    test2();
+    test3();
+    return 0;
+}
@@ -0,0 +1,122 @@
+/**
+ * Test cases for merging nearly simultaneous events with a time granule.
+ */
+#include <cassert>
+#include <vector>
+#include "adevs/adevs.h"
+
+using pin_t = adevs::pin_t;
+using PinValue = adevs::PinValue<int>;
+using Atomic = adevs::Atomic<int>;
+
+// Reports once at its offset and then once each period
+class Sensor : public Atomic {
+  public:
+    Sensor(double offset, double period)
+        : Atomic(), offset(offset), period(period), reports(0) {}
+    double ta() { return (reports == 0) ? offset : period; }
+    void delta_int() { reports++; }
+    void delta_ext(double, std::list<PinValue> const &) {}
+    void delta_conf(std::list<PinValue> const &) { assert(false); }
+    void output_func(std::list<PinValue> &yb) { yb.push_back(PinValue(output, reports)); }
+    pin_t const output;
+    double const offset, period;
+    int reports;
+};
+
+// Counts the reports it receives
+class Sink : public Atomic {
+  public:
+    Sink() : Atomic(), received(0), batches(0) {}
+    double ta() { return adevs_inf<double>(); }
+    void delta_int() {}
+    void delta_ext(double, std::list<PinValue> const &xb) {
+        received += xb.size();
+        batches++;
+    }
+    void delta_conf(std::list<PinValue> const &) {}
+    void output_func(std::list<PinValue> &) {}
+    size_t received, batches;
+};
+
+struct Result {
+    size_t cycles, received, batches, merged_events, merged_cycles;
+};
+
+Result run(double granule) {
+    int const N = 1000;
+    auto graph = std::make_shared<adevs::Graph<int>>();
+    auto sink = std::make_shared<Sink>();
+    graph->add_atomic(sink);
+    for (int i = 0; i < N; i++) {
+        // Reports are a microsecond apart within each second
+        auto sensor = std::make_shared<Sensor>(1.0 + i * 1E-6, 1.0);
+        graph->add_atomic(sensor);
+        graph->connect(sensor->output, sink);
+    }
+    adevs::Simulator<int> sim(graph);
+    sim.set_time_granule(granule);
+    Result r;
+    r.cycles = sim.run_until(10.5);
+    r.received = sink->received;
+    r.batches = sink->batches;
+    r.merged_events = sim.merged_events();
+    r.merged_cycles = sim.merged_cycles();
+    return r;
+}
+
+// Without a granule every report is its own cycle. With a granule
+// the first reports are handled together and after that the
+// sensors stay in step.
+void test1() {
+    Result exact = run(0.0);
+    assert(exact.cycles == 10000);
+    assert(exact.received == 10000 && exact.batches == 10000);
+    assert(exact.merged_events == 0 && exact.merged_cycles == 0);
+    Result merged = run(1E-2);
+    assert(merged.cycles == 10);
+    assert(merged.received == 10000 && merged.batches == 10);
+    assert(merged.merged_events == 999 && merged.merged_cycles == 1);
+}
+
+// A model with input inside of the granule has a confluent event
+class Echo : public Atomic {
+  public:
+    Echo() : Atomic(), internal(0), confluent(0), external(0) {}
+    double ta() { return 1.0005; }
+    void delta_int() { internal++; }
+    void delta_ext(double, std::list<PinValue> const &) { external++; }
+    void delta_conf(std::list<PinValue> const &) { confluent++; }
+    void output_func(std::list<PinValue> &) {}
+    int internal, confluent, external;
+};
+
+void test2() {
+    auto graph = std::make_shared<adevs::Graph<int>>();
+    auto sensor = std::make_shared<Sensor>(1.0, 1.0);
+    auto echo = std::make_shared<Echo>();
+    graph->add_atomic(sensor);
+    graph->add_atomic(echo);
+    graph->connect(sensor->output, echo);
+    adevs::Simulator<int> sim(graph);
+    sim.set_time_granule(1E-3);
+    assert(sim.get_time_granule() == 1E-3);
+    sim.execNextEvent();
+    assert(sim.nextEventTime() == 2.0);
+    assert(echo->confluent == 1 && echo->internal == 0 && echo->external == 0);
+    assert(sim.merged_events() == 1);
+    // Calculating output again does not lose the original event time
+    sim.setNextTime(1.5);
+    sim.computeNextOutput();
+    sim.setNextTime(2.0);
+    sim.execNextEvent();
+    assert(sensor->reports == 2);
+    assert(echo->confluent == 2);
+    assert(sim.merged_events() == 2);
+}
+
+int main() {
+    test1();
+    test2();
+    return 0;
+}
@@ -0,0 +1,117 @@
+/**
+ * Test cases for the GraphBuilder. A graph made by the builder is
+ * compared to one made with calls to Graph::connect().
+ */
+#include <cassert>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+#include "adevs/adevs.h"
+
+using PinValue = adevs::PinValue<int>;
+using pin_t = adevs::pin_t;
+using Atomic = adevs::Atomic<int, int>;
+using Graph = adevs::Graph<int, int>;
+using GraphBuilder = adevs::GraphBuilder<int, int>;
+
+class TestAtomic : public Atomic {
+  public:
+    TestAtomic() : Atomic() {}
+    void delta_int() {}
+    void delta_ext(int, std::list<PinValue> const &) {}
+    void delta_conf(std::list<PinValue> const &) {}
+    void output_func(std::list<PinValue> &) {}
+    int ta() { return adevs_inf<int>(); }
+};
+
+// The receivers of a pin in the order that they are routed to
+std::vector<std::pair<pin_t, Atomic*>> routes(Graph const &g, pin_t pin) {
+    std::list<std::pair<pin_t, std::shared_ptr<Atomic>>> models;
+    g.route(pin, models);
+    std::vector<std::pair<pin_t, Atomic*>> result;
+    for (auto const &m : models) {
+        result.push_back(std::make_pair(m.first, m.second.get()));
+    }
+    return result;
+}
+
+void compare(Graph const &a, Graph const &b, std::vector<pin_t> const &pins) {
+    assert(a.get_atomics() == b.get_atomics());
+    for (auto pin : pins) {
+        assert(routes(a, pin) == routes(b, pin));
+    }
+}
+
+// Random edges with duplicates give the same graph, with the receivers
+// of each pin in the same order, either way
+void test1(unsigned int threads, bool prefill) {
+    int const M = 200, P = 1000, E = 20000;
+    srand(3);
+    std::vector<std::shared_ptr<Atomic>> models;
+    std::vector<pin_t> pins(P);
+    for (int i = 0; i < M; i++) {
+        models.push_back(std::make_shared<TestAtomic>());
+    }
+    Graph g1, g2;
+    GraphBuilder builder;
+    if (prefill) {
+        // Some edges are already in the graph when it is built
+        for (int i = 0; i < 100; i++) {
+            g1.add_atomic(models[i]);
+            g2.add_atomic(models[i]);
+            g1.connect(pins[i], models[i]);
+            g2.connect(pins[i], models[i]);
+            g1.connect(pins[i], pins[i + 500]);
+            g2.connect(pins[i], pins[i + 500]);
+        }
+    }
+    builder.reserve(M, E, E);
+    for (int i = 0; i < M; i++) {
+        g1.add_atomic(models[i]);
+        builder.add_atomic(models[i]);
+    }
+    for (int i = 0; i < E; i++) {
+        // Pin edges go from the first half of the pins to the second
+        int src = rand() % (P / 2);
+        int dst = P / 2 + rand() % (P / 2);
+        g1.connect(pins[src], pins[dst]);
+        builder.connect(pins[src], pins[dst]);
+        int m = rand() % M;
+        g1.connect(pins[src], models[m]);
+        builder.connect(pins[src], models[m]);
+    }
+    builder.build(g2, threads);
+    compare(g1, g2, pins);
+    // The counts of instances match
+    for (int i = 0; i < 20; i++) {
+        g1.disconnect(pins[i], pins[i + 500]);
+        g2.disconnect(pins[i], pins[i + 500]);
+        g1.disconnect(pins[i], models[i]);
+        g2.disconnect(pins[i], models[i]);
+        g1.remove_atomic(models[i]);
+        g2.remove_atomic(models[i]);
+    }
+    compare(g1, g2, pins);
+}
+
+// A provisional graph queues the edges
+void test2() {
+    Graph g;
+    GraphBuilder builder;
+    auto a = std::make_shared<TestAtomic>();
+    pin_t pin;
+    builder.add_atomic(a);
+    builder.connect(pin, a);
+    g.set_provisional(true);
+    builder.build(g);
+    assert(g.get_atomics().empty());
+    assert(g.get_pending().size() == 2);
+}
+
+int main() {
+    test1(1, false);
+    test1(4, false);
+    test1(3, true);
+    test2();
+    return 0;
+}
@@ -19,7 +19,9 @@ using event_locator = adevs::event_locator<double>;
 using fast_event_locator = adevs::fast_event_locator<double>;
 using bisection_event_locator = adevs::bisection_event_locator<double>;
 using linear_event_locator = adevs::linear_event_locator<double>;
+using illinois_event_locator = adevs::illinois_event_locator<double>;
 using rk_45 = adevs::rk_45<double>;
+using dormand_prince = adevs::dormand_prince<double>;
 
 pin_t const ball_output;
 
@@ -140,5 +142,15 @@ int main() {
     run_test(ball, new corrected_euler(ball, 1E-6, 0.01), new bisection_event_locator(ball, 1E-7));
     ball = new bouncing_ball();
     run_test(ball, new rk_45(ball, 1E-6, 0.01), new bisection_event_locator(ball, 1E-7));
+    // Test Dormand-Prince
+    ball = new bouncing_ball();
+    run_test(ball, new dormand_prince(ball, 1E-6, 0.01), new linear_event_locator(ball, 1E-7));
+    ball = new bouncing_ball();
+    run_test(ball, new dormand_prince(ball, 1E-6, 0.01), new bisection_event_locator(ball, 1E-7));
+    // Test Illinois algorithm
+    ball = new bouncing_ball();
+    run_test(ball, new corrected_euler(ball, 1E-6, 0.01), new illinois_event_locator(ball, 1E-7));
+    ball = new bouncing_ball();
+    run_test(ball, new dormand_prince(ball, 1E-6, 0.01), new illinois_event_locator(ball, 1E-7));
     return 0;
 }
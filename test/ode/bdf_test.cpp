@@ -0,0 +1,257 @@
+/**
+ * Test cases for the BDF solver.
+ */
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include "adevs/adevs.h"
+#include "adevs/solvers/bdf.h"
+
+using Atomic = adevs::Atomic<double>;
+using Graph = adevs::Graph<double>;
+using PinValue = adevs::PinValue<double>;
+using Simulator = adevs::Simulator<double>;
+using ode_system = adevs::ode_system<double>;
+using bdf = adevs::bdf<double>;
+using pin_t = adevs::pin_t;
+
+/**
+ * The stiff system
+ *
+ * dx0/dt = 0.01 x1
+ * dx1/dt = -100 x0 - 100 x1 + 2020
+ *
+ * with eigenvalues near -0.01 and -100.
+ */
+class stiff : public ode_system {
+  public:
+    stiff(bool jacobian) : ode_system(2, 0), calls(0), jacobian(jacobian) {}
+    void init(double* q) {
+        q[0] = 0.0;
+        q[1] = 20.0;
+    }
+    void der_func(double const* q, double* dq) {
+        calls++;
+        dq[0] = 0.01 * q[1];
+        dq[1] = -100.0 * q[0] - 100.0 * q[1] + 2020.0;
+    }
+    bool get_jacobian(double const*, double* J) {
+        if (J != nullptr) {
+            J[0] = 0.0;
+            J[1] = -100.0;
+            J[2] = 0.01;
+            J[3] = -100.0;
+        }
+        return jacobian;
+    }
+    void state_event_func(double const*, double*) {}
+    double time_event_func(double const*) { return DBL_MAX; }
+    void internal_event(double*, bool const*) {}
+    void external_event(double*, double, std::list<PinValue> const &) {}
+    void confluent_event(double*, bool const*, std::list<PinValue> const &) {}
+    void output_func(double const*, bool const*, std::list<PinValue> &) {}
+    int calls;
+
+  private:
+    bool const jacobian;
+};
+
+/**
+ * A stiff system with an entry of its Jacobian that is zero at
+ * the initial state, and so missing from the detected pattern
+ *
+ * dx0/dt = x1 - x0
+ * dx1/dt = -100 (x1 - x0^2)
+ */
+class hidden : public ode_system {
+  public:
+    hidden() : ode_system(2, 0) {}
+    void init(double* q) {
+        q[0] = 0.0;
+        q[1] = 1.0;
+    }
+    void der_func(double const* q, double* dq) {
+        dq[0] = q[1] - q[0];
+        dq[1] = -100.0 * (q[1] - q[0] * q[0]);
+    }
+    void state_event_func(double const*, double*) {}
+    double time_event_func(double const*) { return DBL_MAX; }
+    void internal_event(double*, bool const*) {}
+    void external_event(double*, double, std::list<PinValue> const &) {}
+    void confluent_event(double*, bool const*, std::list<PinValue> const &) {}
+    void output_func(double const*, bool const*, std::list<PinValue> &) {}
+};
+
+// dx/dt = mode where a time event at t = 1 changes the mode from 1 to -1
+// without changing the state; the clock is the second variable
+class switched : public ode_system {
+  public:
+    switched() : ode_system(2, 0), mode(1.0) {}
+    void init(double* q) {
+        q[0] = 0.0;
+        q[1] = 0.0;
+    }
+    void der_func(double const*, double* dq) {
+        dq[0] = mode;
+        dq[1] = 1.0;
+    }
+    void state_event_func(double const*, double*) {}
+    double time_event_func(double const* q) { return (mode > 0.0) ? 1.0 - q[1] : DBL_MAX; }
+    void internal_event(double*, bool const*) { mode = -1.0; }
+    void external_event(double*, double, std::list<PinValue> const &) {}
+    void confluent_event(double*, bool const*, std::list<PinValue> const &) {}
+    void output_func(double const*, bool const*, std::list<PinValue> &) {}
+    double mode;
+};
+
+// A ball that falls from a height of one with an acceleration of two
+class ball : public ode_system {
+  public:
+    ball() : ode_system(2, 1) {}
+    void init(double* q) {
+        q[0] = 1.0;
+        q[1] = 0.0;
+    }
+    void der_func(double const* q, double* dq) {
+        dq[0] = q[1];
+        dq[1] = -2.0;
+    }
+    // Bounce when falling through the floor
+    void state_event_func(double const* q, double* z) { z[0] = (q[1] < 0.0) ? q[0] : 1.0; }
+    double time_event_func(double const*) { return DBL_MAX; }
+    void internal_event(double* q, bool const* event) {
+        if (event[0]) {
+            q[1] = -q[1];
+        }
+    }
+    void external_event(double*, double, std::list<PinValue> const &) {}
+    void confluent_event(double* q, bool const* event, std::list<PinValue> const &) {
+        internal_event(q, event);
+    }
+    void output_func(double const* q, bool const* event, std::list<PinValue> &yb) {
+        if (event[0]) {
+            yb.push_back(PinValue(bounce, q[0]));
+        }
+    }
+    pin_t const bounce;
+};
+
+// Records the times of the bounces
+class recorder : public Atomic {
+  public:
+    recorder() : Atomic(), t(0.0) {}
+    double ta() { return adevs_inf<double>(); }
+    void delta_int() {}
+    void delta_ext(double e, std::list<PinValue> const &) {
+        t += e;
+        times.push_back(t);
+    }
+    void delta_conf(std::list<PinValue> const &) {}
+    void output_func(std::list<PinValue> &) {}
+    double t;
+    std::vector<double> times;
+};
+
+// The stiff system is solved accurately with few derivative calls,
+// with or without a Jacobian
+void test1(bool jacobian) {
+    stiff ref_sys(false), bdf_sys(jacobian);
+    adevs::dormand_prince<double> ref_solver(&ref_sys, 1E-10, 1.0);
+    bdf solver(&bdf_sys, 1E-6, 10.0);
+    double q_ref[2], q[2];
+    ref_sys.init(q_ref);
+    bdf_sys.init(q);
+    ref_solver.advance(q_ref, 500.0);
+    solver.advance(q, 500.0);
+    std::cerr << "dopri: " << ref_sys.calls << " bdf: " << bdf_sys.calls << std::endl;
+    assert(fabs(q[0] - q_ref[0]) < 1E-3);
+    assert(fabs(q[1] - q_ref[1]) < 1E-3);
+    assert(20 * bdf_sys.calls < ref_sys.calls);
+}
+
+// Dense output inside of a step and restarts from a new state
+void test2() {
+    stiff sys(true);
+    bdf solver(&sys, 1E-8, 1.0);
+    double q[2], q_mid[2];
+    sys.init(q);
+    solver.advance(q, 1.0);
+    double q0[2] = {q[0], q[1]};
+    double h = solver.integrate(q, 1.0);
+    assert(h > 0.0 && h <= 1.0);
+    // The ends of the step
+    assert(solver.interpolate(q_mid, 0.0));
+    assert(fabs(q_mid[0] - q0[0]) < 1E-8 && fabs(q_mid[1] - q0[1]) < 1E-8);
+    assert(solver.interpolate(q_mid, h));
+    assert(fabs(q_mid[0] - q[0]) < 1E-8 && fabs(q_mid[1] - q[1]) < 1E-8);
+    // Starting from the middle of the step gives the same solution
+    // as continuing from its end
+    double q_end[2] = {q[0], q[1]};
+    assert(solver.interpolate(q_mid, h / 2.0));
+    solver.advance(q_end, 1.0);
+    solver.advance(q_mid, 1.0 + h / 2.0);
+    assert(fabs(q_mid[0] - q_end[0]) < 1E-5 && fabs(q_mid[1] - q_end[1]) < 1E-5);
+}
+
+// A bouncing ball simulated with the StiffHybrid
+void test3() {
+    ball* sys = new ball();
+    auto model = std::make_shared<adevs::StiffHybrid<double>>(sys, 1E-8, 0.1);
+    auto rec = std::make_shared<recorder>();
+    auto graph = std::make_shared<Graph>();
+    graph->add_atomic(model);
+    graph->add_atomic(rec);
+    graph->connect(sys->bounce, rec);
+    Simulator sim(graph);
+    while (sim.nextEventTime() <= 6.0) {
+        sim.execNextEvent();
+    }
+    // The ball lands at t = 1 and then bounces every 2 seconds
+    assert(rec->times.size() == 3);
+    for (int i = 0; i < 3; i++) {
+        assert(fabs(rec->times[i] - (1.0 + 2.0 * i)) < 1E-5);
+    }
+}
+
+// The solution is accurate when the detected pattern is missing an entry
+void test4() {
+    hidden ref_sys, bdf_sys;
+    adevs::dormand_prince<double> ref_solver(&ref_sys, 1E-10, 0.01);
+    bdf solver(&bdf_sys, 1E-8, 1.0);
+    double q_ref[2], q[2];
+    ref_sys.init(q_ref);
+    bdf_sys.init(q);
+    for (int i = 0; i < 10; i++) {
+        ref_solver.advance(q_ref, 1.0);
+        solver.advance(q, 1.0);
+        assert(fabs(q[0] - q_ref[0]) < 1E-5);
+        assert(fabs(q[1] - q_ref[1]) < 1E-5);
+    }
+}
+
+// A discrete event that changes der_func() but not the state
+// starts CVODE again instead of using the history of the old mode
+void test5() {
+    switched* sys = new switched();
+    auto model = std::make_shared<adevs::StiffHybrid<double>>(sys, 1E-6, 1.0);
+    auto graph = std::make_shared<Graph>();
+    graph->add_atomic(model);
+    Simulator sim(graph);
+    while (sim.nextEventTime() <= 4.0) {
+        sim.execNextEvent();
+        double const t = model->getState(1);
+        double const x = (t <= 1.0) ? t : 2.0 - t;
+        assert(fabs(model->getState(0) - x) < 1E-6);
+    }
+    assert(sys->mode < 0.0);
+}
+
+int main() {
+    test1(true);
+    test1(false);
+    test2();
+    test3();
+    test4();
+    test5();
+    return 0;
+}
@@ -0,0 +1,149 @@
+/**
+ * Test cases for the column coloring of sparsity patterns and the
+ * colored finite difference Jacobian.
+ */
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include "adevs/adevs.h"
+
+using PinValue = adevs::PinValue<int>;
+using ode_system = adevs::ode_system<int>;
+using colored_jacobian = adevs::colored_jacobian<int>;
+using sparsity_pattern = adevs::sparsity_pattern;
+
+/**
+ * A nonlinear chain in which each derivative reads its neighbors
+ *
+ * dx[i]/dt = x[i-1]^2 - 2 x[i] + sin(x[i+1])
+ */
+class chain : public ode_system {
+  public:
+    chain(int N) : ode_system(N, 0), calls(0) {}
+    void init(double* q) {
+        for (int i = 0; i < numVars(); i++) {
+            q[i] = 0.1 * (i + 1);
+        }
+    }
+    void der_func(double const* q, double* dq) {
+        calls++;
+        int const N = numVars();
+        for (int i = 0; i < N; i++) {
+            dq[i] = -2.0 * q[i];
+            if (i > 0) {
+                dq[i] += q[i - 1] * q[i - 1];
+            }
+            if (i < N - 1) {
+                dq[i] += sin(q[i + 1]);
+            }
+        }
+    }
+    // Exact entry (i,j) of the Jacobian
+    double jacobian(double const* q, int i, int j) {
+        if (i == j) {
+            return -2.0;
+        } else if (j == i - 1) {
+            return 2.0 * q[j];
+        } else if (j == i + 1) {
+            return cos(q[j]);
+        }
+        return 0.0;
+    }
+    sparsity_pattern get_sparsity() {
+        std::vector<std::pair<int, int>> entries;
+        for (int i = 0; i < numVars(); i++) {
+            for (int j = std::max(0, i - 1); j <= std::min(numVars() - 1, i + 1); j++) {
+                entries.push_back(std::make_pair(i, j));
+            }
+        }
+        return sparsity_pattern(numVars(), numVars(), entries);
+    }
+    void state_event_func(double const*, double*) {}
+    double time_event_func(double const*) { return DBL_MAX; }
+    void internal_event(double*, bool const*) {}
+    void external_event(double*, double, std::list<PinValue> const &) {}
+    void confluent_event(double*, bool const*, std::list<PinValue> const &) {}
+    void output_func(double const*, bool const*, std::list<PinValue> &) {}
+    int calls;
+};
+
+// No two columns with the same color may share a row
+void check_coloring(sparsity_pattern const &p, std::vector<int> const &color) {
+    assert(static_cast<int>(color.size()) == p.cols());
+    for (int i = 0; i < p.rows(); i++) {
+        for (int k = p.row_start()[i]; k < p.row_start()[i + 1]; k++) {
+            for (int kk = k + 1; kk < p.row_start()[i + 1]; kk++) {
+                assert(color[p.col_index()[k]] != color[p.col_index()[kk]]);
+            }
+        }
+    }
+}
+
+// A tridiagonal pattern needs three colors and a full row needs one for each column
+void test1() {
+    int const N = 100;
+    chain sys(N);
+    sparsity_pattern tri = sys.get_sparsity();
+    std::vector<int> color = tri.color_columns();
+    check_coloring(tri, color);
+    assert(*std::max_element(color.begin(), color.end()) == 2);
+    std::vector<std::pair<int, int>> entries;
+    for (int i = 0; i < N; i++) {
+        entries.push_back(std::make_pair(i, i));
+        entries.push_back(std::make_pair(0, i));
+    }
+    sparsity_pattern arrow(N, N, entries);
+    color = arrow.color_columns();
+    check_coloring(arrow, color);
+    assert(*std::max_element(color.begin(), color.end()) == N - 1);
+    // Transposed, the full row becomes a full column that shares
+    // a row with each of the others
+    color = arrow.transpose().color_columns();
+    check_coloring(arrow.transpose(), color);
+    assert(*std::max_element(color.begin(), color.end()) == 1);
+}
+
+// The colored Jacobian matches the exact one at the cost of four calls
+void test2() {
+    int const N = 1000;
+    chain sys(N);
+    std::vector<double> q(N);
+    sys.init(q.data());
+    colored_jacobian jac(&sys, sys.get_sparsity());
+    assert(jac.num_colors() == 3);
+    std::vector<double> values(jac.pattern().nnz());
+    sys.calls = 0;
+    jac.evaluate(q.data(), values.data());
+    assert(sys.calls == 4);
+    sparsity_pattern const &p = jac.pattern();
+    for (int i = 0; i < N; i++) {
+        for (int k = p.row_start()[i]; k < p.row_start()[i + 1]; k++) {
+            double const exact = sys.jacobian(q.data(), i, p.col_index()[k]);
+            assert(fabs(values[k] - exact) < 1E-5);
+        }
+    }
+}
+
+// The detected pattern is the declared one
+void test3() {
+    int const N = 50;
+    chain sys(N);
+    std::vector<double> q(N);
+    sys.init(q.data());
+    sparsity_pattern found = colored_jacobian::detect(&sys, q.data());
+    sparsity_pattern declared = sys.get_sparsity();
+    assert(found.nnz() == declared.nnz());
+    for (int i = 0; i <= N; i++) {
+        assert(found.row_start()[i] == declared.row_start()[i]);
+    }
+    for (int k = 0; k < found.nnz(); k++) {
+        assert(found.col_index()[k] == declared.col_index()[k]);
+    }
+}
+
+int main() {
+    test1();
+    test2();
+    test3();
+    return 0;
+}
@@ -0,0 +1,202 @@
+/**
+ * Test cases for the Dormand-Prince integrator.
+ */
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include "adevs/adevs.h"
+
+using ode_system = adevs::ode_system<double>;
+using PinValue = adevs::PinValue<double>;
+
+// A damped oscillator that counts calls to der_func
+class oscillator : public ode_system {
+  public:
+    oscillator(int events = 0) : ode_system(2, events), calls(0) {}
+    void init(double* q) {
+        q[0] = 1.0;
+        q[1] = 0.0;
+    }
+    void der_func(double const* q, double* dq) {
+        calls++;
+        dq[0] = q[1];
+        dq[1] = -q[0] - 0.1 * q[1];
+    }
+    void state_event_func(double const* q, double* z) {
+        if (numEvents() > 0) {
+            z[0] = q[0];
+        }
+    }
+    double time_event_func(double const*) { return DBL_MAX; }
+    void internal_event(double*, bool const*) {}
+    void external_event(double*, double, std::list<PinValue> const &) {}
+    void confluent_event(double*, bool const*, std::list<PinValue> const &) {}
+    void output_func(double const*, bool const*, std::list<PinValue> &) {}
+    // Exact solution for the position
+    static double x(double t) {
+        double const w = sqrt(1.0 - 0.0025);
+        return exp(-0.05 * t) * (cos(w * t) + (0.05 / w) * sin(w * t));
+    }
+    int calls;
+};
+
+// Integrate to t = 20 with the supplied solver and return the number of der_func calls
+template <class Solver>
+int run(double tol, double* x) {
+    oscillator sys;
+    Solver solver(&sys, tol, 1.0);
+    sys.init(x);
+    double t = 0.0;
+    while (t < 20.0) {
+        t += solver.integrate(x, 20.0 - t);
+    }
+    assert(fabs(t - 20.0) < 1E-12);
+    return sys.calls;
+}
+
+// The solution is accurate and costs fewer derivative evaluations than rk_45
+void test1() {
+    double q[2];
+    int dp = run<adevs::dormand_prince<double>>(1E-8, q);
+    assert(fabs(q[0] - oscillator::x(20.0)) < 1E-6);
+    int rk = run<adevs::rk_45<double>>(1E-8, q);
+    assert(fabs(q[0] - oscillator::x(20.0)) < 1E-6);
+    std::cerr << "dormand_prince: " << dp << " rk_45: " << rk << std::endl;
+    assert(dp < rk);
+}
+
+// The dense output matches the solution inside a step and at its end points
+void test2() {
+    oscillator sys;
+    adevs::dormand_prince<double> solver(&sys, 1E-8, 0.5);
+    double q[2], p[2];
+    sys.init(q);
+    double t = 0.0;
+    while (t < 10.0) {
+        double h = solver.integrate(q, 10.0 - t);
+        int calls = sys.calls;
+        for (int i = 0; i <= 10; i++) {
+            solver.interpolate(p, 0.1 * i * h);
+            assert(fabs(p[0] - oscillator::x(t + 0.1 * i * h)) < 1E-6);
+        }
+        solver.interpolate(p, h);
+        assert(fabs(p[0] - q[0]) < 1E-12);
+        assert(fabs(p[1] - q[1]) < 1E-12);
+        // The interpolant does not evaluate the derivative
+        assert(calls == sys.calls);
+        t += h;
+    }
+}
+
+// Each accepted step after the first reuses its first stage
+void test3() {
+    oscillator sys;
+    adevs::dormand_prince<double> solver(&sys, 1E-3, 0.1);
+    double q[2];
+    sys.init(q);
+    solver.integrate(q, 0.1);
+    assert(sys.calls == 7);
+    solver.integrate(q, 0.1);
+    assert(sys.calls == 13);
+    // Changing the state forces a new first stage
+    q[1] += 1.0;
+    solver.integrate(q, 0.1);
+    assert(sys.calls == 20);
+    // Advance reaches exactly the requested time
+    solver.advance(q, 0.05);
+    assert(sys.calls == 26);
+}
+
+// Event locators use the dense output instead of integrating again
+template <class Locator>
+void test4(bool must_find) {
+    oscillator sys(1);
+    adevs::dormand_prince<double> solver(&sys, 1E-8, 1.0);
+    Locator locator(&sys, 1E-9);
+    double q0[2], q1[2];
+    bool events[1];
+    sys.init(q1);
+    // Step until x crosses zero
+    double t = 0.0, h = 0.0;
+    do {
+        t += h;
+        q0[0] = q1[0];
+        q0[1] = q1[1];
+        h = solver.integrate(q1, 1.0);
+    } while (q1[0] > 0.0);
+    int calls = sys.calls;
+    // The locator may stop short of the event at a state that has not crossed it
+    bool found = locator.find_events(events, q0, q1, &solver, h);
+    assert(found || !must_find);
+    assert(!found || events[0]);
+    assert(calls == sys.calls);
+    // Compare with the root of the exact solution
+    double lo = t, hi = t + 1.0;
+    while (hi - lo > 1E-12) {
+        double mid = 0.5 * (lo + hi);
+        if (oscillator::x(mid) > 0.0) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    if (found) {
+        assert(fabs(t + h - lo) < 1E-6);
+        assert(fabs(q1[0]) < 1E-6);
+    } else {
+        assert(t + h < lo);
+        assert(fabs(q1[0] - oscillator::x(t + h)) < 1E-6);
+    }
+}
+
+// dx/dt = mode where a time event at t = 1 changes the mode from 1 to -1
+// without changing the state; the clock is the second variable
+class switched : public ode_system {
+  public:
+    switched() : ode_system(2, 0), mode(1.0) {}
+    void init(double* q) {
+        q[0] = 0.0;
+        q[1] = 0.0;
+    }
+    void der_func(double const*, double* dq) {
+        dq[0] = mode;
+        dq[1] = 1.0;
+    }
+    void state_event_func(double const*, double*) {}
+    double time_event_func(double const* q) { return (mode > 0.0) ? 1.0 - q[1] : DBL_MAX; }
+    void internal_event(double*, bool const*) { mode = -1.0; }
+    void external_event(double*, double, std::list<PinValue> const &) {}
+    void confluent_event(double*, bool const*, std::list<PinValue> const &) {}
+    void output_func(double const*, bool const*, std::list<PinValue> &) {}
+    double mode;
+};
+
+// A discrete event that changes der_func() but not the state is not
+// followed by a step that reuses the derivative of the old mode
+void test5() {
+    switched* sys = new switched();
+    auto model = std::make_shared<adevs::Hybrid<double>>(
+        sys, new adevs::dormand_prince<double>(sys, 1E-4, 1.0),
+        new adevs::bisection_event_locator<double>(sys, 1E-4));
+    auto graph = std::make_shared<adevs::Graph<double>>();
+    graph->add_atomic(model);
+    adevs::Simulator<double> sim(graph);
+    while (sim.nextEventTime() <= 4.0) {
+        sim.execNextEvent();
+        double const t = model->getState(1);
+        double const x = (t <= 1.0) ? t : 2.0 - t;
+        assert(fabs(model->getState(0) - x) < 1E-8);
+    }
+    assert(sys->mode < 0.0);
+}
+
+int main() {
+    test1();
+    test2();
+    test3();
+    test4<adevs::bisection_event_locator<double>>(false);
+    test4<adevs::linear_event_locator<double>>(false);
+    test4<adevs::fast_event_locator<double>>(true);
+    test5();
+    return 0;
+}
@@ -0,0 +1,104 @@
+/**
+ * Test cases for the Illinois event locator.
+ */
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include "adevs/adevs.h"
+
+using ode_system = adevs::ode_system<double>;
+using PinValue = adevs::PinValue<double>;
+
+// Uniform motion with several event surfaces that counts calls to state_event_func
+class mover : public ode_system {
+  public:
+    mover() : ode_system(2, 3), calls(0) {}
+    void init(double* q) {
+        q[0] = 0.0;
+        q[1] = 0.0;
+    }
+    void der_func(double const*, double* dq) {
+        dq[0] = 1.0;
+        dq[1] = 1.0;
+    }
+    // Crossings at t = 0.7, t = 0.3 and t = 0.5
+    void state_event_func(double const* q, double* z) {
+        calls++;
+        z[0] = q[0] * q[0] - 0.49;
+        z[1] = 0.3 - q[1];
+        z[2] = exp(q[0]) - exp(0.5);
+    }
+    double time_event_func(double const*) { return DBL_MAX; }
+    void internal_event(double*, bool const*) {}
+    void external_event(double*, double, std::list<PinValue> const &) {}
+    void confluent_event(double*, bool const*, std::list<PinValue> const &) {}
+    void output_func(double const*, bool const*, std::list<PinValue> &) {}
+    int calls;
+};
+
+// Locate the first event in a single step of size one and return the
+// number of calls to state_event_func
+template <class Locator>
+int locate(ode_system* sys, double* q, bool* events, double &h) {
+    adevs::dormand_prince<double> solver(sys, 1E-8, 1.0);
+    Locator locator(sys, 1E-10);
+    double q0[2];
+    sys->init(q0);
+    sys->init(q);
+    h = solver.integrate(q, 1.0);
+    assert(h == 1.0);
+    assert(locator.find_events(events, q0, q, &solver, h));
+    return dynamic_cast<mover*>(sys)->calls;
+}
+
+// The earliest of several crossings is found
+void test1() {
+    mover sys;
+    double q[2], h;
+    bool events[3];
+    int calls = locate<adevs::illinois_event_locator<double>>(&sys, q, events, h);
+    assert(fabs(h - 0.3) < 1E-10);
+    assert(h >= 0.3);
+    assert(fabs(q[1] - h) < 1E-12);
+    assert(!events[0] && events[1] && !events[2]);
+    mover sys2;
+    int bisect = locate<adevs::fast_event_locator<double>>(&sys2, q, events, h);
+    std::cerr << "illinois: " << calls << " bisection: " << bisect << std::endl;
+    assert(calls < bisect);
+}
+
+// Nonlinear event functions converge from both sides of the bracket
+void test2() {
+    mover sys;
+    adevs::dormand_prince<double> solver(&sys, 1E-8, 1.0);
+    adevs::illinois_event_locator<double> locator(&sys, 1E-12);
+    bool events[3];
+    // Start past the first crossing
+    double q0[2] = {0.4, 0.4}, q[2] = {0.4, 0.4};
+    double h = solver.integrate(q, 0.6);
+    assert(locator.find_events(events, q0, q, &solver, h));
+    assert(fabs(0.4 + h - 0.5) < 1E-12);
+    assert(!events[0] && !events[1] && events[2]);
+    assert(sys.calls < 15);
+}
+
+// No crossing leaves the step alone
+void test3() {
+    mover sys;
+    adevs::dormand_prince<double> solver(&sys, 1E-8, 1.0);
+    adevs::illinois_event_locator<double> locator(&sys, 1E-12);
+    bool events[3];
+    double q0[2] = {0.0, 0.0}, q[2] = {0.0, 0.0};
+    double h = solver.integrate(q, 0.2);
+    assert(!locator.find_events(events, q0, q, &solver, h));
+    assert(h == 0.2);
+    assert(fabs(q[0] - 0.2) < 1E-12);
+    assert(sys.calls == 2);
+}
+
+int main() {
+    test1();
+    test2();
+    test3();
+    return 0;
+}
@@ -0,0 +1,119 @@
+/**
+ * Test cases for keeping the tentative step of a Hybrid model
+ * through inputs that do not change its trajectory.
+ */
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include "adevs/adevs.h"
+
+using Atomic = adevs::Atomic<double>;
+using Graph = adevs::Graph<double>;
+using Hybrid = adevs::Hybrid<double>;
+using PinValue = adevs::PinValue<double>;
+using Simulator = adevs::Simulator<double>;
+using ode_system = adevs::ode_system<double>;
+using pin_t = adevs::pin_t;
+
+// Produces an input at a fixed interval
+class pulse : public Atomic {
+  public:
+    pulse(double dt) : Atomic(), dt(dt) {}
+    double ta() { return dt; }
+    void delta_int() {}
+    void delta_ext(double, std::list<PinValue> const &) {}
+    void delta_conf(std::list<PinValue> const &) {}
+    void output_func(std::list<PinValue> &yb) { yb.push_back(PinValue(output, 1.0)); }
+    pin_t const output;
+
+  private:
+    double const dt;
+};
+
+// A damped oscillator with its zero crossings as state events. Inputs
+// are counted and, optionally, kick the position.
+class oscillator : public ode_system {
+  public:
+    oscillator(bool keep, double kick)
+        : ode_system(3, 1), calls(0), inputs(0), keep(keep), kick(kick) {}
+    void init(double* q) {
+        q[0] = 1.0;
+        q[1] = 0.0;
+        q[2] = 0.0;
+    }
+    void der_func(double const* q, double* dq) {
+        calls++;
+        dq[0] = q[1];
+        dq[1] = -4.0 * q[0] - 0.1 * q[1];
+        dq[2] = 1.0;
+    }
+    void state_event_func(double const* q, double* z) { z[0] = q[0]; }
+    double time_event_func(double const*) { return DBL_MAX; }
+    void internal_event(double* q, bool const* event) {
+        assert(event[0]);
+        crossings.push_back(q[2]);
+    }
+    void external_event(double* q, double, std::list<PinValue> const &xb) {
+        inputs += xb.size();
+        if (inputs % 1000 == 0) {
+            q[0] += kick;
+        }
+    }
+    void confluent_event(double* q, bool const* event, std::list<PinValue> const &xb) {
+        internal_event(q, event);
+        external_event(q, 0.0, xb);
+    }
+    void output_func(double const*, bool const*, std::list<PinValue> &) {}
+    bool preserves_trajectory() { return keep; }
+    int calls, inputs;
+    std::vector<double> crossings;
+
+  private:
+    bool const keep;
+    double const kick;
+};
+
+// Simulate for five seconds with inputs at 10 kHz and return the final state
+std::shared_ptr<Hybrid> run(oscillator* sys) {
+    auto model = std::make_shared<Hybrid>(sys, new adevs::dormand_prince<double>(sys, 1E-8, 0.1),
+                                          new adevs::illinois_event_locator<double>(sys, 1E-9));
+    auto src = std::make_shared<pulse>(1E-4);
+    auto graph = std::make_shared<Graph>();
+    graph->add_atomic(model);
+    graph->add_atomic(src);
+    graph->connect(src->output, model);
+    Simulator sim(graph);
+    while (sim.nextEventTime() <= 5.0) {
+        sim.execNextEvent();
+    }
+    return model;
+}
+
+void compare(double kick) {
+    oscillator* eager = new oscillator(false, kick);
+    oscillator* lazy = new oscillator(true, kick);
+    auto a = run(eager);
+    auto b = run(lazy);
+    assert(eager->inputs == lazy->inputs);
+    assert(eager->inputs > 49000);
+    assert(eager->crossings.size() == lazy->crossings.size());
+    assert(eager->crossings.size() > 0);
+    for (unsigned i = 0; i < eager->crossings.size(); i++) {
+        assert(fabs(eager->crossings[i] - lazy->crossings[i]) < 1E-6);
+    }
+    for (int i = 0; i < 3; i++) {
+        assert(fabs(a->getState(i) - b->getState(i)) < 1E-6);
+    }
+    std::cerr << "kick " << kick << " eager: " << eager->calls << " lazy: " << lazy->calls
+              << std::endl;
+    assert(10 * lazy->calls < eager->calls);
+}
+
+int main() {
+    // Inputs that leave the trajectory alone
+    compare(0.0);
+    // Inputs that sometimes change the state must start a new step
+    compare(0.1);
+    return 0;
+}
@@ -0,0 +1,128 @@
+/**
+ * Test cases for the LIQSS solvers on a stiff system.
+ */
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include "adevs/adevs.h"
+
+using Atomic = adevs::Atomic<double>;
+using Graph = adevs::Graph<double>;
+using PinValue = adevs::PinValue<double>;
+using Simulator = adevs::Simulator<double>;
+using QSS = adevs::QSS<double>;
+using ode_system = adevs::ode_system<double>;
+using pin_t = adevs::pin_t;
+
+pin_t const stop;
+
+/**
+ * The stiff system
+ *
+ * dx0/dt = 0.01 x1
+ * dx1/dt = -100 x0 - 100 x1 + 2020
+ *
+ * with eigenvalues near -0.01 and -100.
+ */
+class stiff : public ode_system {
+  public:
+    stiff(bool jacobian) : ode_system(2, 0), calls(0), jacobian(jacobian) {}
+    void init(double* q) {
+        q[0] = 0.0;
+        q[1] = 20.0;
+    }
+    void der_func(double const* q, double* dq) {
+        dq[0] = 0.01 * q[1];
+        dq[1] = -100.0 * q[0] - 100.0 * q[1] + 2020.0;
+    }
+    double der_func_component(double const* q, int i) {
+        calls++;
+        return (i == 0) ? 0.01 * q[1] : -100.0 * q[0] - 100.0 * q[1] + 2020.0;
+    }
+    bool get_jacobian_diagonal(double const*, int i, double &J_ii) {
+        J_ii = (i == 0) ? 0.0 : -100.0;
+        return jacobian;
+    }
+    void state_event_func(double const*, double*) {}
+    double time_event_func(double const*) { return DBL_MAX; }
+    void internal_event(double*, bool const*) {}
+    void external_event(double*, double, std::list<PinValue> const &) {}
+    bool preserves_trajectory() { return true; }
+    void confluent_event(double*, bool const*, std::list<PinValue> const &) {}
+    void output_func(double const*, bool const*, std::list<PinValue> &) {}
+    int calls;
+
+  private:
+    bool const jacobian;
+};
+
+// Sends an input at a fixed time so that the state can be checked then
+class timer : public Atomic {
+  public:
+    timer(double t_end) : Atomic(), t_end(t_end) {}
+    double ta() { return t_end; }
+    void delta_int() { t_end = adevs_inf<double>(); }
+    void delta_ext(double, std::list<PinValue> const &) {}
+    void delta_conf(std::list<PinValue> const &) {}
+    void output_func(std::list<PinValue> &yb) { yb.push_back(PinValue(stop, 0.0)); }
+
+  private:
+    double t_end;
+};
+
+double const t_end = 500.0;
+
+// Simulate with the given method and return the number of updates
+unsigned long long run(QSS::Method method, bool jacobian, double* x) {
+    stiff* sys = new stiff(jacobian);
+    auto model = std::make_shared<QSS>(sys, method, 1E-3, 1E-3);
+    auto src = std::make_shared<timer>(t_end);
+    auto graph = std::make_shared<Graph>();
+    graph->add_atomic(model);
+    graph->add_atomic(src);
+    graph->connect(stop, model);
+    Simulator sim(graph);
+    while (sim.nextEventTime() <= t_end) {
+        sim.execNextEvent();
+    }
+    x[0] = model->getState(0);
+    x[1] = model->getState(1);
+    return model->get_updates();
+}
+
+int main() {
+    // Reference solution
+    stiff ref_sys(false);
+    adevs::dormand_prince<double> solver(&ref_sys, 1E-10, 1E-3);
+    double ref[2];
+    ref_sys.init(ref);
+    solver.advance(ref, t_end);
+    double x[2];
+    unsigned long long qss1 = run(QSS::QSS1, false, x);
+    assert(fabs(x[0] - ref[0]) < 0.1);
+    unsigned long long qss2 = run(QSS::QSS2, false, x);
+    assert(fabs(x[0] - ref[0]) < 0.1);
+    // The implicit methods are accurate and take far fewer steps
+    unsigned long long liqss1 = run(QSS::LIQSS1, false, x);
+    assert(fabs(x[0] - ref[0]) < 0.1);
+    assert(fabs(x[1] - ref[1]) < 0.02);
+    unsigned long long liqss1_jac = run(QSS::LIQSS1, true, x);
+    assert(fabs(x[0] - ref[0]) < 0.1);
+    assert(fabs(x[1] - ref[1]) < 0.02);
+    unsigned long long liqss2 = run(QSS::LIQSS2, false, x);
+    assert(fabs(x[0] - ref[0]) < 0.1);
+    assert(fabs(x[1] - ref[1]) < 0.02);
+    unsigned long long liqss2_jac = run(QSS::LIQSS2, true, x);
+    assert(fabs(x[0] - ref[0]) < 0.1);
+    assert(fabs(x[1] - ref[1]) < 0.02);
+    std::cerr << "QSS1 " << qss1 << " QSS2 " << qss2 << " LIQSS1 " << liqss1 << " "
+              << liqss1_jac << " LIQSS2 " << liqss2 << " " << liqss2_jac << std::endl;
+    // The slow variable limits LIQSS1 while LIQSS2 follows it with few steps
+    assert(3 * liqss1 < qss1);
+    assert(100 * liqss2 < qss2);
+    assert(liqss2 < liqss1);
+    // The approximate Jacobian diagonal gives the same result
+    assert(liqss1 == liqss1_jac);
+    assert(liqss2 <= liqss2_jac + 10 && liqss2_jac <= liqss2 + 10);
+    return 0;
+}
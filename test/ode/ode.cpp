@@ -76,6 +76,156 @@ class lk_system : public ode_system {
     }
 };
 
+/**
+ * A chain of linear systems with a tridiagonal Jacobian. The
+ * Jacobian is given as a sparse matrix or as a dense matrix.
+ */
+class chain_system : public ode_system {
+  private:
+    bool const sparse;
+
+  public:
+    chain_system(int N, bool sparse) : ode_system(N, 0), sparse(sparse) {}
+    void init(double* q) {
+        for (int i = 0; i < numVars(); i++) {
+            q[i] = (i == 0) ? 1.0 : 0.0;
+        }
+    }
+    void der_func(double const* q, double* dq) {
+        int const N = numVars();
+        for (int i = 0; i < N; i++) {
+            dq[i] = -2.0 * q[i];
+            if (i > 0) {
+                dq[i] += q[i - 1];
+            }
+            if (i < N - 1) {
+                dq[i] += q[i + 1];
+            }
+        }
+    }
+    void state_event_func(double const*, double*) {}
+    double time_event_func(double const*) { return adevs_inf<double>(); }
+    void internal_event(double*, bool const*) {}
+    void external_event(double*, double, std::list<PinValue> const &) {}
+    void confluent_event(double*, bool const*, std::list<PinValue> const &) {}
+    void output_func(double const*, bool const*, std::list<PinValue> &) {}
+
+    adevs::sparsity_pattern get_sparsity() {
+        if (!sparse) {
+            return adevs::sparsity_pattern();
+        }
+        std::vector<std::pair<int, int>> entries;
+        for (int i = 0; i < numVars(); i++) {
+            for (int j = std::max(0, i - 1); j <= std::min(numVars() - 1, i + 1); j++) {
+                entries.push_back(std::make_pair(i, j));
+            }
+        }
+        return adevs::sparsity_pattern(numVars(), numVars(), entries);
+    }
+
+    bool get_sparse_jacobian(double const*, double* values) {
+        if (!sparse) {
+            return false;
+        }
+        if (values == nullptr) {
+            return true;
+        }
+        int k = 0;
+        for (int i = 0; i < numVars(); i++) {
+            for (int j = std::max(0, i - 1); j <= std::min(numVars() - 1, i + 1); j++) {
+                values[k++] = (i == j) ? -2.0 : 1.0;
+            }
+        }
+        return true;
+    }
+
+    bool get_jacobian(double const*, double* J) {
+        if (sparse) {
+            return false;
+        }
+        if (J == nullptr) {
+            return true;
+        }
+        int const N = numVars();
+        for (int i = 0; i < N * N; i++) {
+            J[i] = 0.0;
+        }
+        for (int i = 0; i < N; i++) {
+            J[i * (N + 1)] = -2.0;
+            if (i > 0) {
+                J[(i - 1) * N + i] = 1.0;
+            }
+            if (i < N - 1) {
+                J[(i + 1) * N + i] = 1.0;
+            }
+        }
+        return true;
+    }
+};
+
+// The chain without a Jacobian or sparsity pattern
+class detected_chain_system : public chain_system {
+  public:
+    detected_chain_system(int N) : chain_system(N, false) {}
+    bool get_jacobian(double const*, double*) { return false; }
+};
+
+// The band, dense, and approximated Jacobians must give the same solution
+void test_sparse(int N, double tend) {
+    chain_system* band_sys = new chain_system(N, true);
+    chain_system* dense_sys = new chain_system(N, false);
+    chain_system* detected_sys = new detected_chain_system(N);
+    trap* band_solver = new trap(band_sys, 1E-6, 0.1);
+    trap* dense_solver = new trap(dense_sys, 1E-6, 0.1);
+    trap* detected_solver = new trap(detected_sys, 1E-6, 0.1);
+    double* q_band = new double[N];
+    double* q_dense = new double[N];
+    double* q_detected = new double[N];
+    band_sys->init(q_band);
+    dense_sys->init(q_dense);
+    detected_sys->init(q_detected);
+    for (double t = 0.0; t < tend; t += 0.1) {
+        band_solver->advance(q_band, 0.1);
+        dense_solver->advance(q_dense, 0.1);
+        detected_solver->advance(q_detected, 0.1);
+        for (int i = 0; i < N; i++) {
+            assert(fabs(q_band[i] - q_dense[i]) < 1E-8);
+            assert(fabs(q_detected[i] - q_dense[i]) < 1E-6);
+        }
+    }
+    delete[] q_band;
+    delete[] q_dense;
+    delete[] q_detected;
+    delete band_solver;
+    delete dense_solver;
+    delete detected_solver;
+    delete band_sys;
+    delete dense_sys;
+    delete detected_sys;
+}
+
+// Reusing the Jacobian must not change the solution
+void test_newton(double tend) {
+    lk_system* sys = new lk_system();
+    trap* full = new trap(sys, 1E-6, 0.1);
+    trap* simplified = new trap(sys, 1E-6, 0.1);
+    full->set_newton(trap::FULL);
+    simplified->set_newton(trap::SIMPLIFIED);
+    double q_full[2], q_simplified[2];
+    sys->init(q_full);
+    sys->init(q_simplified);
+    for (double t = 0.0; t < tend; t += 0.1) {
+        full->advance(q_full, 0.1);
+        simplified->advance(q_simplified, 0.1);
+        for (int i = 0; i < 2; i++) {
+            assert(fabs(q_full[i] - q_simplified[i]) < 1E-4);
+        }
+    }
+    assert(simplified->get_jacobian_evaluations() < full->get_jacobian_evaluations());
+    delete full;
+    delete simplified;
+    delete sys;
+}
 
 void test(ode_system* sys, double tend) {
     double* q_trap = new double[sys->numVars()];
@@ -106,5 +256,7 @@ void test(ode_system* sys, double tend) {
 int main() {
     test(new lk_system(), 50.0);
     test(new simple_system(), 50.0);
+    test_sparse(50, 10.0);
+    test_newton(50.0);
     return 0;
 }
@@ -0,0 +1,280 @@
+/**
+ * Test cases for the QSS solvers.
+ */
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include "adevs/adevs.h"
+
+using Atomic = adevs::Atomic<double>;
+using Graph = adevs::Graph<double>;
+using PinValue = adevs::PinValue<double>;
+using Simulator = adevs::Simulator<double>;
+using QSS = adevs::QSS<double>;
+using ode_system = adevs::ode_system<double>;
+using sparsity_pattern = adevs::sparsity_pattern;
+using pin_t = adevs::pin_t;
+
+// Base class for systems without discrete events
+class continuous : public ode_system {
+  public:
+    continuous(int N, int M = 0) : ode_system(N, M), calls(0) {}
+    void der_func(double const* q, double* dq) {
+        for (int i = 0; i < numVars(); i++) {
+            dq[i] = der_func_component(q, i);
+        }
+    }
+    void state_event_func(double const*, double*) {}
+    double time_event_func(double const*) { return DBL_MAX; }
+    void internal_event(double*, bool const*) {}
+    void external_event(double*, double, std::list<PinValue> const &) {}
+    void confluent_event(double*, bool const*, std::list<PinValue> const &) {}
+    void output_func(double const*, bool const*, std::list<PinValue> &) {}
+    int calls;
+};
+
+// Harmonic oscillator x'' = -x
+class oscillator : public continuous {
+  public:
+    oscillator() : continuous(2) {}
+    void init(double* q) {
+        q[0] = 1.0;
+        q[1] = 0.0;
+    }
+    double der_func_component(double const* q, int i) {
+        calls++;
+        return (i == 0) ? q[1] : -q[0];
+    }
+};
+
+// A long chain of first order lags dx[i]/dt = x[i-1] - x[i] that
+// is at rest except for its first variable
+class chain : public continuous {
+  public:
+    chain(int N) : continuous(N) {}
+    void init(double* q) {
+        for (int i = 0; i < numVars(); i++) {
+            q[i] = 0.0;
+        }
+        q[0] = 1.0;
+    }
+    double der_func_component(double const* q, int i) {
+        calls++;
+        return (i == 0) ? -q[0] : q[i - 1] - q[i];
+    }
+    // The input that ends the run does not disturb the chain
+    bool preserves_trajectory() { return true; }
+    static sparsity_pattern pattern(int N) {
+        std::vector<std::pair<int, int>> entries;
+        for (int i = 0; i < N; i++) {
+            entries.push_back(std::make_pair(i, i));
+            if (i > 0) {
+                entries.push_back(std::make_pair(i, i - 1));
+            }
+        }
+        return sparsity_pattern(N, N, entries);
+    }
+};
+
+pin_t const stop;
+
+// Sends an input at a fixed time so that the state can be checked then
+class timer : public Atomic {
+  public:
+    timer(double t_end) : Atomic(), t_end(t_end) {}
+    double ta() { return t_end; }
+    void delta_int() { t_end = adevs_inf<double>(); }
+    void delta_ext(double, std::list<PinValue> const &) {}
+    void delta_conf(std::list<PinValue> const &) {}
+    void output_func(std::list<PinValue> &yb) { yb.push_back(PinValue(stop, 0.0)); }
+
+  private:
+    double t_end;
+};
+
+void run(Atomic* model, double t_end) {
+    auto graph = std::make_shared<Graph>();
+    std::shared_ptr<Atomic> ptr(model, [](Atomic*) {});
+    auto src = std::make_shared<timer>(t_end);
+    graph->add_atomic(ptr);
+    graph->add_atomic(src);
+    graph->connect(stop, ptr);
+    Simulator sim(graph);
+    while (sim.nextEventTime() <= t_end) {
+        sim.execNextEvent();
+    }
+}
+
+// Sparsity patterns in compressed row format
+void test1() {
+    sparsity_pattern p = chain::pattern(4);
+    assert(p.rows() == 4 && p.cols() == 4 && p.nnz() == 7);
+    int const start[5] = {0, 1, 3, 5, 7};
+    int const col[7] = {0, 0, 1, 1, 2, 2, 3};
+    for (int i = 0; i < 5; i++) {
+        assert(p.row_start()[i] == start[i]);
+    }
+    for (int i = 0; i < 7; i++) {
+        assert(p.col_index()[i] == col[i]);
+    }
+    sparsity_pattern t = p.transpose();
+    int const tcol[7] = {0, 1, 1, 2, 2, 3, 3};
+    for (int i = 0; i < 7; i++) {
+        assert(t.col_index()[i] == tcol[i]);
+    }
+    assert(sparsity_pattern::dense(3, 2).nnz() == 6);
+    bool thrown = false;
+    try {
+        sparsity_pattern(2, 2, {{0, 2}});
+    } catch (adevs::exception const &) {
+        thrown = true;
+    }
+    assert(thrown);
+}
+
+// Each method is accurate and higher orders take fewer steps
+void test2() {
+    QSS::Method methods[3] = {QSS::QSS1, QSS::QSS2, QSS::QSS3};
+    double const tol[3] = {1E-4, 1E-5, 1E-5};
+    double const err[3] = {1E-2, 1E-3, 1E-3};
+    unsigned long long steps[3];
+    for (int k = 0; k < 3; k++) {
+        oscillator* sys = new oscillator();
+        QSS model(sys, methods[k], tol[k], 0.0);
+        run(&model, 10.0);
+        double t = 10.0;
+        assert(fabs(model.getState(0) - cos(t)) < err[k]);
+        assert(fabs(model.getState(1) + sin(t)) < err[k]);
+        steps[k] = model.get_updates();
+        std::cerr << "QSS" << k + 1 << " " << steps[k] << std::endl;
+    }
+    assert(steps[1] < steps[0]);
+    assert(steps[2] < steps[1]);
+}
+
+// Only the active part of a long chain is updated
+void test3() {
+    int const N = 100000;
+    chain* sys = new chain(N);
+    QSS model(sys, QSS::QSS2, 1E-4, 1E-3, chain::pattern(N));
+    int init_calls = sys->calls;
+    run(&model, 5.0);
+    double x0 = model.getState(0), x1 = model.getState(1);
+    assert(fabs(x0 - exp(-5.0)) < 1E-3);
+    assert(fabs(x1 - 5.0 * exp(-5.0)) < 1E-3);
+    assert(model.getState(N - 1) == 0.0);
+    // Each update evaluates at most two derivatives three times each
+    assert(sys->calls - init_calls <= 6 * (int)model.get_updates());
+    assert(model.get_updates() < 10000);
+    std::cerr << "chain updates " << model.get_updates() << std::endl;
+}
+
+pin_t const lift;
+
+// A bouncing ball with dh/dt = v, dv/dt = -2, a time event to sample
+// the height, and input that raises the ball
+class ball : public continuous {
+  public:
+    ball() : continuous(2, 1), samples(0) {}
+    void init(double* q) {
+        q[0] = 1.0;
+        q[1] = 0.0;
+    }
+    double der_func_component(double const* q, int i) { return (i == 0) ? q[1] : -2.0; }
+    // Bounce when falling through the floor
+    void state_event_func(double const* q, double* z) { z[0] = (q[1] < 0.0) ? q[0] : 1.0; }
+    double time_event_func(double const*) { return 0.25; }
+    void internal_event(double* q, bool const* event) {
+        if (event[0]) {
+            q[1] = -q[1];
+        }
+        if (event[1]) {
+            samples++;
+        }
+    }
+    void external_event(double* q, double, std::list<PinValue> const &) { q[0] += 1.0; }
+    void confluent_event(double* q, bool const* event, std::list<PinValue> const &xb) {
+        internal_event(q, event);
+        external_event(q, 0.0, xb);
+    }
+    void output_func(double const* q, bool const* event, std::list<PinValue> &yb) {
+        if (event[0]) {
+            yb.push_back(PinValue(bounce, q[0]));
+        }
+    }
+    pin_t const bounce;
+    int samples;
+};
+
+// Records the times of the bounces
+class recorder : public Atomic {
+  public:
+    recorder() : Atomic(), t(0.0) {}
+    double ta() { return adevs_inf<double>(); }
+    void delta_int() {}
+    void delta_ext(double e, std::list<PinValue> const &) {
+        t += e;
+        times.push_back(t);
+    }
+    void delta_conf(std::list<PinValue> const &) {}
+    void output_func(std::list<PinValue> &) {}
+    double t;
+    std::vector<double> times;
+};
+
+// Lifts the ball at t = 0.5
+class lifter : public Atomic {
+  public:
+    lifter() : Atomic(), done(false) {}
+    double ta() { return (done) ? adevs_inf<double>() : 0.5; }
+    void delta_int() { done = true; }
+    void delta_ext(double, std::list<PinValue> const &) {}
+    void delta_conf(std::list<PinValue> const &) {}
+    void output_func(std::list<PinValue> &yb) { yb.push_back(PinValue(lift, 1.0)); }
+
+  private:
+    bool done;
+};
+
+// State events, time events, and input with each method and locator
+template <class Locator>
+void test4(QSS::Method method) {
+    ball* sys = new ball();
+    double const quantum = (method == QSS::QSS1) ? 1E-4 : 1E-6;
+    auto model = std::make_shared<QSS>(sys, method, quantum, 0.0, sparsity_pattern(),
+                                       new Locator(sys, 1E-9));
+    auto rec = std::make_shared<recorder>();
+    auto src = std::make_shared<lifter>();
+    auto graph = std::make_shared<Graph>();
+    graph->add_atomic(model);
+    graph->add_atomic(rec);
+    graph->add_atomic(src);
+    graph->connect(sys->bounce, rec);
+    graph->connect(lift, model);
+    Simulator sim(graph);
+    while (sim.nextEventTime() <= 5.9) {
+        sim.execNextEvent();
+    }
+    // Lifted to 1.75 at t = 0.5 with v = -1, the ball first lands at
+    // t = sqrt(2) and then bounces every 2*sqrt(2) seconds
+    double const first = sqrt(2.0), period = 2.0 * sqrt(2.0);
+    double const tol = (method == QSS::QSS1) ? 1E-2 : 1E-4;
+    assert(rec->times.size() == 2);
+    assert(fabs(rec->times[0] - first) < tol);
+    assert(fabs(rec->times[1] - first - period) < tol);
+    // Samples are taken 0.25 after each discrete event: 5 before
+    // the first bounce, 11 between the bounces, and 6 after
+    assert(sys->samples == 22);
+}
+
+int main() {
+    test1();
+    test2();
+    test3();
+    test4<adevs::illinois_event_locator<double>>(QSS::QSS2);
+    test4<adevs::illinois_event_locator<double>>(QSS::QSS3);
+    test4<adevs::fast_event_locator<double>>(QSS::QSS3);
+    test4<adevs::fast_event_locator<double>>(QSS::QSS1);
+    return 0;
+}
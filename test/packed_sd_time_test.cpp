@@ -0,0 +1,128 @@
+/**
+ * Test cases for the packed super dense time type.
+ */
+#include <cassert>
+#include <random>
+#include <sstream>
+#include <vector>
+#include "adevs/adevs.h"
+
+using pin_t = adevs::pin_t;
+using PinValue = adevs::PinValue<int>;
+
+// Arithmetic is the same as for sd_time
+template <typename IntType>
+void test_arithmetic() {
+    using packed = adevs::packed_sd_time<IntType>;
+    assert(packed(0, 0) + packed(0, 0) == packed(0, 0));
+    assert(packed(0, 0) + packed(1, -1) == packed(1, -1));
+    assert(packed(1, 0) + packed(1, -1) == packed(2, -1));
+    assert(packed(1, 1) + packed(1, -1) == packed(2, -1));
+    assert(packed(1, 1) + packed(0, 4) == packed(1, 5));
+    assert(packed(5, 3) - packed(5, 1) == packed(0, 2));
+    assert(packed(5, 3) - packed(2, 7) == packed(3, 3));
+    assert(packed(-3, 2).real() == -3 && packed(-3, 2).integer() == 2);
+    assert(adevs_sentinel<packed>() < adevs_zero<packed>());
+    assert(adevs_zero<packed>() < adevs_epsilon<packed>());
+    assert(adevs_epsilon<packed>() < packed(1, std::numeric_limits<int>::min()));
+    assert(packed(std::numeric_limits<IntType>::max(), 0) < adevs_inf<packed>());
+    std::stringstream ss;
+    ss << packed(-7, 3);
+    packed t;
+    ss >> t;
+    assert(t == packed(-7, 3));
+}
+
+// Comparisons agree with sd_time
+template <typename IntType>
+void test_order() {
+    using packed = adevs::packed_sd_time<IntType>;
+    using plain = adevs::sd_time<IntType>;
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<IntType> real(-4, 4);
+    std::uniform_int_distribution<int> integer(-3, 3);
+    for (int i = 0; i < 10000; i++) {
+        IntType t1 = real(rng), t2 = real(rng);
+        int k1 = integer(rng), k2 = integer(rng);
+        if (i % 7 == 0) {
+            t1 = std::numeric_limits<IntType>::min() + k1 + 3;
+        } else if (i % 11 == 0) {
+            t2 = std::numeric_limits<IntType>::max() - k2 - 3;
+        }
+        packed a(t1, k1), b(t2, k2);
+        plain c(t1, k1), d(t2, k2);
+        assert((a < b) == (c < d));
+        assert((a <= b) == (c <= d));
+        assert((a > b) == (c > d));
+        assert((a >= b) == (c >= d));
+        assert((a == b) == (c == d));
+        assert((a != b) == (c != d));
+    }
+}
+
+// A model that produces events at increasing real and logical times
+template <typename TimeType>
+class Incr : public adevs::Atomic<int, TimeType> {
+  public:
+    Incr() : adevs::Atomic<int, TimeType>(), count(0) {}
+    TimeType ta() {
+        if (count >= 50) {
+            return adevs_inf<TimeType>();
+        }
+        return (count % 3 == 0) ? TimeType(count, 1) : TimeType(0, count);
+    }
+    void delta_int() { count++; }
+    void delta_ext(TimeType, std::list<PinValue> const &) {}
+    void delta_conf(std::list<PinValue> const &) {}
+    void output_func(std::list<PinValue> &yb) { yb.push_back(PinValue(output, count)); }
+    pin_t const output;
+    int count;
+};
+
+template <typename TimeType>
+class Trace : public adevs::EventListener<int, TimeType> {
+  public:
+    void inputEvent(adevs::Atomic<int, TimeType> &, PinValue &, TimeType) {}
+    void outputEvent(adevs::Atomic<int, TimeType> &, PinValue &y, TimeType t) {
+        times.push_back(std::make_pair(long(t.real()), int(t.integer())));
+        values.push_back(y.value);
+    }
+    void stateChange(adevs::Atomic<int, TimeType> &, TimeType) {}
+    std::vector<std::pair<long, int>> times;
+    std::vector<int> values;
+};
+
+template <typename TimeType>
+std::shared_ptr<Trace<TimeType>> run() {
+    auto graph = std::make_shared<adevs::Graph<int, TimeType>>();
+    for (int i = 0; i < 3; i++) {
+        graph->add_atomic(std::make_shared<Incr<TimeType>>());
+    }
+    auto trace = std::make_shared<Trace<TimeType>>();
+    adevs::Simulator<int, TimeType> sim(graph);
+    sim.addEventListener(trace);
+    while (sim.nextEventTime() < adevs_inf<TimeType>()) {
+        sim.execNextEvent();
+    }
+    return trace;
+}
+
+// The simulator gives the same trajectory as with sd_time
+void test_simulator() {
+    auto expect = run<adevs::sd_time<int>>();
+    auto packed = run<adevs::packed_sd_time<int>>();
+    auto wide = run<adevs::packed_sd_time<long long>>();
+    assert(expect->times.size() == 150);
+    assert(expect->times == packed->times && expect->values == packed->values);
+    assert(expect->times == wide->times && expect->values == wide->values);
+}
+
+int main() {
+    test_arithmetic<int>();
+    test_arithmetic<long>();
+    test_arithmetic<long long>();
+    test_order<int>();
+    test_order<long long>();
+    test_simulator();
+    return 0;
+}
@@ -0,0 +1,221 @@
+/**
+ * Test cases for the Partitioner.
+ */
+#include <cassert>
+#include <cstdio>
+#include <map>
+#include <vector>
+#include "adevs/adevs.h"
+
+using pin_t = adevs::pin_t;
+using Partitioner = adevs::Partitioner<int>;
+
+class Node : public adevs::Atomic<int> {
+  public:
+    Node(uint64_t id = 0) : adevs::Atomic<int>(), id(id) {}
+    double ta() { return adevs_inf<double>(); }
+    void delta_int() {}
+    void delta_ext(double, std::list<adevs::PinValue<int>> const &) {}
+    void delta_conf(std::list<adevs::PinValue<int>> const &) {}
+    void output_func(std::list<adevs::PinValue<int>> &) {}
+    uint64_t const id;
+    pin_t const output;
+};
+
+// Check that every model has a partition and return the weight of each
+std::vector<double> weights(Partitioner::partition_map const &part, adevs::Graph<int> const &graph,
+                            int parts, std::map<adevs::Atomic<int>*, double> const &w = {}) {
+    std::vector<double> result(parts, 0.0);
+    assert(part.size() == graph.get_atomics().size());
+    for (auto const &model : graph.get_atomics()) {
+        int p = part.at(model.get());
+        assert(p >= 0 && p < parts);
+        auto iter = w.find(model.get());
+        result[p] += (iter == w.end()) ? 1.0 : iter->second;
+    }
+    return result;
+}
+
+// A grid of cells that send to their four neighbors
+std::vector<std::shared_ptr<Node>> make_grid(adevs::Graph<int> &graph, Partitioner &partitioner,
+                                             int N) {
+    std::vector<std::shared_ptr<Node>> cells;
+    for (int i = 0; i < N * N; i++) {
+        cells.push_back(std::make_shared<Node>(i));
+        graph.add_atomic(cells.back());
+        partitioner.set_owner(cells.back()->output, cells.back());
+    }
+    for (int x = 0; x < N; x++) {
+        for (int y = 0; y < N; y++) {
+            auto &cell = cells[x * N + y];
+            if (x > 0) graph.connect(cell->output, cells[(x - 1) * N + y]);
+            if (x < N - 1) graph.connect(cell->output, cells[(x + 1) * N + y]);
+            if (y > 0) graph.connect(cell->output, cells[x * N + y - 1]);
+            if (y < N - 1) graph.connect(cell->output, cells[x * N + y + 1]);
+        }
+    }
+    return cells;
+}
+
+// A grid is split into balanced parts with a small cut
+void test1() {
+    int const N = 32, parts = 4;
+    adevs::Graph<int> graph;
+    Partitioner partitioner;
+    make_grid(graph, partitioner, N);
+    auto part = partitioner.partition(graph, parts);
+    for (double w : weights(part, graph, parts)) {
+        assert(w <= 1.05 * N * N / parts + 1.0);
+    }
+    // Quadrants cut 2N neighbor pairs, each with an edge in both directions,
+    // while a random assignment would cut about 3000.
+    assert(partitioner.get_cut() >= 4.0 * N);
+    assert(partitioner.get_cut() <= 3.0 * 4.0 * N);
+}
+
+// Two tightly connected groups joined by one edge are separated
+void test2() {
+    int const N = 50;
+    adevs::Graph<int> graph;
+    Partitioner partitioner;
+    std::vector<std::shared_ptr<Node>> group[2];
+    for (int g = 0; g < 2; g++) {
+        for (int i = 0; i < N; i++) {
+            group[g].push_back(std::make_shared<Node>());
+            graph.add_atomic(group[g].back());
+            partitioner.set_owner(group[g].back()->output, group[g].back());
+        }
+        for (int i = 0; i < N; i++) {
+            for (int j = 1; j <= 5; j++) {
+                graph.connect(group[g][i]->output, group[g][(i + j) % N]);
+            }
+        }
+    }
+    graph.connect(group[0][0]->output, group[1][0]);
+    auto part = partitioner.partition(graph, 2);
+    assert(partitioner.get_cut() == 1.0);
+    for (int g = 0; g < 2; g++) {
+        for (auto const &node : group[g]) {
+            assert(part[node.get()] == part[group[g][0].get()]);
+        }
+    }
+    assert(part[group[0][0].get()] != part[group[1][0].get()]);
+}
+
+// Measured weights change where the cut is made
+void test3() {
+    adevs::Graph<int> graph;
+    Partitioner partitioner;
+    std::vector<std::shared_ptr<Node>> chain;
+    for (int i = 0; i < 4; i++) {
+        chain.push_back(std::make_shared<Node>());
+        graph.add_atomic(chain.back());
+        partitioner.set_owner(chain.back()->output, chain.back());
+    }
+    for (int i = 0; i < 3; i++) {
+        graph.connect(chain[i]->output, chain[i + 1]);
+    }
+    partitioner.set_edge_weight(chain[0]->output, chain[1], 10.0);
+    partitioner.set_edge_weight(chain[2]->output, chain[3], 10.0);
+    auto part = partitioner.partition(graph, 2);
+    assert(partitioner.get_cut() == 1.0);
+    assert(part[chain[0].get()] == part[chain[1].get()]);
+    assert(part[chain[2].get()] == part[chain[3].get()]);
+    assert(part[chain[1].get()] != part[chain[2].get()]);
+    // A busy model gets a partition to itself
+    partitioner.set_model_weight(chain[0], 3.0);
+    part = partitioner.partition(graph, 2);
+    assert(partitioner.get_cut() == 10.0);
+    assert(part[chain[0].get()] != part[chain[1].get()]);
+    assert(part[chain[1].get()] == part[chain[2].get()]);
+    assert(part[chain[2].get()] == part[chain[3].get()]);
+}
+
+// The partition is saved and loaded with the topology
+void test4() {
+    int const N = 10, parts = 3;
+    adevs::Graph<int> graph;
+    Partitioner partitioner;
+    auto cells = make_grid(graph, partitioner, N);
+    std::map<pin_t, uint64_t> pin_ids;
+    for (auto const &cell : cells) {
+        pin_ids[cell->output] = cell->id;
+    }
+    auto part = partitioner.partition(graph, parts);
+    weights(part, graph, parts);
+    using Topology = adevs::Topology<int>;
+    Topology::save(
+        graph, "partition_test.bin",
+        [](std::shared_ptr<adevs::Atomic<int>> const &model) {
+            return Topology::model_info{std::dynamic_pointer_cast<Node>(model)->id, 0};
+        },
+        [&](pin_t pin) { return pin_ids.at(pin); }, &part);
+    adevs::Graph<int> loaded;
+    std::map<uint64_t, int> loaded_part;
+    std::map<uint64_t, pin_t> pins;
+    Topology::load(
+        loaded, "partition_test.bin", [](uint64_t id, uint32_t) { return std::make_shared<Node>(id); },
+        [&](uint64_t id) { return pins[id]; }, 1, &loaded_part);
+    assert(loaded_part.size() == cells.size());
+    for (auto const &cell : cells) {
+        assert(loaded_part.at(cell->id) == part.at(cell.get()));
+    }
+    std::remove("partition_test.bin");
+}
+
+// Trivial cases
+void test5() {
+    adevs::Graph<int> graph;
+    Partitioner partitioner;
+    assert(partitioner.partition(graph, 4).empty());
+    auto node = std::make_shared<Node>();
+    graph.add_atomic(node);
+    auto part = partitioner.partition(graph, 1);
+    assert(part.size() == 1 && part[node.get()] == 0);
+    part = partitioner.partition(graph, 4);
+    assert(part.size() == 1 && part[node.get()] >= 0 && part[node.get()] < 4);
+}
+
+// The same graph built twice gets the same partition when its models
+// are numbered in the order that they were added
+void test6() {
+    int const N = 16, parts = 4;
+    std::vector<std::map<uint64_t, int>> found;
+    for (int build = 0; build < 2; build++) {
+        adevs::Graph<int> graph;
+        Partitioner partitioner;
+        // Spread the models of the two graphs over different addresses
+        std::vector<std::shared_ptr<Node>> spacers(build * 100);
+        for (auto &spacer : spacers) {
+            spacer = std::make_shared<Node>();
+        }
+        auto cells = make_grid(graph, partitioner, N);
+        std::vector<std::shared_ptr<adevs::Atomic<int>>> order(cells.begin(), cells.end());
+        auto part = partitioner.partition(graph, parts, order);
+        weights(part, graph, parts);
+        found.emplace_back();
+        for (auto const &cell : cells) {
+            found.back()[cell->id] = part.at(cell.get());
+        }
+        // Each model must be listed once
+        order.pop_back();
+        bool caught = false;
+        try {
+            partitioner.partition(graph, parts, order);
+        } catch (adevs::exception const &) {
+            caught = true;
+        }
+        assert(caught);
+    }
+    assert(found[0] == found[1]);
+}
+
+int main() {
+    test1();
+    test2();
+    test3();
+    test4();
+    test5();
+    test6();
+    return 0;
+}
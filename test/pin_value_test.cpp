@@ -0,0 +1,147 @@
+/**
+ * Test cases for moving and sharing values as they are routed
+ * from a sender to its receivers.
+ */
+#include <cassert>
+#include <memory>
+#include <vector>
+#include "adevs/adevs.h"
+
+using pin_t = adevs::pin_t;
+
+// A value that counts how many times it was copied
+class Payload {
+  public:
+    static int copies;
+    Payload() : data(1000, 1) {}
+    Payload(Payload const &src) : data(src.data) { copies++; }
+    Payload(Payload &&src) = default;
+    Payload &operator=(Payload const &src) {
+        data = src.data;
+        copies++;
+        return *this;
+    }
+    Payload &operator=(Payload &&src) = default;
+    std::vector<int> data;
+};
+
+int Payload::copies = 0;
+
+template <typename ValueType>
+class Sender : public adevs::Atomic<ValueType> {
+  public:
+    Sender() : adevs::Atomic<ValueType>(), sent(false) {}
+    double ta() { return (sent) ? adevs_inf<double>() : 1.0; }
+    void delta_int() { sent = true; }
+    void delta_ext(double, std::list<adevs::PinValue<ValueType>> const &) {}
+    void delta_conf(std::list<adevs::PinValue<ValueType>> const &) {}
+    void output_func(std::list<adevs::PinValue<ValueType>> &yb) {
+        yb.push_back(adevs::PinValue<ValueType>(output, Payload()));
+    }
+    pin_t const output;
+
+  private:
+    bool sent;
+};
+
+template <typename ValueType>
+class Receiver : public adevs::Atomic<ValueType> {
+  public:
+    Receiver() : adevs::Atomic<ValueType>() {}
+    double ta() { return adevs_inf<double>(); }
+    void delta_int() {}
+    void delta_ext(double, std::list<adevs::PinValue<ValueType>> const &xb) {
+        for (auto const &x : xb) {
+            received.push_back(x.value);
+        }
+    }
+    void delta_conf(std::list<adevs::PinValue<ValueType>> const &xb) { delta_ext(0.0, xb); }
+    void output_func(std::list<adevs::PinValue<ValueType>> &) {}
+    std::list<ValueType> received;
+};
+
+// A single receiver should get the value without a copy
+void test1() {
+    auto graph = std::make_shared<adevs::Graph<Payload>>();
+    auto src = std::make_shared<Sender<Payload>>();
+    auto dst = std::make_shared<Receiver<Payload>>();
+    graph->add_atomic(src);
+    graph->add_atomic(dst);
+    graph->connect(src->output, dst);
+    adevs::Simulator<Payload> sim(graph);
+    Payload::copies = 0;
+    sim.computeNextOutput();
+    assert(Payload::copies == 0);
+    sim.computeNextState();
+    // This copy is made by the receiver
+    assert(Payload::copies == 1);
+    assert(dst->received.size() == 1);
+}
+
+// Each of N receivers gets a copy except for the last one
+void test2() {
+    int const N = 10;
+    auto graph = std::make_shared<adevs::Graph<Payload>>();
+    auto src = std::make_shared<Sender<Payload>>();
+    graph->add_atomic(src);
+    for (int i = 0; i < N; i++) {
+        auto dst = std::make_shared<Receiver<Payload>>();
+        graph->add_atomic(dst);
+        graph->connect(src->output, dst);
+    }
+    adevs::Simulator<Payload> sim(graph);
+    Payload::copies = 0;
+    sim.computeNextOutput();
+    assert(Payload::copies == N - 1);
+}
+
+// With a shared_value every receiver sees the same buffer
+void test3() {
+    using Shared = adevs::shared_value<Payload>;
+    int const N = 10;
+    auto graph = std::make_shared<adevs::Graph<Shared>>();
+    auto src = std::make_shared<Sender<Shared>>();
+    std::list<std::shared_ptr<Receiver<Shared>>> dst;
+    graph->add_atomic(src);
+    for (int i = 0; i < N; i++) {
+        dst.push_back(std::make_shared<Receiver<Shared>>());
+        graph->add_atomic(dst.back());
+        graph->connect(src->output, dst.back());
+    }
+    adevs::Simulator<Shared> sim(graph);
+    Payload::copies = 0;
+    sim.execNextEvent();
+    assert(Payload::copies == 0);
+    Payload const* buffer = &(dst.front()->received.front().get());
+    for (auto d : dst) {
+        assert(d->received.size() == 1);
+        assert(&(d->received.front().get()) == buffer);
+        assert(d->received.front()->data.size() == 1000);
+    }
+    assert(dst.front()->received.front().use_count() == N);
+}
+
+// Injected input can be moved into the simulator
+void test4() {
+    pin_t in;
+    auto graph = std::make_shared<adevs::Graph<Payload>>();
+    auto dst = std::make_shared<Receiver<Payload>>();
+    graph->add_atomic(dst);
+    graph->connect(in, dst);
+    adevs::Simulator<Payload> sim(graph);
+    Payload::copies = 0;
+    sim.setNextTime(1.0);
+    sim.injectInput(adevs::PinValue<Payload>(in, Payload()));
+    sim.computeNextOutput();
+    assert(Payload::copies == 0);
+    sim.computeNextState();
+    assert(dst->received.size() == 1);
+}
+
+int main() {
+    test1();
+    test2();
+    test3();
+    test4();
+    return 0;
+}
@@ -0,0 +1,108 @@
+/**
+ * Test cases for the run_until(), run_events(), and run_while()
+ * methods of the Simulator.
+ */
+#include <cassert>
+#include <chrono>
+#include <memory>
+#include "adevs/adevs.h"
+
+using PinValue = adevs::PinValue<int>;
+using pin_t = adevs::pin_t;
+using Simulator = adevs::Simulator<int>;
+using Atomic = adevs::Atomic<int>;
+using Graph = adevs::Graph<int>;
+
+// Produces an event every period until it has produced a limit
+class Clock : public Atomic {
+  public:
+    Clock(double period, int limit) : Atomic(), period(period), limit(limit), count(0) {}
+    double ta() { return (count < limit) ? period : adevs_inf<double>(); }
+    void delta_int() { count++; }
+    void delta_ext(double, std::list<PinValue> const &) {}
+    void delta_conf(std::list<PinValue> const &) {}
+    void output_func(std::list<PinValue> &yb) { yb.push_back(PinValue(output, count)); }
+    int get_count() const { return count; }
+    pin_t const output;
+
+  private:
+    double const period;
+    int const limit;
+    int count;
+};
+
+class Counter : public Atomic {
+  public:
+    Counter() : Atomic(), count(0) {}
+    double ta() { return adevs_inf<double>(); }
+    void delta_int() {}
+    void delta_ext(double, std::list<PinValue> const &xb) { count += xb.size(); }
+    void delta_conf(std::list<PinValue> const &xb) { delta_ext(0.0, xb); }
+    void output_func(std::list<PinValue> &) {}
+    int count;
+};
+
+// The events at and before the end time are executed
+void test1() {
+    auto graph = std::make_shared<Graph>();
+    auto clock = std::make_shared<Clock>(1.0, 10);
+    auto counter = std::make_shared<Counter>();
+    graph->add_atomic(clock);
+    graph->add_atomic(counter);
+    graph->connect(clock->output, counter);
+    Simulator sim(graph);
+    assert(sim.run_until(4.0) == 4);
+    assert(counter->count == 4);
+    assert(sim.nextEventTime() == 5.0);
+    assert(sim.run_until(4.5) == 0);
+    // Stops when there are no more events
+    assert(sim.run_until(100.0) == 6);
+    assert(counter->count == 10);
+    assert(sim.nextEventTime() == adevs_inf<double>());
+    assert(!sim.wall_clock_expired());
+}
+
+// A fixed number of events is executed
+void test2() {
+    auto clock = std::make_shared<Clock>(0.5, 10);
+    Simulator sim(clock);
+    assert(sim.run_events(3) == 3);
+    assert(clock->get_count() == 3);
+    assert(sim.run_events(100) == 7);
+    assert(sim.run_events(1) == 0);
+}
+
+// A predicate stops the run
+void test3() {
+    auto clock = std::make_shared<Clock>(1.0, 100);
+    Simulator sim(clock);
+    size_t n = sim.run_while([&clock](double t) { return t < 50.0 && clock->get_count() < 20; });
+    assert(n == 20);
+    assert(clock->get_count() == 20);
+    n = sim.run_while([](double t) { return t < 50.0; });
+    assert(n == 29);
+}
+
+// The wall clock limit stops the run between events
+void test4() {
+    auto clock = std::make_shared<Clock>(1.0, 1000);
+    Simulator sim(clock);
+    sim.set_wall_clock_limit(std::chrono::steady_clock::duration::zero());
+    size_t n = sim.run_events(1000);
+    assert(sim.wall_clock_expired());
+    assert(n > 0 && n < 1000);
+    assert(clock->get_count() == int(n));
+    assert(sim.nextEventTime() == double(n + 1));
+    // The run can be continued without a limit
+    sim.set_wall_clock_limit(std::chrono::steady_clock::duration::max());
+    assert(sim.run_events(1000) == 1000 - n);
+    assert(!sim.wall_clock_expired());
+}
+
+int main() {
+    test1();
+    test2();
+    test3();
+    test4();
+    return 0;
+}
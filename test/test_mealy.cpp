@@ -2,6 +2,7 @@
 #include <cmath>
 #include <iostream>
 #include <memory>
+#include <vector>
 #include "adevs/adevs.h"
 
 
@@ -274,6 +275,70 @@ void test7() {
     std::cout << "TEST 7 PASSED" << std::endl;
 }
 
+// A cycle of declared Mealy outputs is found when the simulator is created
+void test8() {
+    std::cout << "TEST 8" << std::endl;
+    bool except = false;
+    std::shared_ptr<Graph> model = std::make_shared<Graph>();
+    std::shared_ptr<Trigger> triggera = std::make_shared<Trigger>();
+    std::shared_ptr<Trigger> triggerb = std::make_shared<Trigger>();
+    model->add_atomic(triggera);
+    model->add_atomic(triggerb);
+    model->connect(triggera->output, triggerb);
+    model->connect(triggerb->output, triggera);
+    triggera->declare_output(triggera->output);
+    triggerb->declare_output(triggerb->output);
+    try {
+        Simulator sim(model);
+    } catch (adevs::exception const &) {
+        except = true;
+    }
+    assert(except);
+    std::cout << "TEST 8 PASSED" << std::endl;
+}
+
+// A long chain of Mealy models is evaluated in one pass. The chain
+// is added to the graph backwards and only half of the pins are
+// declared so that the rest must be found by the simulator.
+void test9() {
+    std::cout << "TEST 9" << std::endl;
+    int const N = 100;
+    std::shared_ptr<Graph> model = std::make_shared<Graph>();
+    std::shared_ptr<Periodic> periodic = std::make_shared<Periodic>(1.0);
+    std::shared_ptr<Receiver> rx = std::make_shared<Receiver>();
+    std::shared_ptr<Listener> listener = std::make_shared<Listener>();
+    std::vector<std::shared_ptr<Trigger>> chain;
+    for (int i = 0; i < N; i++) {
+        chain.push_back(std::make_shared<Trigger>());
+        if (i % 2 == 0) {
+            chain.back()->declare_output(chain.back()->output);
+        }
+    }
+    for (int i = N - 1; i >= 0; i--) {
+        model->add_atomic(chain[i]);
+        if (i > 0) {
+            model->connect(chain[i - 1]->output, chain[i]);
+        }
+    }
+    model->add_atomic(periodic);
+    model->add_atomic(rx);
+    model->connect(periodic->output, chain.front());
+    model->connect(chain.back()->output, rx);
+    Simulator sim(model);
+    sim.addEventListener(listener);
+    for (int k = 0; k < 2; k++) {
+        sim.execNextEvent();
+        assert(listener->output_count == N + 1);
+        assert(rx->get_event_count() == k + 1);
+        for (auto trigger : chain) {
+            assert(trigger->external_event_count() == k + 1);
+        }
+        listener->output_count = 0;
+        listener->value = -1;
+    }
+    std::cout << "TEST 9 PASSED" << std::endl;
+}
+
 int main() {
     test1();
     test2();
@@ -282,5 +347,7 @@ int main() {
     test5();
     test6();
     test7();
+    test8();
+    test9();
     return 0;
 }
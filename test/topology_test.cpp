@@ -0,0 +1,147 @@
+/**
+ * Test cases for saving a Graph to a file and loading it again.
+ */
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <set>
+#include <vector>
+#include "adevs/adevs.h"
+
+using pin_t = adevs::pin_t;
+using Topology = adevs::Topology<int>;
+
+class Node : public adevs::Atomic<int> {
+  public:
+    Node(uint64_t id, uint32_t tag) : adevs::Atomic<int>(), id(id), tag(tag) {}
+    double ta() { return adevs_inf<double>(); }
+    void delta_int() {}
+    void delta_ext(double, std::list<adevs::PinValue<int>> const &) {}
+    void delta_conf(std::list<adevs::PinValue<int>> const &) {}
+    void output_func(std::list<adevs::PinValue<int>> &) {}
+    uint64_t const id;
+    uint32_t const tag;
+};
+
+// The receivers of each pin described by identifiers
+using routes_t = std::map<uint64_t, std::multiset<uint64_t>>;
+
+routes_t routes(adevs::Graph<int> &graph, std::map<uint64_t, pin_t> const &pins) {
+    routes_t result;
+    for (auto const &p : pins) {
+        std::list<std::pair<pin_t, std::shared_ptr<adevs::Atomic<int>>>> dst;
+        graph.route(p.second, dst);
+        for (auto const &d : dst) {
+            result[p.first].insert(std::dynamic_pointer_cast<Node>(d.second)->id);
+        }
+    }
+    return result;
+}
+
+// Save a graph and load it back
+void test1() {
+    int const N = 100;
+    adevs::Graph<int> graph;
+    std::map<uint64_t, pin_t> pins;
+    std::map<pin_t, uint64_t> pin_ids;
+    std::vector<std::shared_ptr<Node>> nodes;
+    for (int i = 0; i < N; i++) {
+        nodes.push_back(std::make_shared<Node>(1000 + i, i % 3));
+        graph.add_atomic(nodes.back());
+    }
+    for (uint64_t i = 0; i < 2 * N; i++) {
+        pin_t pin;
+        pins[i] = pin;
+        pin_ids[pin] = i;
+    }
+    // Pins in the first half feed pins in the second half
+    for (int i = 0; i < N; i++) {
+        graph.connect(pins[i], pins[N + (i * 7) % N]);
+        graph.connect(pins[i], pins[N + (i * 13) % N]);
+        graph.connect(pins[N + i], nodes[i]);
+        graph.connect(pins[N + i], nodes[(i + 1) % N]);
+        graph.connect(pins[i], nodes[(i * 3) % N]);
+    }
+    // Duplicate edges and models must survive the trip
+    graph.connect(pins[0], nodes[5]);
+    graph.add_atomic(nodes[7]);
+    Topology::save(
+        graph, "topology_test.bin",
+        [](std::shared_ptr<adevs::Atomic<int>> const &model) {
+            auto node = std::dynamic_pointer_cast<Node>(model);
+            return Topology::model_info{node->id, node->tag};
+        },
+        [&](pin_t pin) { return pin_ids.at(pin); });
+    adevs::model_factory<int> factory;
+    int made = 0;
+    for (uint32_t tag = 0; tag < 3; tag++) {
+        factory.add_type(tag, [tag, &made](uint64_t id) {
+            made++;
+            return std::make_shared<Node>(id, tag);
+        });
+    }
+    adevs::Graph<int> loaded;
+    std::map<uint64_t, pin_t> new_pins;
+    auto models = Topology::load(loaded, "topology_test.bin", factory,
+                                 [&](uint64_t id) { return new_pins[id]; });
+    assert(made == N);
+    assert(models.size() == size_t(N));
+    assert(loaded.get_atomics().size() == size_t(N));
+    for (auto const &m : models) {
+        auto node = std::dynamic_pointer_cast<Node>(m.second);
+        assert(node->id == m.first);
+        assert(node->tag == (m.first - 1000) % 3);
+    }
+    assert(routes(graph, pins) == routes(loaded, new_pins));
+    // The duplicate model is removed only after two removals
+    loaded.remove_atomic(models[1007]);
+    assert(loaded.get_atomics().size() == size_t(N));
+    loaded.remove_atomic(models[1007]);
+    assert(loaded.get_atomics().size() == size_t(N - 1));
+    std::remove("topology_test.bin");
+}
+
+// Files that do not hold a topology are rejected
+void test2() {
+    {
+        std::ofstream out("topology_bad.bin", std::ios::binary);
+        out << "this is not a topology file at all, but it is long enough";
+    }
+    adevs::Graph<int> graph;
+    adevs::model_factory<int> factory;
+    bool caught = false;
+    try {
+        Topology::load(graph, "topology_bad.bin", factory, [](uint64_t) { return pin_t(); });
+    } catch (adevs::exception &) {
+        caught = true;
+    }
+    assert(caught);
+    caught = false;
+    try {
+        Topology::load(graph, "no_such_topology.bin", factory, [](uint64_t) { return pin_t(); });
+    } catch (adevs::exception &) {
+        caught = true;
+    }
+    assert(caught);
+    std::remove("topology_bad.bin");
+}
+
+// An unknown tag is an error
+void test3() {
+    adevs::model_factory<int> factory;
+    bool caught = false;
+    try {
+        factory(1, 99);
+    } catch (adevs::exception &) {
+        caught = true;
+    }
+    assert(caught);
+}
+
+int main() {
+    test1();
+    test2();
+    test3();
+    return 0;
+}